@@ -0,0 +1,203 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "libkwineffects/anidata_p.h"
+
+#include "abstract_client.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_animation_effect-0");
+
+class FadeScaleEffect : public AnimationEffect
+{
+    Q_OBJECT
+
+public:
+    using AnimationEffect::AniMap;
+    using AnimationEffect::cancel;
+    using AnimationEffect::state;
+
+    void fadeAndScale(EffectWindow *w, int duration)
+    {
+        animate(w, Opacity, 0, duration, FPx2(0.0), QEasingCurve::OutCubic);
+        animate(w, Scale, 0, duration, FPx2(0.8), QEasingCurve::OutCubic);
+    }
+};
+
+class AnimationEffectTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testConcurrentAnimations();
+    void benchmarkConcurrentAnimations();
+
+private:
+    void createWindows(int count);
+    FadeScaleEffect *loadEffect();
+
+    struct Window
+    {
+        KWayland::Client::Surface *surface;
+        Test::XdgToplevel *shellSurface;
+    };
+    QVector<Window> m_windows;
+};
+
+void AnimationEffectTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+}
+
+void AnimationEffectTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void AnimationEffectTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    for (const Window &window : qAsConst(m_windows)) {
+        delete window.shellSurface;
+        delete window.surface;
+    }
+    m_windows.clear();
+    Test::destroyWaylandConnection();
+}
+
+void AnimationEffectTest::createWindows(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        KWayland::Client::Surface *surface = Test::createSurface();
+        Test::XdgToplevel *shellSurface = Test::createXdgToplevelSurface(surface);
+        m_windows.append(Window{surface, shellSurface});
+        QVERIFY(Test::renderAndWaitForShown(surface, QSize(100, 50), Qt::blue));
+    }
+}
+
+FadeScaleEffect *AnimationEffectTest::loadEffect()
+{
+    // The handler takes the ownership of effects announced by its loader.
+    AbstractEffectLoader *loader = effects->findChild<AbstractEffectLoader *>();
+    if (!loader) {
+        return nullptr;
+    }
+    FadeScaleEffect *effect = new FadeScaleEffect();
+    Q_EMIT loader->effectLoaded(effect, QStringLiteral("fadescale"));
+    return effect;
+}
+
+void AnimationEffectTest::testConcurrentAnimations()
+{
+    // This test verifies that the animations of many windows are tracked per window and that
+    // cancelling them removes the windows again.
+    createWindows(20);
+    const EffectWindowList windows = effects->stackingOrder();
+    QVERIFY(windows.count() >= 20);
+
+    FadeScaleEffect *effect = loadEffect();
+    QVERIFY(effect);
+    for (EffectWindow *w : windows) {
+        effect->fadeAndScale(w, 100000);
+    }
+    QVERIFY(effect->isActive());
+
+    const FadeScaleEffect::AniMap state = effect->state();
+    QCOMPARE(state.count(), windows.count());
+    for (EffectWindow *w : windows) {
+        QCOMPARE(state.value(w).first.count(), 2);
+    }
+
+    QList<quint64> ids;
+    for (auto it = state.constBegin(); it != state.constEnd(); ++it) {
+        for (const AniData &anim : it.value().first) {
+            ids << anim.id;
+        }
+    }
+    for (quint64 id : qAsConst(ids)) {
+        QVERIFY(effect->cancel(id));
+    }
+    QVERIFY(effect->state().isEmpty());
+    QVERIFY(!effect->isActive());
+}
+
+void AnimationEffectTest::benchmarkConcurrentAnimations()
+{
+    // Fades and scales 200 windows at once, as when Present Windows is entered or when many
+    // windows are minimized together, and walks the painting hooks of the effect for them.
+    createWindows(200);
+    const EffectWindowList windows = effects->stackingOrder();
+    QVERIFY(windows.count() >= 200);
+
+    FadeScaleEffect *effect = loadEffect();
+    QVERIFY(effect);
+    for (EffectWindow *w : windows) {
+        // The animations must outlive the benchmark.
+        effect->fadeAndScale(w, 24 * 60 * 60 * 1000);
+    }
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    auto presentTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch());
+    QBENCHMARK {
+        presentTime += std::chrono::milliseconds(16);
+        effectsImpl->startPaint();
+        ScreenPrePaintData screenData;
+        screenData.mask = 0;
+        effects->prePaintScreen(screenData, presentTime);
+        for (EffectWindow *w : windows) {
+            WindowPrePaintData data;
+            data.mask = 0;
+            effects->prePaintWindow(w, data, presentTime);
+            effects->postPaintWindow(w);
+        }
+        effects->postPaintScreen();
+    }
+    QCOMPARE(effect->state().count(), windows.count());
+}
+
+WAYLANDTEST_MAIN(AnimationEffectTest)
+#include "animation_effect_test.moc"
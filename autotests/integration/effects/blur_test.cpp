@@ -0,0 +1,402 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "abstract_output.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "internal_client.h"
+#include "platform.h"
+#include "renderloop.h"
+#include "scene.h"
+#include "screens.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <kwinglplatform.h>
+#include <kwinglutils.h>
+
+#include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/surface.h>
+
+#include <QPainter>
+#include <QRasterWindow>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_blur-0");
+
+class BlurWindow : public QRasterWindow
+{
+    Q_OBJECT
+
+public:
+    BlurWindow()
+    {
+        setFlags(Qt::FramelessWindowHint);
+        setProperty("kwin_blur", QRegion());
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        Q_UNUSED(event)
+        QPainter p(this);
+        p.fillRect(0, 0, width(), height(), Qt::white);
+    }
+};
+
+// Counts the fragments that pass while a frame is painted.
+class SamplesPassedEffect : public Effect
+{
+    Q_OBJECT
+
+public:
+    ~SamplesPassedEffect() override
+    {
+        if (m_query) {
+            effects->makeOpenGLContextCurrent();
+            glDeleteQueries(1, &m_query);
+        }
+    }
+
+    void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override
+    {
+        if (!m_query) {
+            glGenQueries(1, &m_query);
+        }
+        glBeginQuery(GL_SAMPLES_PASSED, m_query);
+        effects->paintScreen(mask, region, data);
+        glEndQuery(GL_SAMPLES_PASSED);
+        glGetQueryObjectuiv(m_query, GL_QUERY_RESULT, &m_samples);
+    }
+
+    bool isActive() const override
+    {
+        return true;
+    }
+
+    GLuint samples() const
+    {
+        return m_samples;
+    }
+
+private:
+    GLuint m_query = 0;
+    GLuint m_samples = 0;
+};
+
+class BlurTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testCache();
+    void testPartial();
+    void testBackdrop();
+    void testContrast();
+};
+
+void BlurTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::InternalClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void BlurTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    if (!effectsImpl->loadEffect(QStringLiteral("blur"))) {
+        QSKIP("The blur effect is not supported");
+    }
+}
+
+void BlurTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    Test::destroyWaylandConnection();
+}
+
+static int paintFrame()
+{
+    RenderLoop *renderLoop = kwinApp()->platform()->enabledOutputs().constFirst()->renderLoop();
+    QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+    Compositor::self()->scene()->addRepaintFull();
+    if (!framePresentedSpy.wait()) {
+        return -1;
+    }
+    return GLStatistics::lastFrame(GLStatistics::DrawCalls);
+}
+
+static QImage grabFrame()
+{
+    // The frame is read back while it is still bound
+    QImage image(screens()->size(), QImage::Format_RGBA8888);
+    const QMetaObject::Connection connection = QObject::connect(Compositor::self()->scene(), &Scene::frameRendered, [&image]() {
+        glReadPixels(0, 0, image.width(), image.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+    });
+    const bool painted = paintFrame() > 0;
+    QObject::disconnect(connection);
+    return painted ? image.mirrored() : QImage();
+}
+
+static bool fuzzyCompare(const QImage &first, const QImage &second, const QRect &rect)
+{
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        for (int x = rect.left(); x <= rect.right(); ++x) {
+            const QRgb a = first.pixel(x, y);
+            const QRgb b = second.pixel(x, y);
+            if (qAbs(qRed(a) - qRed(b)) > 2 || qAbs(qGreen(a) - qGreen(b)) > 2 || qAbs(qBlue(a) - qBlue(b)) > 2) {
+                qWarning() << "The pixels at" << QPoint(x, y) << "differ:" << QColor(a) << QColor(b);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void BlurTest::testCache()
+{
+    // This test verifies that the background of a window is only blurred again when it changes.
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    AbstractClient *client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::internalClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    BlurWindow window;
+    window.setGeometry(0, 0, 1280, 1024);
+    window.setOpacity(0.5);
+    window.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 1);
+    InternalClient *internalClient = clientAddedSpy.first().first().value<InternalClient *>();
+    QVERIFY(internalClient);
+    workspace()->raiseClient(internalClient);
+
+    // Once the blur has been computed, the frames only draw the cached result.
+    QVERIFY(paintFrame() > 0);
+    const int cached = paintFrame();
+    QVERIFY(cached > 0);
+    QCOMPARE(paintFrame(), cached);
+
+    // Damage behind the blurred window has to be blurred again.
+    QSignalSpy damagedSpy(client, &Toplevel::damaged);
+    QVERIFY(damagedSpy.isValid());
+    Test::render(surface.data(), QSize(100, 50), Qt::red);
+    QVERIFY(damagedSpy.wait());
+    QVERIFY(paintFrame() > cached);
+    QCOMPARE(paintFrame(), cached);
+
+    // So do repaints of the window that don't come from its surface, e.g. of the decoration.
+    client->addRepaint(QRect(QPoint(0, 0), client->size()));
+    QVERIFY(paintFrame() > cached);
+    QCOMPARE(paintFrame(), cached);
+}
+
+void BlurTest::testPartial()
+{
+    // This test verifies that blurring only around the damage of a cached blur gives the same
+    // result as blurring everything again. The damaged window is away from the origin, so the
+    // damage has to be mapped to the right place on the screen.
+    QImage image(QSize(640, 512), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::blue);
+    QPainter painter(&image);
+    for (int x = 0; x < image.width(); x += 64) {
+        painter.fillRect(x, 0, 32, image.height(), Qt::yellow);
+    }
+
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    Test::render(surface.data(), image);
+    AbstractClient *client = Test::waitForWaylandWindowShown();
+    QVERIFY(client);
+    client->move(QPoint(320, 256));
+
+    // The blur passes draw as often for a part of the window as for all of it, so the
+    // fragments they shade tell whether only the part around the damage has been blurred.
+    SamplesPassedEffect *samplesPassed = nullptr;
+    if (!GLPlatform::instance()->isGLES()) {
+        AbstractEffectLoader *loader = effects->findChild<AbstractEffectLoader *>();
+        QVERIFY(loader);
+        samplesPassed = new SamplesPassedEffect();
+        Q_EMIT loader->effectLoaded(samplesPassed, QStringLiteral("samplespassed"));
+    }
+
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::internalClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    BlurWindow window;
+    window.setGeometry(QRect(QPoint(0, 0), screens()->size()));
+    window.setOpacity(0.5);
+    window.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 1);
+    InternalClient *internalClient = clientAddedSpy.first().first().value<InternalClient *>();
+    QVERIFY(internalClient);
+    workspace()->raiseClient(internalClient);
+
+    QVERIFY(paintFrame() > 0);
+    const QImage before = grabFrame();
+    QVERIFY(!before.isNull());
+
+    // Damage a small area in the middle of the window.
+    const QRect damage(300, 236, 40, 40);
+    painter.fillRect(damage, Qt::red);
+    painter.end();
+    QSignalSpy damagedSpy(client, &Toplevel::damaged);
+    QVERIFY(damagedSpy.isValid());
+    surface->attachBuffer(Test::waylandShmPool()->createBuffer(image));
+    surface->damage(damage);
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+    const QImage partial = grabFrame();
+    QVERIFY(!partial.isNull());
+    const QPoint center = damage.center() + client->clientPos() + client->pos();
+    QVERIFY(partial.pixel(center) != before.pixel(center));
+    const GLuint partialSamples = samplesPassed ? samplesPassed->samples() : 0;
+
+    // A change of the opacity makes everything to be blurred again.
+    window.setOpacity(0.6);
+    window.setOpacity(0.5);
+    const QImage full = grabFrame();
+    QVERIFY(!full.isNull());
+    if (samplesPassed) {
+        QVERIFY(partialSamples < samplesPassed->samples());
+    }
+
+    // The edges of the screen depend on what is outside of it, they are left out.
+    const QRect inner = QRect(QPoint(0, 0), screens()->size()).adjusted(160, 160, -160, -160);
+    QVERIFY(fuzzyCompare(partial, full, inner));
+}
+
+void BlurTest::testBackdrop()
+{
+    // This test verifies that the backdrop holds the grabbed parts of the framebuffer, that
+    // grabbing them again without drawing in between hands out the same copy and that they are
+    // copied again once the scene has drawn over them.
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    AbstractClient *client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+    client->move(QPoint(300, 200));
+
+    const QRect rect(250, 150, 200, 100);
+    QImage frame;
+    QImage backdrop;
+    bool shared = false;
+    bool copiedAgain = false;
+    const QMetaObject::Connection connection = QObject::connect(Compositor::self()->scene(), &Scene::frameRendered, [&]() {
+        frame = QImage(screens()->size(), QImage::Format_RGBA8888);
+        glReadPixels(0, 0, frame.width(), frame.height(), GL_RGBA, GL_UNSIGNED_BYTE, frame.bits());
+        GLTexture *texture = GLBackdrop::instance()->grab(rect);
+        if (texture) {
+            const int copies = GLStatistics::current(GLStatistics::BackdropCopies);
+            shared = GLBackdrop::instance()->grab(rect) == texture
+                && GLStatistics::current(GLStatistics::BackdropCopies) == copies;
+            backdrop = texture->toImage();
+            GLBackdrop::instance()->invalidate(client->frameGeometry());
+            copiedAgain = GLBackdrop::instance()->grab(rect) == texture
+                && GLStatistics::current(GLStatistics::BackdropCopies) > copies;
+        }
+    });
+    QVERIFY(paintFrame() > 0);
+    QObject::disconnect(connection);
+
+    QVERIFY(shared);
+    QVERIFY(copiedAgain);
+    QCOMPARE(backdrop.size(), frame.size());
+    const QImage expected = frame.mirrored().copy(rect).convertToFormat(QImage::Format_RGB32);
+    const QImage actual = backdrop.convertToFormat(QImage::Format_RGBA8888).mirrored().copy(rect).convertToFormat(QImage::Format_RGB32);
+    QCOMPARE(actual, expected);
+    QCOMPARE(QColor(actual.pixel(client->pos() - rect.topLeft() + QPoint(50, 25))), QColor(Qt::blue));
+}
+
+void BlurTest::testContrast()
+{
+    // This test verifies that the background contrast is applied on top of the blur when a
+    // window asks for both. The contrast doesn't change any colors, so the frame has to look
+    // the same as with the blur alone.
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    if (!effectsImpl->loadEffect(QStringLiteral("contrast"))) {
+        QSKIP("The background contrast effect is not supported");
+    }
+
+    QImage image(screens()->size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::blue);
+    QPainter painter(&image);
+    for (int x = 0; x < image.width(); x += 64) {
+        painter.fillRect(x, 0, 32, image.height(), Qt::yellow);
+    }
+    painter.end();
+
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    Test::render(surface.data(), image);
+    QVERIFY(Test::waitForWaylandWindowShown());
+
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::internalClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    BlurWindow window;
+    window.setGeometry(QRect(QPoint(0, 0), screens()->size()));
+    window.setOpacity(0.5);
+    window.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 1);
+    InternalClient *internalClient = clientAddedSpy.first().first().value<InternalClient *>();
+    QVERIFY(internalClient);
+    workspace()->raiseClient(internalClient);
+
+    QVERIFY(paintFrame() > 0);
+    const QImage blurred = grabFrame();
+    QVERIFY(!blurred.isNull());
+
+    window.setProperty("kwin_background_region", QRegion());
+    const QImage contrasted = grabFrame();
+    QVERIFY(!contrasted.isNull());
+
+    // The sharp edges of the stripes must not show through.
+    const QRect inner = QRect(QPoint(0, 0), screens()->size()).adjusted(160, 160, -160, -160);
+    QVERIFY(fuzzyCompare(contrasted, blurred, inner));
+}
+
+WAYLANDTEST_MAIN(BlurTest)
+#include "blur_test.moc"
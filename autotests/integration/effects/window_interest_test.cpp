@@ -0,0 +1,278 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "abstract_output.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "platform.h"
+#include "renderloop.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_window_interest-0");
+
+class CountingEffect : public Effect
+{
+    Q_OBJECT
+
+public:
+    explicit CountingEffect(bool selective)
+        : m_selective(selective)
+    {
+    }
+
+    bool declaresWindowInterest() const override
+    {
+        return m_selective;
+    }
+
+    void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime) override
+    {
+        ++m_calls[w];
+        effects->prePaintWindow(w, data, presentTime);
+    }
+
+    void paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data) override
+    {
+        ++m_calls[w];
+        effects->paintWindow(w, mask, region, data);
+    }
+
+    void postPaintWindow(EffectWindow *w) override
+    {
+        ++m_calls[w];
+        effects->postPaintWindow(w);
+    }
+
+    void drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data) override
+    {
+        ++m_calls[w];
+        effects->drawWindow(w, mask, region, data);
+    }
+
+    int calls(EffectWindow *w) const
+    {
+        return m_calls.value(w);
+    }
+
+    void reset()
+    {
+        m_calls.clear();
+    }
+
+private:
+    QHash<EffectWindow *, int> m_calls;
+    bool m_selective;
+};
+
+class WindowInterestTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testSkipsUninterestedEffects();
+    void testDeletedWindow();
+    void benchmarkWindowChain_data();
+    void benchmarkWindowChain();
+
+private:
+    AbstractClient *createWindow();
+    CountingEffect *loadEffect(const QString &name, bool selective);
+
+    struct Window
+    {
+        KWayland::Client::Surface *surface;
+        Test::XdgToplevel *shellSurface;
+    };
+    QVector<Window> m_windows;
+};
+
+void WindowInterestTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+}
+
+void WindowInterestTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void WindowInterestTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    for (const Window &window : qAsConst(m_windows)) {
+        delete window.shellSurface;
+        delete window.surface;
+    }
+    m_windows.clear();
+    Test::destroyWaylandConnection();
+}
+
+AbstractClient *WindowInterestTest::createWindow()
+{
+    KWayland::Client::Surface *surface = Test::createSurface();
+    Test::XdgToplevel *shellSurface = Test::createXdgToplevelSurface(surface);
+    m_windows.append(Window{surface, shellSurface});
+    return Test::renderAndWaitForShown(surface, QSize(100, 50), Qt::blue);
+}
+
+CountingEffect *WindowInterestTest::loadEffect(const QString &name, bool selective)
+{
+    // The handler takes the ownership of effects announced by its loader.
+    AbstractEffectLoader *loader = effects->findChild<AbstractEffectLoader *>();
+    if (!loader) {
+        return nullptr;
+    }
+    CountingEffect *effect = new CountingEffect(selective);
+    Q_EMIT loader->effectLoaded(effect, name);
+    return effect;
+}
+
+static bool paintFrame()
+{
+    RenderLoop *renderLoop = kwinApp()->platform()->enabledOutputs().constFirst()->renderLoop();
+    QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+    Compositor::self()->scene()->addRepaintFull();
+    return framePresentedSpy.wait();
+}
+
+void WindowInterestTest::testSkipsUninterestedEffects()
+{
+    // This test verifies that effects declaring their window interest are only called for the
+    // windows they have an interest in, while other effects are called for all windows.
+    AbstractClient *client1 = createWindow();
+    QVERIFY(client1);
+    AbstractClient *client2 = createWindow();
+    QVERIFY(client2);
+    EffectWindow *window1 = client1->effectWindow();
+    EffectWindow *window2 = client2->effectWindow();
+
+    CountingEffect *selective = loadEffect(QStringLiteral("selective"), true);
+    QVERIFY(selective);
+    CountingEffect *regular = loadEffect(QStringLiteral("regular"), false);
+    QVERIFY(regular);
+
+    effects->setWindowInterest(selective, window1, true);
+    QVERIFY(paintFrame());
+    QVERIFY(selective->calls(window1) > 0);
+    QCOMPARE(selective->calls(window2), 0);
+    QVERIFY(regular->calls(window1) > 0);
+    QCOMPARE(regular->calls(window2), regular->calls(window1));
+
+    selective->reset();
+    regular->reset();
+    effects->setWindowInterest(selective, window1, false);
+    effects->setWindowInterest(selective, window2, true);
+    QVERIFY(paintFrame());
+    QCOMPARE(selective->calls(window1), 0);
+    QVERIFY(selective->calls(window2) > 0);
+    QVERIFY(regular->calls(window1) > 0);
+}
+
+void WindowInterestTest::testDeletedWindow()
+{
+    // This test verifies that the interest in a window is dropped when the window is deleted.
+    AbstractClient *client = createWindow();
+    QVERIFY(client);
+    CountingEffect *selective = loadEffect(QStringLiteral("selective"), true);
+    QVERIFY(selective);
+    effects->setWindowInterest(selective, client->effectWindow(), true);
+
+    QSignalSpy windowDeletedSpy(effects, &EffectsHandler::windowDeleted);
+    QVERIFY(windowDeletedSpy.isValid());
+    const Window window = m_windows.takeLast();
+    delete window.shellSurface;
+    delete window.surface;
+    QVERIFY(windowDeletedSpy.wait());
+
+    // A new window that happens to get the same address must not inherit the interest.
+    AbstractClient *other = createWindow();
+    QVERIFY(other);
+    selective->reset();
+    QVERIFY(paintFrame());
+    QCOMPARE(selective->calls(other->effectWindow()), 0);
+}
+
+void WindowInterestTest::benchmarkWindowChain_data()
+{
+    QTest::addColumn<bool>("selective");
+
+    QTest::newRow("declared interest") << true;
+    QTest::newRow("all windows") << false;
+}
+
+void WindowInterestTest::benchmarkWindowChain()
+{
+    // Walks the window painting chain of 100 windows through 20 active effects. Each effect
+    // only touches one of the windows, as animation effects typically do.
+    QFETCH(bool, selective);
+
+    for (int i = 0; i < 100; ++i) {
+        QVERIFY(createWindow());
+    }
+    const EffectWindowList windows = effects->stackingOrder();
+    QVERIFY(windows.count() >= 100);
+
+    for (int i = 0; i < 20; ++i) {
+        CountingEffect *effect = loadEffect(QStringLiteral("counting%1").arg(i), selective);
+        QVERIFY(effect);
+        effects->setWindowInterest(effect, windows.at(i * 5), true);
+    }
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    QBENCHMARK {
+        effectsImpl->startPaint();
+        for (EffectWindow *w : windows) {
+            WindowPrePaintData data;
+            data.mask = 0;
+            effects->prePaintWindow(w, data, std::chrono::milliseconds::zero());
+            effects->postPaintWindow(w);
+        }
+    }
+}
+
+WAYLANDTEST_MAIN(WindowInterestTest)
+#include "window_interest_test.moc"
@@ -0,0 +1,170 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "main.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+
+#include <kwingltexture.h>
+#include <kwinglutils.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_gl_render_target_pool-0");
+
+class GLRenderTargetPoolTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testReuse();
+    void testMismatch();
+    void testAge();
+    void testBudget();
+
+private:
+    qint64 m_budget = 0;
+    int m_maximumAge = 0;
+};
+
+void GLRenderTargetPoolTest::initTestCase()
+{
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void GLRenderTargetPoolTest::init()
+{
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+
+    GLRenderTargetPool *pool = GLRenderTargetPool::instance();
+    m_budget = pool->budget();
+    m_maximumAge = pool->maximumAge();
+
+    // Start every test without released render targets.
+    pool->setBudget(0);
+    pool->beginFrame();
+    pool->setBudget(m_budget);
+}
+
+void GLRenderTargetPoolTest::cleanup()
+{
+    GLRenderTargetPool *pool = GLRenderTargetPool::instance();
+    pool->setBudget(m_budget);
+    pool->setMaximumAge(m_maximumAge);
+}
+
+void GLRenderTargetPoolTest::testReuse()
+{
+    // This test verifies that a released render target is handed out again.
+    GLRenderTargetPool *pool = GLRenderTargetPool::instance();
+
+    GLRenderTargetPool::Target *first = pool->acquire(QSize(123, 45));
+    QVERIFY(first);
+    QCOMPARE(first->texture()->size(), QSize(123, 45));
+    QVERIFY(first->renderTarget()->valid());
+
+    // A render target in use is never shared.
+    GLRenderTargetPool::Target *second = pool->acquire(QSize(123, 45));
+    QVERIFY(second);
+    QVERIFY(second != first);
+
+    const qint64 usage = pool->usage();
+    pool->release(first);
+    GLRenderTargetPool::Target *third = pool->acquire(QSize(123, 45));
+    QCOMPARE(third, first);
+    QCOMPARE(pool->usage(), usage);
+
+    pool->release(second);
+    pool->release(third);
+}
+
+void GLRenderTargetPoolTest::testMismatch()
+{
+    // This test verifies that render targets are only reused for the same size and format.
+    GLRenderTargetPool *pool = GLRenderTargetPool::instance();
+
+    GLRenderTargetPool::Target *first = pool->acquire(QSize(64, 64));
+    QVERIFY(first);
+    pool->release(first);
+
+    GLRenderTargetPool::Target *larger = pool->acquire(QSize(64, 65));
+    QVERIFY(larger);
+    QVERIFY(larger != first);
+    QCOMPARE(larger->texture()->size(), QSize(64, 65));
+
+    GLRenderTargetPool::Target *mipmapped = pool->acquire(QSize(64, 64), GL_RGBA8, 7);
+    QVERIFY(mipmapped);
+    QVERIFY(mipmapped != first);
+
+    pool->release(larger);
+    pool->release(mipmapped);
+}
+
+void GLRenderTargetPoolTest::testAge()
+{
+    // This test verifies that released render targets expire after some frames.
+    GLRenderTargetPool *pool = GLRenderTargetPool::instance();
+    pool->setMaximumAge(2);
+
+    GLRenderTargetPool::Target *target = pool->acquire(QSize(200, 100));
+    QVERIFY(target);
+    const qint64 usage = pool->usage();
+    pool->release(target);
+
+    pool->beginFrame();
+    pool->beginFrame();
+    QCOMPARE(pool->usage(), usage);
+
+    pool->beginFrame();
+    QCOMPARE(pool->usage(), usage - 200 * 100 * 4);
+}
+
+void GLRenderTargetPoolTest::testBudget()
+{
+    // This test verifies that the least recently used render targets are deleted first
+    // when the released render targets don't fit into the budget.
+    GLRenderTargetPool *pool = GLRenderTargetPool::instance();
+    const qint64 usage = pool->usage();
+
+    pool->setBudget(100 * 100 * 4);
+    GLRenderTargetPool::Target *first = pool->acquire(QSize(100, 100));
+    GLRenderTargetPool::Target *second = pool->acquire(QSize(100, 100));
+    QVERIFY(first);
+    QVERIFY(second);
+    QCOMPARE(pool->usage(), usage + 2 * 100 * 100 * 4);
+
+    pool->release(first);
+    pool->beginFrame();
+    pool->release(second);
+    pool->beginFrame();
+    QCOMPARE(pool->usage(), usage + 100 * 100 * 4);
+
+    GLRenderTargetPool::Target *third = pool->acquire(QSize(100, 100));
+    QCOMPARE(third, second);
+    pool->release(third);
+}
+
+WAYLANDTEST_MAIN(GLRenderTargetPoolTest)
+#include "gl_render_target_pool_test.moc"
@@ -0,0 +1,130 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "abstract_output.h"
+#include "composite.h"
+#include "main.h"
+#include "platform.h"
+#include "renderloop.h"
+#include "scene.h"
+#include "wayland_server.h"
+
+#include <kwingltexture.h>
+#include <kwinglutils.h>
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_gl_state-0");
+
+class GLStateTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testElide();
+    void testDeletedTexture();
+    void testFrame();
+};
+
+void GLStateTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void GLStateTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+}
+
+void GLStateTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void GLStateTest::testElide()
+{
+    // This test verifies that only changes of the state are sent to the driver.
+    const int issued = GLStatistics::current(GLStatistics::StateChanges);
+    const int elided = GLStatistics::current(GLStatistics::ElidedStateChanges);
+
+    GLState::enable(GL_BLEND);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::disable(GL_BLEND);
+    QCOMPARE(GLStatistics::current(GLStatistics::StateChanges), issued + 3);
+    QCOMPARE(GLStatistics::current(GLStatistics::ElidedStateChanges), elided + 2);
+    QVERIFY(GLState::validate());
+
+    // Nothing is known about the state after it has been invalidated.
+    GLState::invalidate();
+    GLState::disable(GL_BLEND);
+    QCOMPARE(GLStatistics::current(GLStatistics::StateChanges), issued + 4);
+    QVERIFY(GLState::validate());
+}
+
+void GLStateTest::testDeletedTexture()
+{
+    // This test verifies that a texture created with the name of a deleted texture gets bound.
+    QScopedPointer<GLTexture> texture(new GLTexture(GL_RGBA8, QSize(4, 4)));
+    const GLuint name = texture->texture();
+    GLState::bindTexture(GL_TEXTURE_2D, name);
+    texture.reset();
+    QVERIFY(GLState::validate());
+
+    texture.reset(new GLTexture(GL_RGBA8, QSize(4, 4)));
+    texture->bind();
+    GLint bound = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+    QCOMPARE(GLuint(bound), texture->texture());
+    texture->unbind();
+    QVERIFY(GLState::validate());
+}
+
+void GLStateTest::testFrame()
+{
+    // This test verifies that painting a frame keeps the shadow state in sync.
+    QScopedPointer<KWayland::Client::Surface> surface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.data()));
+    AbstractClient *client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), QColor(0, 0, 255, 128));
+    QVERIFY(client);
+
+    RenderLoop *renderLoop = kwinApp()->platform()->enabledOutputs().constFirst()->renderLoop();
+    for (int i = 0; i < 2; ++i) {
+        QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+        Compositor::self()->scene()->addRepaintFull();
+        QVERIFY(framePresentedSpy.wait());
+    }
+    QVERIFY(GLStatistics::lastFrame(GLStatistics::ElidedStateChanges) > 0);
+    QVERIFY(GLState::validate());
+}
+
+WAYLANDTEST_MAIN(GLStateTest)
+#include "gl_state_test.moc"
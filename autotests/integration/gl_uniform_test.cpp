@@ -0,0 +1,148 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "main.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+
+#include <kwinglplatform.h>
+#include <kwingltexture.h>
+#include <kwinglutils.h>
+
+#include <QMatrix4x4>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_gl_uniform-0");
+
+class GLUniformTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testLocationCache();
+    void testElide();
+    void testDrawData();
+};
+
+void GLUniformTest::initTestCase()
+{
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void GLUniformTest::init()
+{
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+}
+
+static GLShader *createColorShader()
+{
+    QByteArray source;
+    const qint64 version = GLPlatform::instance()->glslVersion();
+    if (version >= (GLPlatform::instance()->isGLES() ? kVersionNumber(3, 0) : kVersionNumber(1, 40))) {
+        source = "#version 140\nuniform vec4 customColor;\nout vec4 fragColor;\nvoid main() { fragColor = customColor; }\n";
+    } else {
+        source = "uniform vec4 customColor;\nvoid main() { gl_FragColor = customColor; }\n";
+    }
+    return ShaderManager::instance()->generateCustomShader(ShaderTrait::UniformColor, QByteArray(), source);
+}
+
+void GLUniformTest::testLocationCache()
+{
+    // This test verifies that the location of a uniform is only queried once.
+    QScopedPointer<GLShader> shader(createColorShader());
+    QVERIFY(shader->isValid());
+
+    const int queries = GLStatistics::current(GLStatistics::UniformLocationQueries);
+    const int location = shader->uniformLocation("customColor");
+    QVERIFY(location != -1);
+    QCOMPARE(shader->uniformLocation("customColor"), location);
+    QCOMPARE(shader->uniformLocation("unknown"), -1);
+    QCOMPARE(shader->uniformLocation("unknown"), -1);
+    QCOMPARE(GLStatistics::current(GLStatistics::UniformLocationQueries), queries + 2);
+}
+
+void GLUniformTest::testElide()
+{
+    // This test verifies that setting a uniform to its current value doesn't reach the driver.
+    QScopedPointer<GLShader> shader(createColorShader());
+    QVERIFY(shader->isValid());
+    ShaderBinder binder(shader.data());
+
+    const int updates = GLStatistics::current(GLStatistics::UniformUpdates);
+    const int elided = GLStatistics::current(GLStatistics::ElidedUniformUpdates);
+    QVERIFY(shader->setUniform("customColor", QVector4D(1, 0, 0, 1)));
+    QVERIFY(shader->setUniform("customColor", QVector4D(1, 0, 0, 1)));
+    QVERIFY(shader->setUniform("customColor", QColor(Qt::red)));
+    QVERIFY(shader->setUniform("customColor", QVector4D(0, 1, 0, 1)));
+    QCOMPARE(GLStatistics::current(GLStatistics::UniformUpdates), updates + 2);
+    QCOMPARE(GLStatistics::current(GLStatistics::ElidedUniformUpdates), elided + 2);
+}
+
+static QColor paint(GLShader *shader, GLTexture *texture, const QVector4D &modulation)
+{
+    GLRenderTarget renderTarget(*texture);
+    GLRenderTarget::pushRenderTarget(&renderTarget);
+
+    QImage white(1, 1, QImage::Format_ARGB32_Premultiplied);
+    white.fill(Qt::white);
+    GLTexture source(white);
+
+    QMatrix4x4 projection;
+    projection.ortho(0, texture->width(), texture->height(), 0, 0, 65535);
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, projection);
+    shader->setUniform(GLShader::ModulationConstant, modulation);
+    shader->setUniform(GLShader::Saturation, 1.0f);
+
+    source.bind();
+    source.render(infiniteRegion(), QRect(QPoint(0, 0), texture->size()));
+    source.unbind();
+
+    quint32 pixel = 0;
+    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &pixel);
+    GLRenderTarget::popRenderTarget();
+
+    const uchar *bytes = reinterpret_cast<const uchar *>(&pixel);
+    return QColor(bytes[0], bytes[1], bytes[2], bytes[3]);
+}
+
+void GLUniformTest::testDrawData()
+{
+    // This test verifies that the per-draw uniforms of the generated shaders reach the
+    // shader, and that unchanged values aren't uploaded again.
+    ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
+    GLShader *shader = binder.shader();
+    QVERIFY(shader->isValid());
+
+    QScopedPointer<GLTexture> texture(new GLTexture(GL_RGBA8, QSize(4, 4)));
+    QCOMPARE(paint(shader, texture.data(), QVector4D(1, 0, 0, 1)), QColor(255, 0, 0, 255));
+    QCOMPARE(paint(shader, texture.data(), QVector4D(0, 1, 0, 1)), QColor(0, 255, 0, 255));
+
+    const int updates = GLStatistics::current(GLStatistics::UniformUpdates);
+    QCOMPARE(paint(shader, texture.data(), QVector4D(0, 1, 0, 1)), QColor(0, 255, 0, 255));
+    QCOMPARE(GLStatistics::current(GLStatistics::UniformUpdates), updates);
+}
+
+WAYLANDTEST_MAIN(GLUniformTest)
+#include "gl_uniform_test.moc"
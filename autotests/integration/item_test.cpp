@@ -0,0 +1,256 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "abstract_output.h"
+#include "composite.h"
+#include "item.h"
+#include "main.h"
+#include "platform.h"
+#include "screens.h"
+#include "wayland_server.h"
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_item-0");
+
+class ItemTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testRootPosition();
+    void testWorldTransform();
+    void testReparent();
+    void testSubtreeRepaints();
+    void testOutputSlots();
+    void benchmarkScheduleRepaint_data();
+    void benchmarkScheduleRepaint();
+
+private:
+    AbstractOutput *repaintOutput() const;
+    void setOutputCount(int count);
+};
+
+void ItemTest::initTestCase()
+{
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::compositing());
+}
+
+void ItemTest::setOutputCount(int count)
+{
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(int, count));
+    QCOMPARE(kwinApp()->platform()->enabledOutputs().count(), count);
+}
+
+AbstractOutput *ItemTest::repaintOutput() const
+{
+    // Without per screen rendering, all repaints are stored for the null output.
+    if (kwinApp()->platform()->isPerScreenRenderingEnabled()) {
+        return kwinApp()->platform()->enabledOutputs().constFirst();
+    }
+    return nullptr;
+}
+
+void ItemTest::testRootPosition()
+{
+    // This test verifies that the cached root position follows the moves of all ancestors.
+    Item root;
+    root.setPosition(QPoint(10, 20));
+    Item child(&root);
+    child.setPosition(QPoint(5, 5));
+    Item grandChild(&child);
+    grandChild.setPosition(QPoint(1, 2));
+
+    QCOMPARE(grandChild.rootPosition(), QPoint(16, 27));
+    QCOMPARE(grandChild.mapToGlobal(QRect(0, 0, 10, 10)), QRect(16, 27, 10, 10));
+
+    root.setPosition(QPoint(100, 200));
+    QCOMPARE(child.rootPosition(), QPoint(105, 205));
+    QCOMPARE(grandChild.rootPosition(), QPoint(106, 207));
+
+    child.setPosition(QPoint(0, 0));
+    QCOMPARE(root.rootPosition(), QPoint(100, 200));
+    QCOMPARE(grandChild.rootPosition(), QPoint(101, 202));
+}
+
+void ItemTest::testWorldTransform()
+{
+    // This test verifies that the cached world transform combines the positions and the
+    // transforms of all ancestors.
+    Item root;
+    root.setPosition(QPoint(10, 20));
+    Item child(&root);
+    child.setPosition(QPoint(5, 5));
+
+    QCOMPARE(child.worldTransform().map(QPoint(0, 0)), QPoint(15, 25));
+
+    QMatrix4x4 scale;
+    scale.scale(2);
+    root.setTransform(scale);
+    QCOMPARE(child.worldTransform().map(QPoint(0, 0)), QPoint(20, 30));
+    QCOMPARE(child.worldTransform().map(QPoint(1, 1)), QPoint(22, 32));
+
+    root.setTransform(QMatrix4x4());
+    QCOMPARE(child.worldTransform().map(QPoint(1, 1)), QPoint(16, 26));
+}
+
+void ItemTest::testReparent()
+{
+    // This test verifies that the cached root position is updated when the parent changes.
+    Item parent1;
+    parent1.setPosition(QPoint(10, 10));
+    Item parent2;
+    parent2.setPosition(QPoint(50, 50));
+    Item child(&parent1);
+    child.setPosition(QPoint(1, 1));
+    QCOMPARE(child.rootPosition(), QPoint(11, 11));
+
+    child.setParentItem(&parent2);
+    QCOMPARE(child.rootPosition(), QPoint(51, 51));
+
+    child.setParentItem(nullptr);
+    QCOMPARE(child.rootPosition(), QPoint(1, 1));
+}
+
+void ItemTest::testSubtreeRepaints()
+{
+    // This test verifies that the subtree repaint flag is raised by repaints of descendants
+    // and cleared only when the whole subtree has been reset.
+    AbstractOutput *output = repaintOutput();
+
+    Item root;
+    root.setSize(QSize(100, 100));
+    Item child(&root);
+    child.setSize(QSize(50, 50));
+    Item grandChild(&child);
+    grandChild.setSize(QSize(10, 10));
+
+    // New items need to be painted.
+    QVERIFY(root.hasSubtreeRepaints(output));
+
+    // Resetting an item with dirty children does not clear its flag.
+    root.resetRepaints(output);
+    QVERIFY(root.hasSubtreeRepaints(output));
+
+    grandChild.resetRepaints(output);
+    child.resetRepaints(output);
+    root.resetRepaints(output);
+    QVERIFY(!root.hasSubtreeRepaints(output));
+    QVERIFY(!child.hasSubtreeRepaints(output));
+    QVERIFY(!grandChild.hasSubtreeRepaints(output));
+
+    grandChild.scheduleRepaint(QRect(0, 0, 5, 5));
+    QVERIFY(grandChild.hasSubtreeRepaints(output));
+    QVERIFY(child.hasSubtreeRepaints(output));
+    QVERIFY(root.hasSubtreeRepaints(output));
+    QCOMPARE(grandChild.repaints(output), QRegion(0, 0, 5, 5));
+
+    grandChild.resetRepaints(output);
+    child.resetRepaints(output);
+    root.resetRepaints(output);
+    QVERIFY(!root.hasSubtreeRepaints(output));
+
+    // A new child has unknown repaints.
+    Item newChild(&child);
+    QVERIFY(child.hasSubtreeRepaints(output));
+    QVERIFY(root.hasSubtreeRepaints(output));
+}
+
+void ItemTest::testOutputSlots()
+{
+    // This test verifies that outputs get compact indices and that repaints are split
+    // between the outputs that they touch.
+    if (!kwinApp()->platform()->isPerScreenRenderingEnabled()) {
+        QSKIP("Requires per screen rendering");
+    }
+
+    setOutputCount(2);
+    const auto outputs = kwinApp()->platform()->enabledOutputs();
+    const auto &outputSlots = kwinApp()->platform()->outputSlots();
+    for (AbstractOutput *output : outputs) {
+        QVERIFY(output->index() >= 0);
+        QCOMPARE(outputSlots[output->index()].output, output);
+        QCOMPARE(outputSlots[output->index()].geometry, output->geometry());
+    }
+    QVERIFY(outputs[0]->index() != outputs[1]->index());
+
+    Item item;
+    item.setSize(QSize(2560, 1024));
+    for (AbstractOutput *output : outputs) {
+        item.resetRepaints(output);
+    }
+
+    item.scheduleRepaint(QRect(1200, 0, 100, 100));
+    QCOMPARE(item.repaints(outputs[0]), QRegion(1200, 0, 80, 100));
+    QCOMPARE(item.repaints(outputs[1]), QRegion(1280, 0, 20, 100));
+
+    item.scheduleRepaint(QRect(0, 0, 10, 10));
+    QCOMPARE(item.repaints(outputs[0]), QRegion(1200, 0, 80, 100) | QRegion(0, 0, 10, 10));
+    QCOMPARE(item.repaints(outputs[1]), QRegion(1280, 0, 20, 100));
+
+    // Replacing the outputs must not leak the repaints to the new outputs.
+    setOutputCount(2);
+    const auto newOutputs = kwinApp()->platform()->enabledOutputs();
+    QVERIFY(outputSlots.count() <= 4);
+    for (AbstractOutput *output : newOutputs) {
+        QCOMPARE(item.repaints(output), QRegion(QRect(QPoint(0, 0), screens()->size())));
+    }
+
+    setOutputCount(1);
+}
+
+void ItemTest::benchmarkScheduleRepaint_data()
+{
+    QTest::addColumn<int>("outputCount");
+
+    QTest::newRow("1 output") << 1;
+    QTest::newRow("2 outputs") << 2;
+    QTest::newRow("4 outputs") << 4;
+}
+
+void ItemTest::benchmarkScheduleRepaint()
+{
+    // Mimics the surface damage of a video player with a few subsurfaces.
+    QFETCH(int, outputCount);
+    setOutputCount(outputCount);
+
+    Item root;
+    root.setPosition(QPoint(100, 100));
+    root.setSize(QSize(1280, 720));
+    QVector<Item *> children;
+    for (int i = 0; i < 8; ++i) {
+        Item *child = new Item(&root);
+        child->setPosition(QPoint(i * 10, i * 10));
+        child->setSize(QSize(640, 360));
+        children.append(child);
+    }
+
+    QBENCHMARK {
+        root.scheduleRepaint(QRect(0, 0, 1280, 720));
+        for (Item *child : qAsConst(children)) {
+            child->scheduleRepaint(QRect(0, 0, 640, 360));
+        }
+    }
+
+    qDeleteAll(children);
+    setOutputCount(1);
+}
+
+WAYLANDTEST_MAIN(ItemTest)
+#include "item_test.moc"
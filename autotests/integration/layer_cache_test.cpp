@@ -0,0 +1,171 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "abstract_output.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "main.h"
+#include "options.h"
+#include "platform.h"
+#include "renderloop.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <kwinglutils.h>
+
+#include <KWayland/Client/subsurface.h>
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_layer_cache-0");
+
+class LayerCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testFlatten();
+    void testDamage();
+    void testBudget();
+
+private:
+    int renderFrame();
+    int renderIdleFrames();
+    void createWindow();
+
+    QScopedPointer<KWayland::Client::Surface> m_surface;
+    QScopedPointer<KWayland::Client::Surface> m_childSurface;
+    QScopedPointer<KWayland::Client::SubSurface> m_subSurface;
+    QScopedPointer<Test::XdgToplevel> m_shellSurface;
+};
+
+void LayerCacheTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // effects change the way windows are painted, which keeps them from being flattened
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void LayerCacheTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    options->setWindowLayerCacheBudget(Options::defaultWindowLayerCacheBudget());
+}
+
+void LayerCacheTest::cleanup()
+{
+    m_subSurface.reset();
+    m_childSurface.reset();
+    m_shellSurface.reset();
+    m_surface.reset();
+    Test::destroyWaylandConnection();
+    options->setWindowLayerCaching(false);
+}
+
+void LayerCacheTest::createWindow()
+{
+    // A window with a subsurface needs two draw calls unless it is flattened.
+    m_surface.reset(Test::createSurface());
+    m_childSurface.reset(Test::createSurface());
+    m_subSurface.reset(Test::createSubSurface(m_childSurface.data(), m_surface.data()));
+    m_shellSurface.reset(Test::createXdgToplevelSurface(m_surface.data()));
+    Test::render(m_childSurface.data(), QSize(30, 10), Qt::red);
+
+    AbstractClient *client = Test::renderAndWaitForShown(m_surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+}
+
+int LayerCacheTest::renderFrame()
+{
+    RenderLoop *renderLoop = kwinApp()->platform()->enabledOutputs().constFirst()->renderLoop();
+    QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+    Compositor::self()->scene()->addRepaintFull();
+    if (!framePresentedSpy.wait()) {
+        return -1;
+    }
+    return GLStatistics::current(GLStatistics::DrawCalls);
+}
+
+int LayerCacheTest::renderIdleFrames()
+{
+    int drawCalls = -1;
+    for (int i = 0; i < 10; ++i) {
+        drawCalls = renderFrame();
+    }
+    return drawCalls;
+}
+
+void LayerCacheTest::testFlatten()
+{
+    // This test verifies that a window that hasn't changed for a few frames is drawn with a
+    // single draw call.
+    createWindow();
+    const int uncached = renderIdleFrames();
+    QVERIFY(uncached > 0);
+
+    options->setWindowLayerCaching(true);
+    const int cached = renderIdleFrames();
+    QCOMPARE(cached, uncached - 1);
+}
+
+void LayerCacheTest::testDamage()
+{
+    // This test verifies that new contents drop the flattened layer.
+    options->setWindowLayerCaching(true);
+    createWindow();
+    const int cached = renderIdleFrames();
+
+    Test::render(m_childSurface.data(), QSize(30, 10), Qt::green);
+    m_surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QTRY_COMPARE(renderFrame(), cached + 1);
+
+    QCOMPARE(renderIdleFrames(), cached);
+}
+
+void LayerCacheTest::testBudget()
+{
+    // This test verifies that layers that don't fit into the budget aren't created.
+    createWindow();
+    const int uncached = renderIdleFrames();
+
+    options->setWindowLayerCacheBudget(0);
+    options->setWindowLayerCaching(true);
+    QCOMPARE(renderIdleFrames(), uncached);
+}
+
+WAYLANDTEST_MAIN(LayerCacheTest)
+#include "layer_cache_test.moc"
@@ -0,0 +1,127 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_scene_opengl_test.h"
+
+#include "abstract_client.h"
+#include "options.h"
+#include "wayland_server.h"
+
+#include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/surface.h>
+
+namespace KWin
+{
+
+class OccludedFrameCallbackTest : public GenericSceneOpenGLTest
+{
+    Q_OBJECT
+public:
+    OccludedFrameCallbackTest() : GenericSceneOpenGLTest(QByteArrayLiteral("O2")) {}
+private Q_SLOTS:
+    void init();
+    void testCoveredClientIsThrottled();
+    void testThrottlingDisabled();
+};
+
+static void renderWithFrameCallback(KWayland::Client::Surface *surface, const QSize &size, const QColor &color)
+{
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(color);
+    surface->attachBuffer(Test::waylandShmPool()->createBuffer(image));
+    surface->damage(QRect(QPoint(0, 0), size));
+    surface->commit(KWayland::Client::Surface::CommitFlag::FrameCallback);
+}
+
+// Keeps the given surface busy by requesting a new frame callback every time one arrives
+// and returns the number of received frame callbacks after the given time.
+static int countFrameCallbacks(KWayland::Client::Surface *surface, const QColor &color, std::chrono::milliseconds duration)
+{
+    int count = 0;
+    QObject context;
+    QObject::connect(surface, &KWayland::Client::Surface::frameRendered, &context, [surface, color, &count]() {
+        count++;
+        renderWithFrameCallback(surface, QSize(100, 50), color);
+    });
+    renderWithFrameCallback(surface, QSize(100, 50), color);
+
+    QTest::qWait(duration.count());
+    return count;
+}
+
+void OccludedFrameCallbackTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void OccludedFrameCallbackTest::testCoveredClientIsThrottled()
+{
+    // This test verifies that a client covered by an opaque window receives frame
+    // callbacks at the reduced rate only.
+    options->setOccludedWindowFrameRate(2);
+
+    QScopedPointer<KWayland::Client::Surface> coveredSurface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> coveredShellSurface(Test::createXdgToplevelSurface(coveredSurface.data()));
+    AbstractClient *covered = Test::renderAndWaitForShown(coveredSurface.data(), QSize(100, 50), Qt::blue, QImage::Format_RGB32);
+    QVERIFY(covered);
+    covered->move(QPoint(100, 100));
+
+    // Without anything on top, the client gets a frame callback for every frame.
+    const int visibleCount = countFrameCallbacks(coveredSurface.data(), Qt::blue, std::chrono::milliseconds(1000));
+    QVERIFY(visibleCount > 10);
+
+    // Cover the client with an opaque window.
+    QScopedPointer<KWayland::Client::Surface> coveringSurface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> coveringShellSurface(Test::createXdgToplevelSurface(coveringSurface.data()));
+    AbstractClient *covering = Test::renderAndWaitForShown(coveringSurface.data(), QSize(1280, 1024), Qt::red, QImage::Format_RGB32);
+    QVERIFY(covering);
+    covering->move(QPoint(0, 0));
+    QVERIFY(covering->frameGeometry().contains(covered->frameGeometry()));
+
+    // Now the covered client gets about two frame callbacks per second.
+    const int coveredCount = countFrameCallbacks(coveredSurface.data(), Qt::blue, std::chrono::milliseconds(1000));
+    QVERIFY(coveredCount >= 1);
+    QVERIFY(coveredCount <= 4);
+
+    // Once uncovered, the client is back to the full frame rate.
+    coveringShellSurface.reset();
+    coveringSurface.reset();
+    QVERIFY(Test::waitForWindowDestroyed(covering));
+    const int uncoveredCount = countFrameCallbacks(coveredSurface.data(), Qt::blue, std::chrono::milliseconds(1000));
+    QVERIFY(uncoveredCount > 10);
+
+    options->setOccludedWindowFrameRate(Options::defaultOccludedWindowFrameRate());
+}
+
+void OccludedFrameCallbackTest::testThrottlingDisabled()
+{
+    // This test verifies that covered clients are not throttled if the rate is zero.
+    options->setOccludedWindowFrameRate(0);
+
+    QScopedPointer<KWayland::Client::Surface> coveredSurface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> coveredShellSurface(Test::createXdgToplevelSurface(coveredSurface.data()));
+    AbstractClient *covered = Test::renderAndWaitForShown(coveredSurface.data(), QSize(100, 50), Qt::blue, QImage::Format_RGB32);
+    QVERIFY(covered);
+    covered->move(QPoint(100, 100));
+
+    QScopedPointer<KWayland::Client::Surface> coveringSurface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> coveringShellSurface(Test::createXdgToplevelSurface(coveringSurface.data()));
+    AbstractClient *covering = Test::renderAndWaitForShown(coveringSurface.data(), QSize(1280, 1024), Qt::red, QImage::Format_RGB32);
+    QVERIFY(covering);
+    covering->move(QPoint(0, 0));
+
+    const int coveredCount = countFrameCallbacks(coveredSurface.data(), Qt::blue, std::chrono::milliseconds(1000));
+    QVERIFY(coveredCount > 10);
+
+    options->setOccludedWindowFrameRate(Options::defaultOccludedWindowFrameRate());
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::OccludedFrameCallbackTest)
+#include "occluded_frame_callback_test.moc"
@@ -0,0 +1,166 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "abstract_output.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "main.h"
+#include "options.h"
+#include "platform.h"
+#include "renderloop.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <kwinglutils.h>
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_render_batch-0");
+
+class RenderBatchTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testCallCount_data();
+    void testCallCount();
+
+private:
+    void restartScene(bool batching);
+    void renderFrame();
+
+    struct Window
+    {
+        KWayland::Client::Surface *surface;
+        Test::XdgToplevel *shellSurface;
+    };
+    QVector<Window> m_windows;
+};
+
+void RenderBatchTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // effects paint between windows, which disables batching
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void RenderBatchTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void RenderBatchTest::cleanup()
+{
+    for (const Window &window : qAsConst(m_windows)) {
+        delete window.shellSurface;
+        delete window.surface;
+    }
+    m_windows.clear();
+    Test::destroyWaylandConnection();
+    qunsetenv("KWIN_GL_BATCHING");
+    options->setFrontToBackRendering(false);
+}
+
+void RenderBatchTest::restartScene(bool batching)
+{
+    qputenv("KWIN_GL_BATCHING", batching ? QByteArrayLiteral("1") : QByteArrayLiteral("0"));
+
+    QSignalSpy sceneCreatedSpy(Compositor::self(), &Compositor::sceneCreated);
+    QVERIFY(sceneCreatedSpy.isValid());
+    Compositor::self()->reinitialize();
+    if (sceneCreatedSpy.isEmpty()) {
+        QVERIFY(sceneCreatedSpy.wait());
+    }
+}
+
+void RenderBatchTest::renderFrame()
+{
+    RenderLoop *renderLoop = kwinApp()->platform()->enabledOutputs().constFirst()->renderLoop();
+    QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+    QVERIFY(framePresentedSpy.isValid());
+    Compositor::self()->scene()->addRepaintFull();
+    QVERIFY(framePresentedSpy.wait());
+}
+
+void RenderBatchTest::testCallCount_data()
+{
+    QTest::addColumn<bool>("batching");
+    QTest::addColumn<bool>("frontToBack");
+
+    QTest::newRow("batched") << true << false;
+    QTest::newRow("batched, front-to-back") << true << true;
+    QTest::newRow("unbatched") << false << false;
+}
+
+void RenderBatchTest::testCallCount()
+{
+    // This test verifies that the geometry of all windows is uploaded at once when batching
+    // is enabled, and that every window still needs no more than one draw call. The virtual
+    // backend has no depth buffer, so the front-to-back mode must fall back to the ordinary
+    // stacking order.
+    QFETCH(bool, batching);
+    QFETCH(bool, frontToBack);
+    options->setFrontToBackRendering(frontToBack);
+    restartScene(batching);
+
+    const int windowCount = 10;
+    for (int i = 0; i < windowCount; ++i) {
+        KWayland::Client::Surface *surface = Test::createSurface();
+        Test::XdgToplevel *shellSurface = Test::createXdgToplevelSurface(surface);
+        m_windows.append(Window{surface, shellSurface});
+        AbstractClient *client = Test::renderAndWaitForShown(surface, QSize(100, 50), Qt::blue);
+        QVERIFY(client);
+        client->move(QPoint(i * 110, 0));
+    }
+
+    renderFrame();
+
+    // The background and the cursor may need a draw call and an upload of their own.
+    const int drawCalls = GLStatistics::current(GLStatistics::DrawCalls);
+    const int bufferUploads = GLStatistics::current(GLStatistics::BufferUploads);
+    QVERIFY(drawCalls >= windowCount);
+    QVERIFY(drawCalls <= windowCount + 2);
+    if (batching) {
+        QVERIFY(bufferUploads <= 3);
+    } else {
+        QVERIFY(bufferUploads >= windowCount);
+    }
+}
+
+WAYLANDTEST_MAIN(RenderBatchTest)
+#include "render_batch_test.moc"
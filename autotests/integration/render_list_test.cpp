@@ -0,0 +1,178 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "abstract_client.h"
+#include "composite.h"
+#include "effects.h"
+#include "main.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_render_list-0");
+
+class RenderListTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testStackingOrder();
+    void testElevatedWindow();
+    void testClosedWindow();
+    void benchmarkWindowsToRender_data();
+    void benchmarkWindowsToRender();
+
+private:
+    AbstractClient *createWindow();
+
+    struct Window
+    {
+        KWayland::Client::Surface *surface;
+        Test::XdgToplevel *shellSurface;
+    };
+    QVector<Window> m_windows;
+};
+
+void RenderListTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    Test::initWaylandWorkspace();
+    QVERIFY(Compositor::compositing());
+}
+
+void RenderListTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void RenderListTest::cleanup()
+{
+    for (const Window &window : qAsConst(m_windows)) {
+        delete window.shellSurface;
+        delete window.surface;
+    }
+    m_windows.clear();
+    Test::destroyWaylandConnection();
+}
+
+AbstractClient *RenderListTest::createWindow()
+{
+    KWayland::Client::Surface *surface = Test::createSurface();
+    Test::XdgToplevel *shellSurface = Test::createXdgToplevelSurface(surface);
+    m_windows.append(Window{surface, shellSurface});
+    return Test::renderAndWaitForShown(surface, QSize(100, 50), Qt::blue);
+}
+
+void RenderListTest::testStackingOrder()
+{
+    // This test verifies that the render list follows changes in the stacking order.
+    AbstractClient *client1 = createWindow();
+    QVERIFY(client1);
+    AbstractClient *client2 = createWindow();
+    QVERIFY(client2);
+
+    QList<Toplevel *> windows = Compositor::self()->windowsToRender();
+    QVERIFY(windows.indexOf(client1) < windows.indexOf(client2));
+
+    workspace()->raiseClient(client1);
+    windows = Compositor::self()->windowsToRender();
+    QVERIFY(windows.indexOf(client2) < windows.indexOf(client1));
+    QCOMPARE(windows, workspace()->xStackingOrder());
+}
+
+void RenderListTest::testElevatedWindow()
+{
+    // This test verifies that elevated windows are painted on top of all other windows.
+    AbstractClient *client1 = createWindow();
+    QVERIFY(client1);
+    AbstractClient *client2 = createWindow();
+    QVERIFY(client2);
+    QCOMPARE(Compositor::self()->windowsToRender().last(), client2);
+
+    effects->setElevatedWindow(client1->effectWindow(), true);
+    QCOMPARE(Compositor::self()->windowsToRender().last(), client1);
+    QCOMPARE(Compositor::self()->windowsToRender().count(client1), 1);
+
+    effects->setElevatedWindow(client1->effectWindow(), false);
+    QCOMPARE(Compositor::self()->windowsToRender().last(), client2);
+}
+
+void RenderListTest::testClosedWindow()
+{
+    // This test verifies that windows removed from the workspace are dropped from the render list.
+    AbstractClient *client = createWindow();
+    QVERIFY(client);
+    QVERIFY(Compositor::self()->windowsToRender().contains(client));
+
+    const Window window = m_windows.takeLast();
+    delete window.shellSurface;
+    delete window.surface;
+    QVERIFY(Test::waitForWindowDestroyed(client));
+
+    const QList<Toplevel *> windows = Compositor::self()->windowsToRender();
+    QCOMPARE(windows, workspace()->xStackingOrder());
+}
+
+void RenderListTest::benchmarkWindowsToRender_data()
+{
+    QTest::addColumn<bool>("invalidate");
+
+    QTest::newRow("cached") << false;
+    QTest::newRow("rebuilt") << true;
+}
+
+void RenderListTest::benchmarkWindowsToRender()
+{
+    // Compares the per-frame cost of the cached render list with rebuilding it from
+    // scratch, which is what every frame used to do, with 500 windows and an elevated one.
+    QFETCH(bool, invalidate);
+
+    AbstractClient *elevated = nullptr;
+    for (int i = 0; i < 500; ++i) {
+        AbstractClient *client = createWindow();
+        QVERIFY(client);
+        if (i == 0) {
+            elevated = client;
+        }
+    }
+    effects->setElevatedWindow(elevated->effectWindow(), true);
+    QCOMPARE(Compositor::self()->windowsToRender().count(), workspace()->xStackingOrder().count());
+
+    QBENCHMARK {
+        if (invalidate) {
+            Compositor::self()->invalidateWindowsToRender();
+        }
+        const QList<Toplevel *> windows = Compositor::self()->windowsToRender();
+        Q_UNUSED(windows)
+    }
+
+    effects->setElevatedWindow(elevated->effectWindow(), false);
+}
+
+WAYLANDTEST_MAIN(RenderListTest)
+#include "render_list_test.moc"
@@ -0,0 +1,139 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "main.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+
+#include <kwinglplatform.h>
+#include <kwinglutils.h>
+
+#include <QDirIterator>
+#include <QStandardPaths>
+#include <QUuid>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_shader_cache-0");
+
+class ShaderCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testCache();
+    void testInvalidBinary();
+
+private:
+    QByteArray m_fragmentSource;
+};
+
+void ShaderCacheTest::initTestCase()
+{
+    // The program binaries must not end up in the cache of the user.
+    QStandardPaths::setTestModeEnabled(true);
+
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void ShaderCacheTest::init()
+{
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+
+    // Every test needs a program that is not in the cache yet.
+    const QByteArray comment = "// " + QUuid::createUuid().toByteArray() + "\n";
+    const qint64 version = GLPlatform::instance()->glslVersion();
+    if (version >= (GLPlatform::instance()->isGLES() ? kVersionNumber(3, 0) : kVersionNumber(1, 40))) {
+        m_fragmentSource = "#version 140\n" + comment + "out vec4 fragColor;\nvoid main() { fragColor = vec4(1.0); }\n";
+    } else {
+        m_fragmentSource = comment + "void main() { gl_FragColor = vec4(1.0); }\n";
+    }
+}
+
+static QString findBinary()
+{
+    QDirIterator it(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/kwin/glsl"),
+                    QDir::Files, QDirIterator::Subdirectories);
+    QString newest;
+    QDateTime newestTime;
+    while (it.hasNext()) {
+        it.next();
+        if (newest.isEmpty() || it.fileInfo().lastModified() > newestTime) {
+            newest = it.filePath();
+            newestTime = it.fileInfo().lastModified();
+        }
+    }
+    return newest;
+}
+
+void ShaderCacheTest::testCache()
+{
+    // This test verifies that a program is built from its sources only once.
+    const int compilations = GLStatistics::current(GLStatistics::ShaderCompilations);
+    const int loads = GLStatistics::current(GLStatistics::ProgramBinaryLoads);
+
+    QScopedPointer<GLShader> first(ShaderManager::instance()->generateCustomShader(ShaderTrait::MapTexture, QByteArray(), m_fragmentSource));
+    QVERIFY(first->isValid());
+    QCOMPARE(GLStatistics::current(GLStatistics::ShaderCompilations), compilations + 1);
+    if (findBinary().isEmpty()) {
+        QSKIP("The driver doesn't support program binaries");
+    }
+
+    QScopedPointer<GLShader> second(ShaderManager::instance()->generateCustomShader(ShaderTrait::MapTexture, QByteArray(), m_fragmentSource));
+    QVERIFY(second->isValid());
+    QCOMPARE(GLStatistics::current(GLStatistics::ShaderCompilations), compilations + 1);
+    QCOMPARE(GLStatistics::current(GLStatistics::ProgramBinaryLoads), loads + 1);
+    QVERIFY(second->uniformLocation("modelViewProjectionMatrix") != -1);
+}
+
+void ShaderCacheTest::testInvalidBinary()
+{
+    // This test verifies that a damaged binary is replaced by a program built from the sources.
+    QScopedPointer<GLShader> first(ShaderManager::instance()->generateCustomShader(ShaderTrait::MapTexture, QByteArray(), m_fragmentSource));
+    QVERIFY(first->isValid());
+    const QString binary = findBinary();
+    if (binary.isEmpty()) {
+        QSKIP("The driver doesn't support program binaries");
+    }
+
+    QFile file(binary);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    file.seek(file.size() / 2);
+    file.write(QByteArray(16, 'x'));
+    file.close();
+
+    const int compilations = GLStatistics::current(GLStatistics::ShaderCompilations);
+    QScopedPointer<GLShader> second(ShaderManager::instance()->generateCustomShader(ShaderTrait::MapTexture, QByteArray(), m_fragmentSource));
+    QVERIFY(second->isValid());
+    QCOMPARE(GLStatistics::current(GLStatistics::ShaderCompilations), compilations + 1);
+
+    // The program binary has been stored again.
+    const int loads = GLStatistics::current(GLStatistics::ProgramBinaryLoads);
+    QScopedPointer<GLShader> third(ShaderManager::instance()->generateCustomShader(ShaderTrait::MapTexture, QByteArray(), m_fragmentSource));
+    QVERIFY(third->isValid());
+    QCOMPARE(GLStatistics::current(GLStatistics::ProgramBinaryLoads), loads + 1);
+}
+
+WAYLANDTEST_MAIN(ShaderCacheTest)
+#include "shader_cache_test.moc"
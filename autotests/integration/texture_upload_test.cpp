@@ -0,0 +1,122 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "main.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+
+#include <kwinglplatform.h>
+#include <kwingltexture.h>
+#include <kwinglutils.h>
+
+#include <QPainter>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_texture_upload-0");
+
+class TextureUploadTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testRegion_data();
+    void testRegion();
+};
+
+void TextureUploadTest::initTestCase()
+{
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void TextureUploadTest::init()
+{
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+}
+
+static QImage readTexture(GLTexture *texture)
+{
+    QImage image(texture->size(), QImage::Format_RGBA8888_Premultiplied);
+    GLRenderTarget renderTarget(*texture);
+    GLRenderTarget::pushRenderTarget(&renderTarget);
+    glReadPixels(0, 0, image.width(), image.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+    GLRenderTarget::popRenderTarget();
+    return image;
+}
+
+void TextureUploadTest::testRegion_data()
+{
+    QTest::addColumn<QRegion>("region");
+    QTest::addColumn<QSize>("textureSize");
+
+    QTest::newRow("rect") << QRegion(10, 20, 30, 40) << QSize(128, 128);
+
+    QRegion scattered;
+    for (int i = 0; i < 8; ++i) {
+        scattered += QRect(i * 15, i * 11, 7, 5);
+    }
+    QTest::newRow("scattered") << scattered << QSize(128, 128);
+
+    QRegion lines;
+    for (int i = 0; i < 50; ++i) {
+        lines += QRect(i % 3, i * 2, 100 - i, 1);
+    }
+    QTest::newRow("lines") << lines << QSize(128, 128);
+
+    QTest::newRow("outside") << QRegion(90, 90, 50, 50) << QSize(128, 128);
+    QTest::newRow("wide texture") << QRegion(10, 20, 30, 40) << QSize(160, 128);
+}
+
+void TextureUploadTest::testRegion()
+{
+    // This test verifies that damaged parts of an image are uploaded in a few boxes.
+    QImage image(128, 128, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    QFETCH(QSize, textureSize);
+    QScopedPointer<GLTexture> texture(new GLTexture(GL_RGBA8, textureSize));
+    texture->update(image, image.rect());
+
+    QFETCH(QRegion, region);
+    QPainter painter(&image);
+    for (const QRect &rect : region) {
+        painter.fillRect(rect, Qt::blue);
+    }
+    painter.end();
+
+    // Without GL_UNPACK_ROW_LENGTH, the boxes of an image that is narrower than the texture
+    // are uploaded row by row.
+    const bool unpack = !GLPlatform::instance()->isGLES() || hasGLVersion(3, 0)
+        || hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+    const QRegion damage = region & image.rect();
+    const int maximum = (unpack || textureSize.width() == image.width()) ? 4 : damage.boundingRect().height() * 4;
+
+    const int uploads = GLStatistics::current(GLStatistics::TextureUploads);
+    texture->update(image, region);
+    QVERIFY(GLStatistics::current(GLStatistics::TextureUploads) - uploads <= maximum);
+
+    QCOMPARE(readTexture(texture.data()).copy(image.rect()), image.convertToFormat(QImage::Format_RGBA8888_Premultiplied));
+}
+
+WAYLANDTEST_MAIN(TextureUploadTest)
+#include "texture_upload_test.moc"
@@ -0,0 +1,222 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include <kwineffects.h>
+
+#include <QMatrix4x4>
+#include <QRandomGenerator>
+#include <QTest>
+
+#ifndef GL_TRIANGLES
+#  define GL_TRIANGLES      0x0004
+#endif
+
+#ifndef GL_QUADS
+#  define GL_QUADS          0x0007
+#endif
+
+using namespace KWin;
+
+class WindowQuadArrayTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testConversion();
+    void testBoundingRect();
+    void testSubQuad();
+    void testTransformTextureCoordinates();
+    void testMakeInterleavedArrays_data();
+    void testMakeInterleavedArrays();
+    void benchmarkMakeInterleavedArrays_data();
+    void benchmarkMakeInterleavedArrays();
+};
+
+static WindowQuad makeQuad(const QRectF &r, const QRectF &t)
+{
+    WindowQuad quad;
+    quad[0] = WindowVertex(r.left(), r.top(), t.left(), t.top());
+    quad[1] = WindowVertex(r.right(), r.top(), t.right(), t.top());
+    quad[2] = WindowVertex(r.right(), r.bottom(), t.right(), t.bottom());
+    quad[3] = WindowVertex(r.left(), r.bottom(), t.left(), t.bottom());
+    return quad;
+}
+
+static WindowQuadList makeQuads(int count)
+{
+    QRandomGenerator generator(42);
+    WindowQuadList quads;
+    quads.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QRectF rect(generator.bounded(0, 2000), generator.bounded(0, 2000),
+                          generator.bounded(1, 500), generator.bounded(1, 500));
+        quads.append(makeQuad(rect, rect.translated(generator.bounded(0, 100), 0)));
+    }
+    return quads;
+}
+
+static void compareQuads(const WindowQuad &actual, const WindowQuad &expected)
+{
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE(float(actual[i].x()), float(expected[i].x()));
+        QCOMPARE(float(actual[i].y()), float(expected[i].y()));
+        QCOMPARE(float(actual[i].u()), float(expected[i].u()));
+        QCOMPARE(float(actual[i].v()), float(expected[i].v()));
+    }
+}
+
+void WindowQuadArrayTest::testConversion()
+{
+    const WindowQuadList quads = makeQuads(10);
+    const WindowQuadArray array(quads);
+    QCOMPARE(array.count(), 10);
+    QVERIFY(!array.isEmpty());
+
+    const WindowQuadList converted = array.toList();
+    QCOMPARE(converted.count(), quads.count());
+    for (int i = 0; i < quads.count(); ++i) {
+        compareQuads(converted[i], quads[i]);
+        QCOMPARE(array.xData()[i * 4 + 2], float(quads[i][2].x()));
+        QCOMPARE(array.vData()[i * 4 + 3], float(quads[i][3].v()));
+    }
+
+    WindowQuadArray copy;
+    copy.append(array, 3);
+    copy << quads[5];
+    QCOMPARE(copy.count(), 2);
+    compareQuads(copy.at(0), quads[3]);
+    compareQuads(copy.at(1), quads[5]);
+
+    copy.clear();
+    QVERIFY(copy.isEmpty());
+}
+
+void WindowQuadArrayTest::testBoundingRect()
+{
+    WindowQuadArray array;
+    array << makeQuad(QRectF(10, 20, 30, 40), QRectF(0, 0, 1, 1));
+    QCOMPARE(array.boundingRect(0), QRectF(10, 20, 30, 40));
+}
+
+void WindowQuadArrayTest::testSubQuad()
+{
+    // The sub quads must match WindowQuad::makeSubQuad() for any texture mapping,
+    // including rotated buffers.
+    WindowQuad rotated;
+    rotated[0] = WindowVertex(0, 0, 100, 0);
+    rotated[1] = WindowVertex(200, 0, 100, 200);
+    rotated[2] = WindowVertex(200, 100, 0, 200);
+    rotated[3] = WindowVertex(0, 100, 0, 0);
+
+    const WindowQuadList quads{makeQuad(QRectF(0, 0, 200, 100), QRectF(0, 0, 400, 200)), rotated};
+    const WindowQuadArray array(quads);
+    for (int i = 0; i < quads.count(); ++i) {
+        WindowQuadArray subQuads;
+        subQuads.appendSubQuad(array, i, 50, 25, 150, 75);
+        compareQuads(subQuads.at(0), quads[i].makeSubQuad(50, 25, 150, 75));
+    }
+}
+
+void WindowQuadArrayTest::testTransformTextureCoordinates()
+{
+    const WindowQuadList quads = makeQuads(7);
+    WindowQuadArray array(quads);
+
+    QMatrix4x4 matrix;
+    matrix.translate(0.5, 0.25);
+    matrix.scale(0.5, 2);
+    array.transformTextureCoordinates(matrix);
+
+    for (int i = 0; i < quads.count(); ++i) {
+        for (int j = 0; j < 4; ++j) {
+            const WindowVertex vertex = array.at(i)[j];
+            QCOMPARE(float(vertex.u()), float(quads[i][j].u() * 0.5 + 0.5));
+            QCOMPARE(float(vertex.v()), float(quads[i][j].v() * 2 + 0.25));
+        }
+    }
+}
+
+void WindowQuadArrayTest::testMakeInterleavedArrays_data()
+{
+    QTest::addColumn<uint>("type");
+    QTest::addColumn<bool>("aligned");
+
+    QTest::newRow("quads") << uint(GL_QUADS) << true;
+    QTest::newRow("quads, unaligned") << uint(GL_QUADS) << false;
+    QTest::newRow("triangles") << uint(GL_TRIANGLES) << true;
+    QTest::newRow("triangles, unaligned") << uint(GL_TRIANGLES) << false;
+}
+
+void WindowQuadArrayTest::testMakeInterleavedArrays()
+{
+    // The array must produce the same vertices as the WindowQuadList.
+    QFETCH(uint, type);
+    QFETCH(bool, aligned);
+
+    const WindowQuadList quads = makeQuads(33);
+    const WindowQuadArray array(quads);
+    const int vertexCount = quads.count() * (type == GL_QUADS ? 4 : 6);
+
+    QMatrix4x4 matrix;
+    matrix.translate(0.5, 0.25);
+    matrix.scale(1.0 / 256, 1.0 / 512);
+
+    // The buffers are over-allocated, so the data can be written at an unaligned address.
+    QVector<GLVertex2D> expected(vertexCount + 1);
+    QVector<GLVertex2D> actual(vertexCount + 1);
+    GLVertex2D *expectedData = expected.data();
+    GLVertex2D *actualData = actual.data();
+    if (!aligned) {
+        expectedData = reinterpret_cast<GLVertex2D *>(reinterpret_cast<char *>(expectedData) + sizeof(float));
+        actualData = reinterpret_cast<GLVertex2D *>(reinterpret_cast<char *>(actualData) + sizeof(float));
+    }
+
+    quads.makeInterleavedArrays(type, expectedData, matrix);
+    array.makeInterleavedArrays(type, actualData, matrix);
+
+    for (int i = 0; i < vertexCount; ++i) {
+        QCOMPARE(actualData[i].position, expectedData[i].position);
+        QVERIFY(qFuzzyCompare(actualData[i].texcoord, expectedData[i].texcoord));
+    }
+}
+
+void WindowQuadArrayTest::benchmarkMakeInterleavedArrays_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("array");
+
+    QTest::newRow("1k quads, WindowQuadList") << 1000 << false;
+    QTest::newRow("1k quads, WindowQuadArray") << 1000 << true;
+    QTest::newRow("100k quads, WindowQuadList") << 100000 << false;
+    QTest::newRow("100k quads, WindowQuadArray") << 100000 << true;
+}
+
+void WindowQuadArrayTest::benchmarkMakeInterleavedArrays()
+{
+    QFETCH(int, count);
+    QFETCH(bool, array);
+
+    const WindowQuadList quads = makeQuads(count);
+    const WindowQuadArray quadArray(quads);
+    QVector<GLVertex2D> vertices(count * 4);
+
+    QMatrix4x4 matrix;
+    matrix.scale(1.0 / 256, 1.0 / 512);
+
+    if (array) {
+        QBENCHMARK {
+            quadArray.makeInterleavedArrays(GL_QUADS, vertices.data(), matrix);
+        }
+    } else {
+        QBENCHMARK {
+            quads.makeInterleavedArrays(GL_QUADS, vertices.data(), matrix);
+        }
+    }
+}
+
+QTEST_MAIN(WindowQuadArrayTest)
+#include "windowquadarraytest.moc"
@@ -7,9 +7,14 @@
     SPDX-License-Identifier: LGPL-2.0-or-later
 */
 
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
+#include <QThread>
 
 #include "ftrace.h"
 
@@ -22,6 +27,10 @@ private Q_SLOTS:
     void benchmarkTraceOff();
     void benchmarkTraceDurationOff();
     void enable();
+    void record();
+    void recordThreads();
+    void dump();
+    void benchmarkRecord();
 
 private:
     QTemporaryFile m_tempFile;
@@ -67,6 +76,94 @@ void TestFTrace::enable()
     QCOMPARE(m_tempFile.readLine(), "TEST_DURATIONboo end_ctx=1\n");
 }
 
+void TestFTrace::record()
+{
+    KWin::FTraceLogger::self()->setEnabled(false);
+    KWin::FTraceLogger::self()->setRecording(true);
+    QVERIFY(KWin::FTraceLogger::self()->isRecording());
+
+    {
+        fTrace("RECORD", 42, QStringLiteral("bar"));
+        fTraceDuration("RECORD_DURATION", "baz");
+    }
+
+    const auto events = KWin::FTraceLogger::self()->recordedEvents(60);
+    QVERIFY(events.count() >= 3);
+    const auto last = events.mid(events.count() - 3);
+
+    QCOMPARE(last[0].second.phase, KWin::TraceEvent::Instant);
+    QCOMPARE(QByteArray(last[0].second.name, last[0].second.nameLength), QByteArrayLiteral("RECORD42bar"));
+    QCOMPARE(last[1].second.phase, KWin::TraceEvent::Begin);
+    QCOMPARE(QByteArray(last[1].second.name, last[1].second.nameLength), QByteArrayLiteral("RECORD_DURATIONbaz"));
+    QCOMPARE(last[2].second.phase, KWin::TraceEvent::End);
+    QCOMPARE(last[2].second.context, last[1].second.context);
+    QVERIFY(last[0].second.timestamp <= last[1].second.timestamp);
+    QVERIFY(last[1].second.timestamp <= last[2].second.timestamp);
+
+    // nothing must have been written into the ftrace file
+    QVERIFY(m_tempFile.readLine().isEmpty());
+}
+
+void TestFTrace::recordThreads()
+{
+    // the ring buffer wraps around and keeps only the most recent events
+    QThread *thread = QThread::create([]() {
+        for (int i = 0; i < 10000; ++i) {
+            fTrace("THREAD", i);
+        }
+    });
+    thread->start();
+    QVERIFY(thread->wait());
+    delete thread;
+
+    int count = 0;
+    QByteArray lastName;
+    const auto events = KWin::FTraceLogger::self()->recordedEvents(60);
+    for (const auto &[threadId, event] : events) {
+        const QByteArray name(event.name, event.nameLength);
+        if (name.startsWith("THREAD")) {
+            count++;
+            lastName = name;
+        }
+    }
+    QVERIFY(count > 0);
+    QVERIFY(count < 10000);
+    QCOMPARE(lastName, QByteArrayLiteral("THREAD9999"));
+}
+
+void TestFTrace::dump()
+{
+    {
+        fTraceDuration("DUMP", 1);
+    }
+
+    QTemporaryDir dir;
+    const QString fileName = dir.filePath(QStringLiteral("trace.json"));
+    QVERIFY(KWin::FTraceLogger::self()->dumpTrace(fileName, 60));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    QVERIFY(document.isObject());
+    const QJsonArray traceEvents = document.object().value(QStringLiteral("traceEvents")).toArray();
+    QVERIFY(traceEvents.count() >= 2);
+
+    const QJsonObject begin = traceEvents.at(traceEvents.count() - 2).toObject();
+    const QJsonObject end = traceEvents.at(traceEvents.count() - 1).toObject();
+    QCOMPARE(begin.value(QStringLiteral("ph")).toString(), QStringLiteral("B"));
+    QCOMPARE(begin.value(QStringLiteral("name")).toString(), QStringLiteral("DUMP1"));
+    QCOMPARE(end.value(QStringLiteral("ph")).toString(), QStringLiteral("E"));
+    QCOMPARE(begin.value(QStringLiteral("tid")), end.value(QStringLiteral("tid")));
+    QVERIFY(begin.value(QStringLiteral("ts")).toDouble() <= end.value(QStringLiteral("ts")).toDouble());
+}
+
+void TestFTrace::benchmarkRecord()
+{
+    QBENCHMARK {
+        fTraceDuration("BENCH", 123, QStringLiteral("foo"));
+    }
+}
+
 QTEST_MAIN(TestFTrace)
 
 #include "test_ftrace.moc"
@@ -0,0 +1,114 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QSignalSpy>
+#include <QTest>
+
+#include "utils/precisetimer.h"
+
+#include <algorithm>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+static std::chrono::nanoseconds currentTime()
+{
+    return std::chrono::steady_clock::now().time_since_epoch();
+}
+
+class TestPreciseTimer : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void fire();
+    void stop();
+    void restart();
+    void pastDeadline();
+    void jitter();
+};
+
+void TestPreciseTimer::fire()
+{
+    PreciseTimer timer;
+    QSignalSpy timeoutSpy(&timer, &PreciseTimer::timeout);
+
+    const std::chrono::nanoseconds deadline = currentTime() + 5ms;
+    timer.start(deadline);
+    QVERIFY(timer.isActive());
+    QCOMPARE(timer.deadline(), deadline);
+
+    QVERIFY(timeoutSpy.wait());
+    QCOMPARE(timeoutSpy.count(), 1);
+    QVERIFY(!timer.isActive());
+    QVERIFY(currentTime() >= deadline);
+}
+
+void TestPreciseTimer::stop()
+{
+    PreciseTimer timer;
+    QSignalSpy timeoutSpy(&timer, &PreciseTimer::timeout);
+
+    timer.start(currentTime() + 5ms);
+    timer.stop();
+    QVERIFY(!timer.isActive());
+    QVERIFY(!timeoutSpy.wait(50));
+}
+
+void TestPreciseTimer::restart()
+{
+    PreciseTimer timer;
+    QSignalSpy timeoutSpy(&timer, &PreciseTimer::timeout);
+
+    timer.start(currentTime() + 1s);
+    const std::chrono::nanoseconds deadline = currentTime() + 5ms;
+    timer.start(deadline);
+
+    QVERIFY(timeoutSpy.wait(100));
+    QCOMPARE(timeoutSpy.count(), 1);
+    QVERIFY(currentTime() >= deadline);
+}
+
+void TestPreciseTimer::pastDeadline()
+{
+    PreciseTimer timer;
+    QSignalSpy timeoutSpy(&timer, &PreciseTimer::timeout);
+
+    timer.start(currentTime() - 1ms);
+    QVERIFY(timeoutSpy.wait(100));
+    QCOMPARE(timeoutSpy.count(), 1);
+}
+
+void TestPreciseTimer::jitter()
+{
+    // Schedule a series of wakeups with sub-millisecond deadlines and check how late they
+    // arrive. A QTimer would round every deadline to whole milliseconds.
+    PreciseTimer timer;
+    QSignalSpy timeoutSpy(&timer, &PreciseTimer::timeout);
+
+    QVector<std::chrono::nanoseconds> lateness;
+    for (int i = 0; i < 100; ++i) {
+        const std::chrono::nanoseconds deadline = currentTime() + 2ms + std::chrono::microseconds(37 * i % 1000);
+        timer.start(deadline);
+        QVERIFY(timeoutSpy.wait(100));
+        const std::chrono::nanoseconds wakeup = currentTime();
+        QVERIFY(wakeup >= deadline);
+        lateness.append(wakeup - deadline);
+    }
+
+    std::sort(lateness.begin(), lateness.end());
+    const std::chrono::nanoseconds median = lateness[lateness.count() / 2];
+    const std::chrono::nanoseconds p90 = lateness[lateness.count() * 9 / 10];
+
+    // The bounds are loose to keep the test reliable on loaded machines.
+    QVERIFY(median < 1ms);
+    QVERIFY(p90 < 5ms);
+}
+
+QTEST_GUILESS_MAIN(TestPreciseTimer)
+#include "test_precisetimer.moc"
@@ -0,0 +1,144 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QRandomGenerator>
+#include <QTest>
+
+#include "renderjournal.h"
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class TestRenderJournal : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void empty();
+    void bucketBounds_data();
+    void bucketBounds();
+    void constant();
+    void singleOutlier();
+    void uniform();
+    void bimodal();
+    void slidingWindow();
+};
+
+// The reported percentile is the upper bound of a histogram bucket, which is at most
+// one bucket width (about 14%) larger than the exact value.
+static bool fuzzyCompare(std::chrono::nanoseconds actual, std::chrono::nanoseconds expected)
+{
+    return actual >= expected && actual <= expected * 115 / 100;
+}
+
+void TestRenderJournal::empty()
+{
+    RenderJournal journal;
+    QCOMPARE(journal.histogramSampleCount(), 0);
+    QCOMPARE(journal.percentile(50), 0ns);
+    QCOMPARE(journal.percentile(99), 0ns);
+}
+
+void TestRenderJournal::bucketBounds_data()
+{
+    QTest::addColumn<qint64>("duration");
+
+    QTest::addRow("below range") << qint64(1'000);
+    QTest::addRow("100us") << qint64(100'000);
+    QTest::addRow("1ms") << qint64(1'000'000);
+    QTest::addRow("4ms") << qint64(4'000'000);
+    QTest::addRow("16.6ms") << qint64(16'666'666);
+    QTest::addRow("above range") << qint64(10'000'000'000);
+}
+
+void TestRenderJournal::bucketBounds()
+{
+    QFETCH(qint64, duration);
+
+    const int index = RenderJournal::histogramBucketIndex(std::chrono::nanoseconds(duration));
+    QVERIFY(index >= 0);
+    QVERIFY(index < RenderJournal::histogramBucketCount);
+    if (index != 0 && index != RenderJournal::histogramBucketCount - 1) {
+        QVERIFY(RenderJournal::histogramBucketUpperBound(index - 1).count() < duration);
+        QVERIFY(RenderJournal::histogramBucketUpperBound(index).count() >= duration);
+    }
+}
+
+void TestRenderJournal::constant()
+{
+    RenderJournal journal;
+    for (int i = 0; i < 100; ++i) {
+        journal.add(4ms);
+    }
+
+    QCOMPARE(journal.histogramSampleCount(), 100);
+    QVERIFY(fuzzyCompare(journal.percentile(50), 4ms));
+    QVERIFY(fuzzyCompare(journal.percentile(90), 4ms));
+    QVERIFY(fuzzyCompare(journal.percentile(99), 4ms));
+}
+
+void TestRenderJournal::singleOutlier()
+{
+    // A single slow frame must not affect the p90 estimate, unlike the maximum.
+    RenderJournal journal;
+    for (int i = 0; i < 100; ++i) {
+        journal.add(i == 50 ? 30ms : 2ms);
+    }
+
+    QVERIFY(fuzzyCompare(journal.percentile(50), 2ms));
+    QVERIFY(fuzzyCompare(journal.percentile(90), 2ms));
+    QVERIFY(fuzzyCompare(journal.percentile(100), 30ms));
+}
+
+void TestRenderJournal::uniform()
+{
+    RenderJournal journal;
+    for (int i = 1; i <= 200; ++i) {
+        journal.add(std::chrono::microseconds(i * 50));
+    }
+
+    QVERIFY(fuzzyCompare(journal.percentile(50), 5ms));
+    QVERIFY(fuzzyCompare(journal.percentile(90), 9ms));
+    QVERIFY(fuzzyCompare(journal.percentile(99), 9900us));
+}
+
+void TestRenderJournal::bimodal()
+{
+    // 80% cheap frames and 20% expensive ones, e.g. when blur kicks in every now and then.
+    QRandomGenerator generator(42);
+    RenderJournal journal;
+    for (int i = 0; i < RenderJournal::histogramWindowSize; ++i) {
+        if (i % 5 == 0) {
+            journal.add(std::chrono::microseconds(generator.bounded(9000, 11000)));
+        } else {
+            journal.add(std::chrono::microseconds(generator.bounded(1000, 1500)));
+        }
+    }
+
+    QVERIFY(journal.percentile(50) < 2ms);
+    QVERIFY(journal.percentile(90) > 9ms);
+    QVERIFY(journal.percentile(90) < 13ms);
+}
+
+void TestRenderJournal::slidingWindow()
+{
+    // Old samples are evicted once the histogram window is full.
+    RenderJournal journal;
+    for (int i = 0; i < RenderJournal::histogramWindowSize; ++i) {
+        journal.add(10ms);
+    }
+    for (int i = 0; i < RenderJournal::histogramWindowSize; ++i) {
+        journal.add(1ms);
+    }
+
+    QCOMPARE(journal.histogramSampleCount(), RenderJournal::histogramWindowSize);
+    QVERIFY(fuzzyCompare(journal.percentile(100), 1ms));
+}
+
+QTEST_GUILESS_MAIN(TestRenderJournal)
+#include "test_renderjournal.moc"
@@ -0,0 +1,261 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QRandomGenerator>
+#include <QTest>
+
+#include "utils/tileregion.h"
+
+using namespace KWin;
+
+class TestTileRegion : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void empty();
+    void outwardRounding_data();
+    void outwardRounding();
+    void inwardRounding_data();
+    void inwardRounding();
+    void clippedToBounds();
+    void booleanOperations();
+    void toRegionMergesRows();
+    void randomRects();
+    void benchmarkOcclusion_data();
+    void benchmarkOcclusion();
+};
+
+static const QRect s_bounds(0, 0, 1920, 1080);
+
+void TestTileRegion::empty()
+{
+    TileRegion region(s_bounds);
+    QVERIFY(region.isEmpty());
+    QCOMPARE(region.tileCount(), 0);
+    QCOMPARE(region.columnCount(), 60);
+    QCOMPARE(region.rowCount(), 34);
+    QVERIFY(region.toRegion().isEmpty());
+
+    region.fill();
+    QVERIFY(!region.isEmpty());
+    QCOMPARE(region.tileCount(), 60 * 34);
+    QCOMPARE(region.toRegion(), QRegion(s_bounds));
+
+    region.clear();
+    QVERIFY(region.isEmpty());
+}
+
+void TestTileRegion::outwardRounding_data()
+{
+    QTest::addColumn<QRect>("rect");
+    QTest::addColumn<QRect>("expected");
+
+    QTest::newRow("aligned") << QRect(32, 64, 64, 32) << QRect(32, 64, 64, 32);
+    QTest::newRow("single pixel") << QRect(40, 40, 1, 1) << QRect(32, 32, 32, 32);
+    QTest::newRow("straddling") << QRect(30, 30, 4, 4) << QRect(0, 0, 64, 64);
+    QTest::newRow("bottom edge") << QRect(0, 1070, 10, 10) << QRect(0, 1056, 32, 24);
+}
+
+void TestTileRegion::outwardRounding()
+{
+    QFETCH(QRect, rect);
+    QFETCH(QRect, expected);
+
+    const TileRegion region(s_bounds, rect, TileRegion::Rounding::Outward);
+    QCOMPARE(region.toRegion(), QRegion(expected));
+}
+
+void TestTileRegion::inwardRounding_data()
+{
+    QTest::addColumn<QRect>("rect");
+    QTest::addColumn<QRect>("expected");
+
+    QTest::newRow("aligned") << QRect(32, 64, 64, 32) << QRect(32, 64, 64, 32);
+    QTest::newRow("too small") << QRect(40, 40, 20, 20) << QRect();
+    QTest::newRow("unaligned") << QRect(10, 10, 100, 100) << QRect(32, 32, 64, 64);
+    QTest::newRow("bottom edge") << QRect(0, 1056, 64, 24) << QRect(0, 1056, 64, 24);
+    QTest::newRow("whole screen") << s_bounds << s_bounds;
+}
+
+void TestTileRegion::inwardRounding()
+{
+    QFETCH(QRect, rect);
+    QFETCH(QRect, expected);
+
+    const TileRegion region(s_bounds, rect, TileRegion::Rounding::Inward);
+    QCOMPARE(region.toRegion(), QRegion(expected));
+}
+
+void TestTileRegion::clippedToBounds()
+{
+    const QRect bounds(1920, 0, 1280, 1024);
+
+    const TileRegion outside(bounds, QRect(0, 0, 1920, 1080));
+    QVERIFY(outside.isEmpty());
+
+    const TileRegion overlapping(bounds, QRect(1900, 1000, 50, 50));
+    QCOMPARE(overlapping.toRegion(), QRegion(1920, 992, 32, 32));
+}
+
+void TestTileRegion::booleanOperations()
+{
+    const TileRegion a(s_bounds, QRect(0, 0, 128, 128));
+    const TileRegion b(s_bounds, QRect(64, 64, 128, 128));
+
+    QCOMPARE((a | b).toRegion(), QRegion(0, 0, 128, 128) | QRegion(64, 64, 128, 128));
+    QCOMPARE((a - b).toRegion(), QRegion(0, 0, 128, 128) - QRegion(64, 64, 128, 128));
+    QCOMPARE((a & b).toRegion(), QRegion(64, 64, 64, 64));
+    QVERIFY((a - a).isEmpty());
+    QCOMPARE(a & a, a);
+    QVERIFY(a != b);
+}
+
+void TestTileRegion::toRegionMergesRows()
+{
+    const TileRegion region(s_bounds, QRegion(0, 0, 320, 320) | QRegion(640, 0, 320, 320));
+    QCOMPARE(region.toRegion().rectCount(), 2);
+}
+
+void TestTileRegion::randomRects()
+{
+    // Outward rounding must cover the original region and inward rounding must be covered
+    // by the original region.
+    QRandomGenerator generator(42);
+    for (int i = 0; i < 100; ++i) {
+        QRegion region;
+        for (int j = 0; j < 8; ++j) {
+            region |= QRect(generator.bounded(-100, 2000), generator.bounded(-100, 1100),
+                            generator.bounded(1, 600), generator.bounded(1, 600));
+        }
+        const QRegion clipped = region & s_bounds;
+
+        const QRegion outward = TileRegion(s_bounds, region, TileRegion::Rounding::Outward).toRegion();
+        QVERIFY((clipped - outward).isEmpty());
+        QVERIFY((outward - s_bounds).isEmpty());
+
+        const QRegion inward = TileRegion(s_bounds, region, TileRegion::Rounding::Inward).toRegion();
+        QVERIFY((inward - clipped).isEmpty());
+    }
+}
+
+struct BenchmarkWindow
+{
+    QRegion clip;
+    QRegion damage;
+    bool opaque;
+};
+
+// A stack of 40 overlapping windows, every other one is translucent.
+static QVector<BenchmarkWindow> windowStack(const QRegion &damage)
+{
+    QVector<BenchmarkWindow> windows;
+    for (int i = 0; i < 40; ++i) {
+        const QRect geometry(20 * i, 15 * i, 1000, 700);
+        const bool opaque = i % 2 == 0;
+        const QRegion clip = opaque ? QRegion(geometry) : QRegion(geometry.adjusted(10, 10, -10, -10));
+        windows.append({clip, damage & geometry, opaque});
+    }
+    return windows;
+}
+
+// Recorded damage of a single frame in typical situations.
+static QRegion damagePattern(const QString &name)
+{
+    if (name == QLatin1String("cursor blink")) {
+        return QRegion(412, 305, 2, 18);
+    } else if (name == QLatin1String("terminal")) {
+        return QRegion(10, 600, 800, 18) | QRegion(10, 618, 12, 18);
+    } else if (name == QLatin1String("video")) {
+        return QRegion(200, 150, 1280, 720);
+    } else if (name == QLatin1String("fragmented")) {
+        QRegion region;
+        QRandomGenerator generator(7);
+        for (int i = 0; i < 64; ++i) {
+            region |= QRect(generator.bounded(0, 1800), generator.bounded(0, 1000),
+                            generator.bounded(4, 120), generator.bounded(4, 60));
+        }
+        return region;
+    }
+    return QRegion();
+}
+
+void TestTileRegion::benchmarkOcclusion_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("tiled");
+
+    const QStringList patterns{
+        QStringLiteral("cursor blink"),
+        QStringLiteral("terminal"),
+        QStringLiteral("video"),
+        QStringLiteral("fragmented"),
+    };
+    for (const QString &pattern : patterns) {
+        QTest::newRow(qPrintable(pattern + QStringLiteral(" / QRegion"))) << pattern << false;
+        QTest::newRow(qPrintable(pattern + QStringLiteral(" / TileRegion"))) << pattern << true;
+    }
+}
+
+void TestTileRegion::benchmarkOcclusion()
+{
+    // Mirrors the occlusion culling pass in Scene::paintSimpleScreen().
+    QFETCH(QString, pattern);
+    QFETCH(bool, tiled);
+
+    const QVector<BenchmarkWindow> windows = windowStack(damagePattern(pattern));
+    QVector<QRegion> regions(windows.count());
+
+    if (tiled) {
+        QBENCHMARK {
+            TileRegion allclips(s_bounds);
+            TileRegion upperTranslucentDamage(s_bounds);
+            QRegion paintedArea;
+            for (int i = windows.count() - 1; i >= 0; --i) {
+                TileRegion region(s_bounds, windows[i].damage);
+                region |= upperTranslucentDamage;
+                region -= allclips;
+                if (windows[i].opaque) {
+                    const TileRegion clip(s_bounds, windows[i].clip, TileRegion::Rounding::Inward);
+                    allclips |= clip;
+                    upperTranslucentDamage |= region - clip;
+                } else {
+                    upperTranslucentDamage |= region;
+                }
+                regions[i] = region.toRegion();
+            }
+            for (const QRegion &region : qAsConst(regions)) {
+                paintedArea |= region;
+            }
+        }
+    } else {
+        QBENCHMARK {
+            QRegion allclips;
+            QRegion upperTranslucentDamage;
+            QRegion paintedArea;
+            for (int i = windows.count() - 1; i >= 0; --i) {
+                QRegion region = windows[i].damage;
+                region |= upperTranslucentDamage;
+                region -= allclips;
+                if (windows[i].opaque) {
+                    allclips |= windows[i].clip;
+                    upperTranslucentDamage |= region - windows[i].clip;
+                } else {
+                    upperTranslucentDamage |= region;
+                }
+                regions[i] = region;
+            }
+            for (const QRegion &region : qAsConst(regions)) {
+                paintedArea |= region;
+            }
+        }
+    }
+}
+
+QTEST_MAIN(TestTileRegion)
+#include "test_tileregion.moc"
@@ -146,6 +146,11 @@ RenderLoop *AbstractOutput::renderLoop() const
     return nullptr;
 }
 
+int AbstractOutput::index() const
+{
+    return m_index;
+}
+
 void AbstractOutput::inhibitDirectScanout()
 {
     m_directScanoutCount++;
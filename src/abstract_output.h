@@ -185,6 +185,16 @@ public:
      */
     virtual RenderLoop *renderLoop() const;
 
+    /**
+     * Returns the index of this output. The Platform assigns the smallest free index to an
+     * output when it appears and releases it when the output is removed, so the index can
+     * be used to store per-output data in a compact array. Returns @c -1 if no index has
+     * been assigned.
+     *
+     * @see Platform::outputSlots()
+     */
+    int index() const;
+
     void inhibitDirectScanout();
     void uninhibitDirectScanout();
 
@@ -263,7 +273,9 @@ private:
     Q_DISABLE_COPY(AbstractOutput)
     EffectScreenImpl *m_effectScreen = nullptr;
     int m_directScanoutCount = 0;
+    int m_index = -1;
     friend class EffectScreenImpl; // to access m_effectScreen
+    friend class Platform; // to access m_index
 };
 
 KWIN_EXPORT QDebug operator<<(QDebug debug, const AbstractOutput *output);
@@ -30,6 +30,7 @@
 #include "egl_dmabuf.h"
 // kwin libs
 #include <kwinglplatform.h>
+#include <kwinglutils.h>
 #include <kwineglimagetexture.h>
 // system
 #include <gbm.h>
@@ -374,6 +375,8 @@ bool EglGbmBackend::makeContextCurrent(const Output::RenderData &render) const
         qCCritical(KWIN_DRM) << "eglMakeCurrent failed:" << getEglErrorString();
         return false;
     }
+    // The shadowed GL state belongs to the context that was current before.
+    GLState::invalidate();
     if (!GLPlatform::instance()->isGLES()) {
         glDrawBuffer(GL_BACK);
     }
@@ -388,6 +391,8 @@ bool EglGbmBackend::initBufferConfigs()
         EGL_GREEN_SIZE,           1,
         EGL_BLUE_SIZE,            1,
         EGL_ALPHA_SIZE,           0,
+        // The depth buffer lets the scene reject hidden parts of opaque windows
+        EGL_DEPTH_SIZE,           options->isFrontToBackRendering() ? 16 : 0,
         EGL_RENDERABLE_TYPE,      isOpenGLES() ? EGL_OPENGL_ES2_BIT : EGL_OPENGL_BIT,
         EGL_CONFIG_CAVEAT,        EGL_NONE,
         EGL_NONE,
@@ -517,7 +522,7 @@ SurfaceTexture *EglGbmBackend::createSurfaceTextureWayland(SurfacePixmapWayland
 void EglGbmBackend::setViewport(const Output &output) const
 {
     const QSize size = output.output->sourceSize();
-    glViewport(0, 0, size.width(), size.height());
+    GLState::viewport(0, 0, size.width(), size.height());
 }
 
 QRegion EglGbmBackend::beginFrame(AbstractOutput *drmOutput)
@@ -38,15 +38,15 @@ ShadowBuffer::ShadowBuffer(const QSize &size, const GbmFormat &format)
     : m_size(size)
 {
     glGenFramebuffers(1, &m_framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
     GLRenderTarget::setKWinFramebuffer(m_framebuffer);
 
     glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    GLState::bindTexture(GL_TEXTURE_2D, m_texture);
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(format), size.width(), size.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
 
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
     if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
@@ -54,7 +54,7 @@ ShadowBuffer::ShadowBuffer(const QSize &size, const GbmFormat &format)
         return;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
     GLRenderTarget::setKWinFramebuffer(0);
 
     m_vbo.reset(new GLVertexBuffer(KWin::GLVertexBuffer::Static));
@@ -63,6 +63,8 @@ ShadowBuffer::ShadowBuffer(const QSize &size, const GbmFormat &format)
 
 ShadowBuffer::~ShadowBuffer()
 {
+    GLState::textureDeleted(m_texture);
+    GLState::framebufferDeleted(m_framebuffer);
     glDeleteTextures(1, &m_texture);
     glDeleteFramebuffers(1, &m_framebuffer);
 }
@@ -70,7 +72,7 @@ ShadowBuffer::~ShadowBuffer()
 void ShadowBuffer::render(DrmAbstractOutput *output)
 {
     const auto size = output->modeSize();
-    glViewport(0, 0, size.width(), size.height());
+    GLState::viewport(0, 0, size.width(), size.height());
     auto shader = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
 
     QMatrix4x4 mvpMatrix;
@@ -105,17 +107,17 @@ void ShadowBuffer::render(DrmAbstractOutput *output)
 
     shader->setUniform(GLShader::ModelViewProjectionMatrix, mvpMatrix);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
     GLRenderTarget::setKWinFramebuffer(0);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    GLState::bindTexture(GL_TEXTURE_2D, m_texture);
     m_vbo->render(GL_TRIANGLES);
     ShaderManager::instance()->popShader();
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
 }
 
 void ShadowBuffer::bind()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
     GLRenderTarget::setKWinFramebuffer(m_framebuffer);
 }
 
@@ -13,6 +13,7 @@
 
 // kwin libs
 #include <kwinglplatform.h>
+#include <kwinglutils.h>
 #include <kwineglimagetexture.h>
 
 #include "basiceglsurfacetexture_internal.h"
@@ -127,8 +128,10 @@ bool EglHwcomposerBackend::makeContextCurrent()
         return false;
     }
 
+    // The shadowed GL state belongs to the context that was current before.
+    GLState::invalidate();
     const QSize overall = m_backend->size();
-    glViewport(0, 0, overall.width(), overall.height());
+    GLState::viewport(0, 0, overall.width(), overall.height());
 
     return true;
 }
@@ -28,6 +28,7 @@
 
 // kwin libs
 #include <kwinglplatform.h>
+#include <kwinglutils.h>
 
 // KDE
 #include <KWayland/Client/surface.h>
@@ -245,8 +246,10 @@ bool EglWaylandBackend::makeContextCurrent(EglWaylandOutput *output)
         return false;
     }
 
+    // The shadowed GL state belongs to the context that was current before.
+    GLState::invalidate();
     const QSize size = output->m_waylandOutput->pixelSize();
-    glViewport(0, 0, size.width(), size.height());
+    GLState::viewport(0, 0, size.width(), size.height());
     return true;
 }
 
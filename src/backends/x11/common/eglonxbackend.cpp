@@ -281,7 +281,10 @@ OverlayWindow* EglOnXBackend::overlayWindow() const
 
 bool EglOnXBackend::makeContextCurrent(const EGLSurface &surface)
 {
-    return eglMakeCurrent(eglDisplay(), surface, surface, context()) == EGL_TRUE;
+    const bool current = eglMakeCurrent(eglDisplay(), surface, surface, context()) == EGL_TRUE;
+    // The shadowed GL state belongs to the context that was current before.
+    GLState::invalidate();
+    return current;
 }
 
 } // namespace
@@ -7,6 +7,7 @@
 
 #include "eglbackend.h"
 #include "kwinglplatform.h"
+#include "kwinglutils.h"
 #include "logging.h"
 #include "options.h"
 #include "overlaywindow.h"
@@ -95,7 +96,7 @@ QRegion EglBackend::beginFrame(AbstractOutput *output)
     makeCurrent();
 
     const QSize size = screens()->size();
-    glViewport(0, 0, size.width(), size.height());
+    GLState::viewport(0, 0, size.width(), size.height());
 
     QRegion repaint;
     if (supportsBufferAge()) {
@@ -746,7 +746,7 @@ QRegion GlxBackend::beginFrame(AbstractOutput *output)
     makeCurrent();
 
     const QSize size = screens()->size();
-    glViewport(0, 0, size.width(), size.height());
+    GLState::viewport(0, 0, size.width(), size.height());
 
     if (supportsBufferAge()) {
         repaint = m_damageJournal.accumulate(m_bufferAge, screens()->geometry());
@@ -801,6 +801,8 @@ bool GlxBackend::makeCurrent()
         context->doneCurrent();
     }
     const bool current = glXMakeCurrent(display(), glxWindow, ctx);
+    // The shadowed GL state belongs to the context that was current before.
+    GLState::invalidate();
     return current;
 }
 
@@ -911,7 +913,7 @@ bool GlxPixmapTexturePrivate::create(SurfacePixmapX11 *texture)
     q->setDirty();
     q->setFilter(GL_NEAREST);
 
-    glBindTexture(m_target, m_texture);
+    GLState::bindTexture(m_target, m_texture);
     glXBindTexImageEXT(m_backend->display(), m_glxPixmap, GLX_FRONT_LEFT_EXT, nullptr);
 
     updateMatrix();
@@ -17,6 +17,7 @@
 #include "x11windowed_output.h"
 // kwin libs
 #include <kwinglplatform.h>
+#include <kwinglutils.h>
 
 namespace KWin
 {
@@ -72,7 +73,7 @@ QRegion EglX11Backend::beginFrame(AbstractOutput *output)
 void EglX11Backend::setupViewport(AbstractOutput *output)
 {
     const QSize size = output->pixelSize() * output->scale();
-    glViewport(0, 0, size.width(), size.height());
+    GLState::viewport(0, 0, size.width(), size.height());
 }
 
 void EglX11Backend::endFrame(AbstractOutput *output, const QRegion &renderedRegion, const QRegion &damagedRegion)
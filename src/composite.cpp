@@ -23,6 +23,7 @@
 #include "scene.h"
 #include "scenes/opengl/scene_opengl.h"
 #include "scenes/qpainter/scene_qpainter.h"
+#include "screenlockerwatcher.h"
 #include "screens.h"
 #include "shadow.h"
 #include "surfaceitem_x11.h"
@@ -40,6 +41,7 @@
 #include <KWaylandServer/surface_interface.h>
 
 #include <KGlobalAccel>
+#include <KScreenLocker/KsldApp>
 #include <KLocalizedString>
 #include <KNotification>
 #include <KSelectionOwner>
@@ -129,6 +131,12 @@ Compositor::Compositor(QObject* workspace)
     connect(&m_unusedSupportPropertyTimer, &QTimer::timeout,
             this, &Compositor::deleteUnusedSupportProperties);
 
+    // Clients whose frame callbacks are withheld wait for them before they commit again, so
+    // nothing else might trigger the frame that sends them.
+    m_occludedFrameCallbackTimer.setSingleShot(true);
+    connect(&m_occludedFrameCallbackTimer, &QTimer::timeout,
+            this, &Compositor::scheduleRepaint);
+
     // Delay the call to start by one event cycle.
     // The ctor of this class is invoked from the Workspace ctor, that means before
     // Workspace is completely constructed, so calling Workspace::self() would result
@@ -387,6 +395,18 @@ void Compositor::startupWithWorkspace()
     // Sets also the 'effects' pointer.
     kwinApp()->platform()->createEffectsHandler(this, m_scene);
 
+    connect(Workspace::self(), &Workspace::xStackingOrderChanged,
+            this, &Compositor::invalidateWindowsToRender, Qt::UniqueConnection);
+    connect(static_cast<EffectsHandlerImpl *>(effects), &EffectsHandlerImpl::elevatedWindowsChanged,
+            this, &Compositor::invalidateWindowsToRender);
+    connect(ScreenLockerWatcher::self(), &ScreenLockerWatcher::locked,
+            this, &Compositor::invalidateWindowsToRender, Qt::UniqueConnection);
+    if (waylandServer() && waylandServer()->hasScreenLockerIntegration()) {
+        connect(ScreenLocker::KSldApp::self(), &ScreenLocker::KSldApp::lockStateChanged,
+                this, &Compositor::invalidateWindowsToRender, Qt::UniqueConnection);
+    }
+    invalidateWindowsToRender();
+
     Q_EMIT compositingToggled(true);
 
     if (m_releaseSelectionTimer.isActive()) {
@@ -444,6 +464,9 @@ void Compositor::stop()
     delete effects;
     effects = nullptr;
 
+    m_windowsToRender.clear();
+    m_windowsToRenderDirty = true;
+
     if (Workspace::self()) {
         for (X11Client *c : Workspace::self()->clientList()) {
             m_scene->removeToplevel(c);
@@ -578,20 +601,59 @@ void Compositor::reinitialize()
 
 void Compositor::handleFrameRequested(RenderLoop *renderLoop)
 {
+    if (options->isOutputDeadlineScheduling()) {
+        dispatchEarlierDeadlines(renderLoop);
+    }
     composite(renderLoop);
 }
 
+// All outputs are composited on the main thread, so a long compositing cycle on one output
+// can make another output miss its deadline if that output's compositing cycle is supposed
+// to start while the first one is still rendering. In that case, the output that presents
+// earlier is rendered first, even though its timer has not fired yet.
+void Compositor::dispatchEarlierDeadlines(RenderLoop *renderLoop)
+{
+    const std::chrono::nanoseconds currentTime(std::chrono::steady_clock::now().time_since_epoch());
+    const std::chrono::nanoseconds renderEnd = currentTime + renderLoop->expectedRenderTime();
+
+    QVector<RenderLoop *> blocked;
+    for (auto it = m_renderLoops.constBegin(); it != m_renderLoops.constEnd(); ++it) {
+        RenderLoop *other = it.key();
+        if (other == renderLoop) {
+            continue;
+        }
+        const std::chrono::nanoseconds nextRenderTimestamp = other->nextRenderTimestamp();
+        if (nextRenderTimestamp == std::chrono::nanoseconds::zero() || nextRenderTimestamp >= renderEnd) {
+            continue;
+        }
+        if (other->nextPresentationTimestamp() < renderLoop->nextPresentationTimestamp()) {
+            blocked.append(other);
+        }
+    }
+
+    std::sort(blocked.begin(), blocked.end(), [](RenderLoop *a, RenderLoop *b) {
+        return a->nextPresentationTimestamp() < b->nextPresentationTimestamp();
+    });
+    for (RenderLoop *other : qAsConst(blocked)) {
+        other->dispatchScheduledFrame();
+    }
+}
+
 QList<Toplevel *> Compositor::windowsToRender() const
 {
-    // Create a list of all windows in the stacking order
-    QList<Toplevel *> windows = Workspace::self()->xStackingOrder();
+    if (!m_windowsToRenderDirty) {
+        return m_windowsToRender;
+    }
+    m_windowsToRenderDirty = false;
+    m_windowsToRender.clear();
 
-    // Move elevated windows to the top of the stacking order
+    const QList<Toplevel *> stackingOrder = Workspace::self()->xStackingOrder();
     const QList<EffectWindow *> elevatedList = static_cast<EffectsHandlerImpl *>(effects)->elevatedWindows();
+
+    QSet<Toplevel *> elevatedWindows;
+    elevatedWindows.reserve(elevatedList.count());
     for (EffectWindow *c : elevatedList) {
-        Toplevel *t = static_cast<EffectWindowImpl *>(c)->window();
-        windows.removeAll(t);
-        windows.append(t);
+        elevatedWindows.insert(static_cast<EffectWindowImpl *>(c)->window());
     }
 
     // Skip windows that are not yet ready for being painted and if screen is locked skip windows
@@ -600,17 +662,38 @@ QList<Toplevel *> Compositor::windowsToRender() const
     // TODO? This cannot be used so carelessly - needs protections against broken clients, the
     // window should not get focus before it's displayed, handle unredirected windows properly and
     // so on.
-    for (Toplevel *win : windows) {
+    const bool screenLocked = waylandServer() && waylandServer()->isScreenLocked();
+    auto shouldRender = [screenLocked](Toplevel *win) {
         if (!win->readyForPainting()) {
-            windows.removeAll(win);
+            return false;
         }
-        if (waylandServer() && waylandServer()->isScreenLocked()) {
-            if(!win->isLockScreen() && !win->isInputMethod()) {
-                windows.removeAll(win);
-            }
+        if (screenLocked && !win->isLockScreen() && !win->isInputMethod()) {
+            return false;
+        }
+        return true;
+    };
+
+    m_windowsToRender.reserve(stackingOrder.count());
+    for (Toplevel *win : stackingOrder) {
+        if (!elevatedWindows.contains(win) && shouldRender(win)) {
+            m_windowsToRender.append(win);
+        }
+    }
+
+    // Move elevated windows to the top of the stacking order
+    for (EffectWindow *c : elevatedList) {
+        Toplevel *win = static_cast<EffectWindowImpl *>(c)->window();
+        if (shouldRender(win)) {
+            m_windowsToRender.append(win);
         }
     }
-    return windows;
+
+    return m_windowsToRender;
+}
+
+void Compositor::invalidateWindowsToRender()
+{
+    m_windowsToRenderDirty = true;
 }
 
 void Compositor::composite(RenderLoop *renderLoop)
@@ -648,6 +731,9 @@ void Compositor::composite(RenderLoop *renderLoop)
                 continue;
             }
             if (auto surface = window->surface()) {
+                if (throttleFrameCallback(surface, m_scene->isOccluded(window), frameTime)) {
+                    continue;
+                }
                 surface->frameRendered(frameTime.count());
             }
         }
@@ -660,6 +746,42 @@ void Compositor::composite(RenderLoop *renderLoop)
     }
 }
 
+// Windows that are completely covered by opaque windows still receive frame callbacks, but
+// only at the rate specified by Options::occludedWindowFrameRate(), so they keep making
+// progress without rendering at full refresh rate.
+bool Compositor::throttleFrameCallback(KWaylandServer::SurfaceInterface *surface, bool occluded,
+                                       std::chrono::milliseconds frameTime)
+{
+    static const std::chrono::milliseconds visible(-1);
+
+    auto it = m_occludedFrameCallbacks.find(surface);
+    if (!occluded || !options->occludedWindowFrameRate()) {
+        if (it != m_occludedFrameCallbacks.end()) {
+            *it = visible;
+        }
+        return false;
+    }
+
+    if (it == m_occludedFrameCallbacks.end()) {
+        connect(surface, &QObject::destroyed, this, [this, surface]() {
+            m_occludedFrameCallbacks.remove(surface);
+        });
+        m_occludedFrameCallbacks.insert(surface, frameTime);
+        return false;
+    }
+
+    const std::chrono::milliseconds interval(1000 / options->occludedWindowFrameRate());
+    if (*it != visible && frameTime - *it < interval) {
+        const std::chrono::milliseconds remaining = interval - (frameTime - *it);
+        if (!m_occludedFrameCallbackTimer.isActive() || m_occludedFrameCallbackTimer.remainingTimeAsDuration() > remaining) {
+            m_occludedFrameCallbackTimer.start(remaining);
+        }
+        return true;
+    }
+    *it = frameTime;
+    return false;
+}
+
 bool Compositor::isActive()
 {
     return m_state == State::On;
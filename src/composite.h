@@ -15,6 +15,13 @@
 #include <QTimer>
 #include <QRegion>
 
+#include <chrono>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+}
+
 namespace KWin
 {
 
@@ -85,6 +92,11 @@ public:
     void keepSupportProperty(xcb_atom_t atom);
     void removeSupportProperty(xcb_atom_t atom);
     QList<Toplevel *> windowsToRender() const;
+    /**
+     * Marks the list returned by windowsToRender() as outdated. It will be rebuilt
+     * the next time it is requested.
+     */
+    void invalidateWindowsToRender();
 
 Q_SIGNALS:
     void compositingToggled(bool active);
@@ -130,11 +142,15 @@ private:
     void deleteUnusedSupportProperties();
 
     void registerRenderLoop(RenderLoop *renderLoop, AbstractOutput *output);
+    void dispatchEarlierDeadlines(RenderLoop *renderLoop);
     void unregisterRenderLoop(RenderLoop *renderLoop);
 
     bool attemptOpenGLCompositing();
     bool attemptQPainterCompositing();
 
+    bool throttleFrameCallback(KWaylandServer::SurfaceInterface *surface, bool occluded,
+                               std::chrono::milliseconds frameTime);
+
     State m_state = State::Off;
     CompositorSelectionOwner *m_selectionOwner = nullptr;
     QTimer m_releaseSelectionTimer;
@@ -143,6 +159,10 @@ private:
     Scene *m_scene = nullptr;
     RenderBackend *m_backend = nullptr;
     QMap<RenderLoop *, AbstractOutput *> m_renderLoops;
+    QHash<KWaylandServer::SurfaceInterface *, std::chrono::milliseconds> m_occludedFrameCallbacks;
+    QTimer m_occludedFrameCallbackTimer;
+    mutable QList<Toplevel *> m_windowsToRender;
+    mutable bool m_windowsToRenderDirty = true;
 };
 
 class KWIN_EXPORT WaylandCompositor final : public Compositor
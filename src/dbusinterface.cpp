@@ -15,6 +15,7 @@
 
 // kwin
 #include "abstract_client.h"
+#include "abstract_output.h"
 #include "atoms.h"
 #include "composite.h"
 #include "debug_console.h"
@@ -23,6 +24,7 @@
 #include "platform.h"
 #include "pluginmanager.h"
 #include "renderbackend.h"
+#include "renderloop_p.h"
 #include "kwinadaptor.h"
 #include "unmanaged.h"
 #include "workspace.h"
@@ -330,6 +332,24 @@ void CompositorDBusInterface::reinitialize()
     m_compositor->reinitialize();
 }
 
+QVariantMap CompositorDBusInterface::renderTimeStatistics(const QString &outputName) const
+{
+    const AbstractOutput *output = kwinApp()->platform()->findOutput(outputName);
+    if (!output || !output->renderLoop()) {
+        return {};
+    }
+    const RenderJournal &journal = RenderLoopPrivate::get(output->renderLoop())->renderJournal;
+    return QVariantMap{
+        {QStringLiteral("minimum"), qlonglong(journal.minimum().count())},
+        {QStringLiteral("maximum"), qlonglong(journal.maximum().count())},
+        {QStringLiteral("average"), qlonglong(journal.average().count())},
+        {QStringLiteral("p50"), qlonglong(journal.percentile(50).count())},
+        {QStringLiteral("p90"), qlonglong(journal.percentile(90).count())},
+        {QStringLiteral("p99"), qlonglong(journal.percentile(99).count())},
+        {QStringLiteral("samples"), journal.histogramSampleCount()},
+    };
+}
+
 QStringList CompositorDBusInterface::supportedOpenGLPlatformInterfaces() const
 {
     QStringList interfaces;
@@ -193,6 +193,15 @@ public Q_SLOTS:
      */
     void reinitialize();
 
+    /**
+     * @brief Returns render time statistics of the output with the given @p outputName.
+     *
+     * The returned map contains the minimum, maximum, average, p50, p90 and p99 render
+     * times in nanoseconds, as well as the number of samples they are computed from. An
+     * empty map is returned if there is no such output.
+     */
+    QVariantMap renderTimeStatistics(const QString &outputName) const;
+
 Q_SIGNALS:
     void compositingToggled(bool active);
 
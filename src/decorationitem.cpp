@@ -223,10 +223,10 @@ WindowQuad buildQuad(const QRect &partRect, const QPoint &textureOffset,
     return quad;
 }
 
-WindowQuadList DecorationItem::buildQuads() const
+WindowQuadArray DecorationItem::buildQuads() const
 {
     if (m_window->frameMargins().isNull()) {
-        return WindowQuadList();
+        return WindowQuadArray();
     }
 
     QRect left, top, right, bottom;
@@ -248,7 +248,7 @@ WindowQuadList DecorationItem::buildQuads() const
     const QPoint leftPosition(0, bottomPosition.y() + bottomHeight + (2 * texturePad));
     const QPoint rightPosition(0, leftPosition.y() + leftWidth + (2 * texturePad));
 
-    WindowQuadList list;
+    WindowQuadArray list;
     if (left.isValid()) {
         list.append(buildQuad(left, leftPosition, devicePixelRatio, true));
     }
@@ -88,7 +88,7 @@ private Q_SLOTS:
 
 protected:
     void preprocess() override;
-    WindowQuadList buildQuads() const override;
+    WindowQuadArray buildQuads() const override;
 
 private:
     Toplevel *m_window;
@@ -183,7 +183,18 @@ EffectsHandlerImpl::EffectsHandlerImpl(Compositor *compositor, Scene *scene)
     connect(ws, &Workspace::deletedRemoved, this,
         [this](KWin::Deleted *d) {
             Q_EMIT windowDeleted(d->effectWindow());
-            elevated_windows.removeAll(d->effectWindow());
+            if (elevated_windows.removeAll(d->effectWindow())) {
+                Q_EMIT elevatedWindowsChanged();
+            }
+            for (auto it = m_windowInterests.begin(); it != m_windowInterests.end();) {
+                it->remove(d->effectWindow());
+                if (it->isEmpty()) {
+                    it = m_windowInterests.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            m_windowEffectMasks.remove(d->effectWindow());
         }
     );
     connect(ws->sessionManager(), &SessionManager::stateChanged, this,
@@ -418,22 +429,63 @@ void EffectsHandlerImpl::postPaintScreen()
     // no special final code
 }
 
+EffectsHandlerImpl::EffectsIterator EffectsHandlerImpl::nextEffect(EffectsIterator it, EffectWindow *w)
+{
+    if (!m_selectiveEffects) {
+        return it;
+    }
+    const quint64 mask = windowEffectMask(w);
+    const EffectsIterator end = m_activeEffects.constEnd();
+    for (; it != end; ++it) {
+        const int index = it - m_activeEffects.constBegin();
+        if (index >= 64 || (mask & (quint64(1) << index))) {
+            break;
+        }
+    }
+    return it;
+}
+
+quint64 EffectsHandlerImpl::windowEffectMask(EffectWindow *w)
+{
+    auto it = m_windowEffectMasks.constFind(w);
+    if (it != m_windowEffectMasks.constEnd()) {
+        return *it;
+    }
+
+    quint64 mask = ~m_selectiveEffects;
+    for (int i = 0; i < m_activeEffects.count() && i < 64; ++i) {
+        if (!(m_selectiveEffects & (quint64(1) << i))) {
+            continue;
+        }
+        auto interests = m_windowInterests.constFind(m_activeEffects.at(i));
+        if (interests != m_windowInterests.constEnd() && interests->contains(w)) {
+            mask |= quint64(1) << i;
+        }
+    }
+    m_windowEffectMasks.insert(w, mask);
+    return mask;
+}
+
 void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, std::chrono::milliseconds presentTime)
 {
+    const EffectsIterator current = m_currentPaintWindowIterator;
+    m_currentPaintWindowIterator = nextEffect(current, w);
     if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
         (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, presentTime);
-        --m_currentPaintWindowIterator;
     }
+    m_currentPaintWindowIterator = current;
     // no special final code
 }
 
 void EffectsHandlerImpl::paintWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
+    const EffectsIterator current = m_currentPaintWindowIterator;
+    m_currentPaintWindowIterator = nextEffect(current, w);
     if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
         (*m_currentPaintWindowIterator++)->paintWindow(w, mask, region, data);
-        --m_currentPaintWindowIterator;
     } else
         m_scene->finalPaintWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
+    m_currentPaintWindowIterator = current;
 }
 
 void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, const QRegion &region, double opacity, double frameOpacity)
@@ -449,10 +501,12 @@ void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, const QRegion &reg
 
 void EffectsHandlerImpl::postPaintWindow(EffectWindow* w)
 {
+    const EffectsIterator current = m_currentPaintWindowIterator;
+    m_currentPaintWindowIterator = nextEffect(current, w);
     if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
         (*m_currentPaintWindowIterator++)->postPaintWindow(w);
-        --m_currentPaintWindowIterator;
     }
+    m_currentPaintWindowIterator = current;
     // no special final code
 }
 
@@ -466,11 +520,13 @@ Effect *EffectsHandlerImpl::provides(Effect::Feature ef)
 
 void EffectsHandlerImpl::drawWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
+    const EffectsIterator current = m_currentDrawWindowIterator;
+    m_currentDrawWindowIterator = nextEffect(current, w);
     if (m_currentDrawWindowIterator != m_activeEffects.constEnd()) {
         (*m_currentDrawWindowIterator++)->drawWindow(w, mask, region, data);
-        --m_currentDrawWindowIterator;
     } else
         m_scene->finalDrawWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
+    m_currentDrawWindowIterator = current;
 }
 
 bool EffectsHandlerImpl::hasDecorationShadows() const
@@ -493,8 +549,13 @@ void EffectsHandlerImpl::startPaint()
 {
     m_activeEffects.clear();
     m_activeEffects.reserve(loaded_effects.count());
+    m_selectiveEffects = 0;
+    m_windowEffectMasks.clear();
     for(QVector< KWin::EffectPair >::const_iterator it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
         if (it->second->isActive()) {
+            if (m_activeEffects.count() < 64 && it->second->declaresWindowInterest()) {
+                m_selectiveEffects |= quint64(1) << m_activeEffects.count();
+            }
             m_activeEffects << it->second;
         }
     }
@@ -1142,6 +1203,25 @@ void EffectsHandlerImpl::setElevatedWindow(KWin::EffectWindow* w, bool set)
     elevated_windows.removeAll(w);
     if (set)
         elevated_windows.append(w);
+    Q_EMIT elevatedWindowsChanged();
+}
+
+void EffectsHandlerImpl::setWindowInterest(Effect *effect, EffectWindow *w, bool interested)
+{
+    if (interested) {
+        m_windowInterests[effect].insert(w);
+    } else {
+        auto it = m_windowInterests.find(effect);
+        if (it == m_windowInterests.end()) {
+            return;
+        }
+        it->remove(w);
+        if (it->isEmpty()) {
+            m_windowInterests.erase(it);
+        }
+    }
+    // The window may be painted again in this pass, e.g. as a thumbnail
+    m_windowEffectMasks.remove(w);
 }
 
 void EffectsHandlerImpl::setTabBoxWindow(EffectWindow* w)
@@ -1450,6 +1530,8 @@ void EffectsHandlerImpl::destroyEffect(Effect *effect)
         removeSupportProperty(property, effect);
     }
 
+    m_windowInterests.remove(effect);
+
     delete effect;
 }
 
@@ -1516,6 +1598,8 @@ void EffectsHandlerImpl::effectsChanged()
 {
     loaded_effects.clear();
     m_activeEffects.clear(); // it's possible to have a reconfigure and a quad rebuild between two paint cycles - bug #308201
+    m_selectiveEffects = 0;
+    m_windowEffectMasks.clear();
 
     loaded_effects.reserve(effect_order.count());
     std::copy(effect_order.constBegin(), effect_order.constEnd(),
@@ -16,6 +16,7 @@
 #include "scene.h"
 
 #include <QHash>
+#include <QSet>
 #include <Plasma/FrameSvg>
 
 #include <memory>
@@ -124,6 +125,7 @@ public:
     EffectWindow *findWindow(const QUuid &id) const override;
     EffectWindowList stackingOrder() const override;
     void setElevatedWindow(KWin::EffectWindow* w, bool set) override;
+    void setWindowInterest(Effect *effect, EffectWindow *w, bool interested) override;
 
     void setTabBoxWindow(EffectWindow*) override;
     void setTabBoxDesktop(int) override;
@@ -196,6 +198,10 @@ public:
     void unloadAllEffects();
 
     QList<EffectWindow*> elevatedWindows() const;
+    /**
+     * Returns @c true if at least one effect takes part in painting the current frame.
+     */
+    bool hasActiveEffects() const;
     QStringList activeEffects() const;
 
     /**
@@ -291,6 +297,12 @@ public Q_SLOTS:
     Q_SCRIPTABLE QString supportInformation(const QString& name) const;
     Q_SCRIPTABLE QString debug(const QString& name, const QString& parameter = QString()) const;
 
+Q_SIGNALS:
+    /**
+     * This signal is emitted when a window gets elevated or stops being elevated.
+     */
+    void elevatedWindowsChanged();
+
 protected Q_SLOTS:
     void slotClientShown(KWin::Toplevel*);
     void slotUnmanagedShown(KWin::Toplevel*);
@@ -347,11 +359,19 @@ private:
 
     typedef QVector< Effect*> EffectsList;
     typedef EffectsList::const_iterator EffectsIterator;
+    EffectsIterator nextEffect(EffectsIterator it, EffectWindow *w);
+    quint64 windowEffectMask(EffectWindow *w);
+
     EffectsList m_activeEffects;
     EffectsIterator m_currentDrawWindowIterator;
     EffectsIterator m_currentPaintWindowIterator;
     EffectsIterator m_currentPaintEffectFrameIterator;
     EffectsIterator m_currentPaintScreenIterator;
+    // Bit i is set if m_activeEffects[i] is only called for the windows it has an interest in
+    quint64 m_selectiveEffects = 0;
+    // The bits of the active effects that are called for a window, computed once per painting pass
+    QHash<EffectWindow *, quint64> m_windowEffectMasks;
+    QHash<Effect *, QSet<EffectWindow *>> m_windowInterests;
     typedef QHash< QByteArray, QList< Effect*> > PropertyEffectMap;
     PropertyEffectMap m_propertiesForEffects;
     QHash<QByteArray, qulonglong> m_managedProperties;
@@ -629,6 +649,12 @@ QList<EffectWindow*> EffectsHandlerImpl::elevatedWindows() const
     return elevated_windows;
 }
 
+inline
+bool EffectsHandlerImpl::hasActiveEffects() const
+{
+    return !m_activeEffects.isEmpty();
+}
+
 inline
 xcb_window_t EffectsHandlerImpl::x11RootWindow() const
 {
@@ -472,7 +472,12 @@ void ContrastEffect::doContrast(EffectWindow *w, const QRegion& shape, const QRe
     const QRegion actualShape = shape & screen;
     const QRect r = actualShape.boundingRect();
 
-    qreal scale = GLRenderTarget::virtualScreenScale();
+    // Copy the area in the back buffer that we're going to sample, unless another effect
+    // already did so
+    GLTexture *backdrop = GLBackdrop::instance()->grab(r);
+    if (!backdrop) {
+        return;
+    }
 
     // Upload geometry for the horizontal and vertical passes
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
@@ -480,16 +485,7 @@ void ContrastEffect::doContrast(EffectWindow *w, const QRegion& shape, const QRe
     uploadGeometry(vbo, actualShape);
     vbo->bindArrays();
 
-    // Create a scratch texture and copy the area in the back buffer that we're
-    // going to blur into it
-    GLTexture scratch(GL_RGBA8, r.width() * scale, r.height() * scale);
-    scratch.setFilter(GL_LINEAR);
-    scratch.setWrapMode(GL_CLAMP_TO_EDGE);
-    scratch.bind();
-
-    const QRect sg = GLRenderTarget::virtualScreenGeometry();
-    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (r.x() - sg.x()) * scale, (sg.height() - (r.y() - sg.y() + r.height())) * scale,
-                        scratch.width(), scratch.height());
+    backdrop->bind();
 
     // Draw the texture on the offscreen framebuffer object, while blurring it horizontally
 
@@ -499,25 +495,29 @@ void ContrastEffect::doContrast(EffectWindow *w, const QRegion& shape, const QRe
 
     shader->setOpacity(opacity);
     // Set up the texture matrix to transform from screen coordinates
-    // to texture coordinates.
+    // to texture coordinates. The backdrop holds the output the way it
+    // is laid out in the framebuffer.
+    const QRect sg = GLRenderTarget::virtualScreenGeometry();
+    const QSize backdropSize = sg.size();
     QMatrix4x4 textureMatrix;
-    textureMatrix.scale(1.0 / r.width(), -1.0 / r.height(), 1);
-    textureMatrix.translate(-r.x(), -r.height() - r.y(), 0);
+    textureMatrix.scale(1.0 / backdropSize.width(), -1.0 / backdropSize.height(), 1);
+    textureMatrix.translate(-sg.x(), -sg.height() - sg.y(), 0);
     shader->setTextureMatrix(textureMatrix);
     shader->setModelViewProjectionMatrix(screenProjection);
 
     vbo->draw(GL_TRIANGLES, 0, actualShape.rectCount() * 6);
 
-    scratch.unbind();
-    scratch.discard();
+    backdrop->unbind();
 
     vbo->unbindArrays();
 
     if (opacity < 1.0) {
-        glDisable(GL_BLEND);
+        GLState::disable(GL_BLEND);
     }
 
     shader->unbind();
+
+    GLBackdrop::instance()->invalidate(actualShape);
 }
 
 bool ContrastEffect::isActive() const
@@ -34,6 +34,7 @@ KWaylandServer::BlurManagerInterface *BlurEffect::s_blurManager = nullptr;
 QTimer *BlurEffect::s_blurManagerRemoveTimer = nullptr;
 
 BlurEffect::BlurEffect()
+    : m_blurCacheEnabled(qgetenv("KWIN_BLUR_CACHE") != QByteArrayLiteral("0"))
 {
     initConfig<BlurConfig>();
     m_shader = new BlurShader(this);
@@ -67,6 +68,21 @@ BlurEffect::BlurEffect()
     connect(effects, &EffectsHandler::windowDeleted, this, &BlurEffect::slotWindowDeleted);
     connect(effects, &EffectsHandler::propertyNotify, this, &BlurEffect::slotPropertyNotify);
     connect(effects, &EffectsHandler::virtualScreenGeometryChanged, this, &BlurEffect::slotScreenGeometryChanged);
+    connect(effects, &EffectsHandler::screenRemoved, this, &BlurEffect::slotScreenRemoved);
+
+    // These change what is behind other windows without damaging a window
+    connect(effects, &EffectsHandler::windowClosed, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::windowShown, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::windowHidden, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::windowMinimized, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::windowUnminimized, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::windowActivated, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::windowFrameGeometryChanged, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::windowExpandedGeometryChanged, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::windowOpacityChanged, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::stackingOrderChanged, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::desktopChanged, this, &BlurEffect::invalidateBlurCache);
+    connect(effects, &EffectsHandler::showingDesktopChanged, this, &BlurEffect::invalidateBlurCache);
     connect(effects, &EffectsHandler::xcbConnectionChanged, this,
         [this] {
             if (m_shader && m_shader->isValid() && m_renderTargetsValid) {
@@ -106,18 +122,21 @@ void BlurEffect::slotScreenGeometryChanged()
 
 bool BlurEffect::renderTargetsValid() const
 {
-    return !m_renderTargets.isEmpty() && std::find_if(m_renderTargets.cbegin(), m_renderTargets.cend(),
-        [](const GLRenderTarget *target) {
-            return !target->valid();
-        }) == m_renderTargets.cend();
+    // The pool only hands out complete render targets
+    return m_pooledTargets.count() == m_downSampleIterations + 1;
 }
 
 void BlurEffect::deleteFBOs()
 {
-    qDeleteAll(m_renderTargets);
+    invalidateBlurCache();
 
     m_renderTargets.clear();
     m_renderTextures.clear();
+
+    for (GLRenderTargetPool::Target *target : qAsConst(m_pooledTargets)) {
+        GLRenderTargetPool::instance()->release(target);
+    }
+    m_pooledTargets.clear();
 }
 
 void BlurEffect::updateTexture()
@@ -127,20 +146,21 @@ void BlurEffect::updateTexture()
     /* Reserve memory for:
      *  - The original sized texture (1)
      *  - The downsized textures (m_downSampleIterations)
-     *  - The helper texture (1)
+     *
+     * The screen contents are sampled from the shared backdrop.
      */
-    m_renderTargets.reserve(m_downSampleIterations + 2);
-    m_renderTextures.reserve(m_downSampleIterations + 2);
+    m_renderTargets.reserve(m_downSampleIterations + 1);
+    m_renderTextures.reserve(m_downSampleIterations + 1);
+    m_pooledTargets.reserve(m_downSampleIterations + 1);
 
     GLenum textureFormat = GL_RGBA8;
 
     // Check the color encoding of the default framebuffer
     if (!GLPlatform::instance()->isGLES()) {
-        GLuint prevFbo = 0;
-        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, reinterpret_cast<GLint *>(&prevFbo));
+        const GLuint prevFbo = GLState::drawFramebuffer();
 
         if (prevFbo != 0) {
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
         }
 
         GLenum colorEncoding = GL_LINEAR;
@@ -149,7 +169,7 @@ void BlurEffect::updateTexture()
                                               reinterpret_cast<GLint *>(&colorEncoding));
 
         if (prevFbo != 0) {
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prevFbo);
+            GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, prevFbo);
         }
 
         if (colorEncoding == GL_SRGB) {
@@ -157,25 +177,26 @@ void BlurEffect::updateTexture()
         }
     }
 
-    for (int i = 0; i <= m_downSampleIterations; i++) {
-        m_renderTextures.append(GLTexture(textureFormat, effects->virtualScreenSize() / (1 << i)));
-        m_renderTextures.last().setFilter(GL_LINEAR);
-        m_renderTextures.last().setWrapMode(GL_CLAMP_TO_EDGE);
+    auto acquire = [this, textureFormat](const QSize &size) {
+        GLRenderTargetPool::Target *target = GLRenderTargetPool::instance()->acquire(size, textureFormat);
+        if (target) {
+            m_pooledTargets.append(target);
+            m_renderTextures.append(*target->texture());
+            m_renderTargets.append(target->renderTarget());
+        }
+    };
 
-        m_renderTargets.append(new GLRenderTarget(m_renderTextures.last()));
+    for (int i = 0; i <= m_downSampleIterations; i++) {
+        acquire(effects->virtualScreenSize() / (1 << i));
     }
 
-    // This last set is used as a temporary helper texture
-    m_renderTextures.append(GLTexture(textureFormat, effects->virtualScreenSize()));
-    m_renderTextures.last().setFilter(GL_LINEAR);
-    m_renderTextures.last().setWrapMode(GL_CLAMP_TO_EDGE);
-
-    m_renderTargets.append(new GLRenderTarget(m_renderTextures.last()));
-
     m_renderTargetsValid = renderTargetsValid();
 
     // Prepare the stack for the rendering
     m_renderTargetStack.clear();
+    if (!m_renderTargetsValid) {
+        return;
+    }
     m_renderTargetStack.reserve(m_downSampleIterations * 2);
 
     // Upsample
@@ -335,10 +356,20 @@ void BlurEffect::slotWindowAdded(EffectWindow *w)
     }
 
     updateBlurRegion(w);
+    invalidateBlurCache();
 }
 
 void BlurEffect::slotWindowDeleted(EffectWindow *w)
 {
+    auto cache = m_blurCache.find(w);
+    if (cache != m_blurCache.end()) {
+        for (BlurCacheEntry &entry : *cache) {
+            releaseBlurCache(entry);
+        }
+        m_blurCache.erase(cache);
+    }
+    m_windowPaintStates.remove(w);
+
     auto it = windowBlurChangedConnections.find(w);
     if (it == windowBlurChangedConnections.end()) {
         return;
@@ -492,8 +523,17 @@ void BlurEffect::prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseco
 {
     m_paintedArea = QRegion();
     m_currentBlur = QRegion();
+    m_changedArea = QRegion();
+    m_damagedArea = QRegion();
+    m_currentScreen = data.screen;
 
     effects->prePaintScreen(data, presentTime);
+
+    // A transformed screen moves everything that is behind the windows
+    m_blurCacheUsable = m_blurCacheEnabled && !(data.mask & PAINT_SCREEN_TRANSFORMED);
+    if (!m_blurCacheUsable) {
+        invalidateBlurCache();
+    }
 }
 
 void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, std::chrono::milliseconds presentTime)
@@ -502,6 +542,19 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, std::
 
     effects->prePaintWindow(w, data, presentTime);
 
+    // Anything that is repainted underneath a window changes its background, not only
+    // the contents of the surfaces, but also decorations, shadows and the like
+    if (m_blurCacheUsable) {
+        auto cache = m_blurCache.find(w);
+        if (cache != m_blurCache.end()) {
+            auto entry = cache->find(m_currentScreen);
+            if (entry != cache->end()) {
+                entry->damage |= m_damagedArea & entry->expandedShape;
+            }
+        }
+        m_damagedArea |= data.damage;
+    }
+
     if (!w->isPaintingEnabled()) {
         return;
     }
@@ -573,8 +626,34 @@ bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintDa
     return true;
 }
 
+void BlurEffect::updateChangedArea(EffectWindow *w, int mask, const WindowPaintData &data)
+{
+    const bool transformed = (mask & PAINT_WINDOW_TRANSFORMED) || data.xTranslation() || data.yTranslation()
+        || data.xScale() != 1 || data.yScale() != 1;
+    const WindowPaintState state{data.opacity(), data.brightness(), data.saturation(), transformed};
+
+    QHash<EffectScreen *, WindowPaintState> &states = m_windowPaintStates[w];
+    auto it = states.find(m_currentScreen);
+    if (it == states.end()) {
+        states.insert(m_currentScreen, state);
+        m_changedArea |= w->expandedGeometry();
+        return;
+    }
+
+    // A window that is or was transformed can be anywhere on the screen
+    if (state.transformed || it->transformed) {
+        m_changedArea |= effects->virtualScreenGeometry();
+    } else if (state.opacity != it->opacity || state.brightness != it->brightness || state.saturation != it->saturation) {
+        m_changedArea |= w->expandedGeometry();
+    }
+    *it = state;
+}
+
 void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data)
 {
+    // this relies on the windows being drawn in the bottom to top order as well
+    updateChangedArea(w, mask, data);
+
     const QRect screen = GLRenderTarget::virtualScreenGeometry();
     if (shouldBlur(w, mask, data)) {
         QRegion shape = region & blurRegion(w).translated(w->pos()) & screen;
@@ -604,7 +683,7 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
         const bool transientForIsDock = (modal ? modal->isDock() : false);
 
         if (!shape.isEmpty()) {
-            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock() || transientForIsDock, w->frameGeometry());
+            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock() || transientForIsDock, w->frameGeometry(), w);
         }
     }
 
@@ -620,7 +699,7 @@ void BlurEffect::paintEffectFrame(EffectFrame *frame, const QRegion &region, dou
     QRegion shape = frame->geometry().adjusted(-borderSize, -borderSize, borderSize, borderSize) & screen;
 
     if (valid && !shape.isEmpty() && region.intersects(shape.boundingRect()) && frame->style() != EffectFrameNone) {
-        doBlur(shape, screen, opacity * frameOpacity, frame->screenProjectionMatrix(), false, frame->geometry());
+        doBlur(shape, screen, opacity * frameOpacity, frame->screenProjectionMatrix(), false, frame->geometry(), nullptr);
     }
     effects->paintEffectFrame(frame, region, opacity, frameOpacity);
 }
@@ -652,17 +731,38 @@ void BlurEffect::generateNoiseTexture()
     m_noiseTexture->setWrapMode(GL_REPEAT);
 }
 
-void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
+void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, EffectWindow *w)
 {
     // Blur would not render correctly on a secondary monitor because of wrong coordinates
     // BUG: 393723
     const int xTranslate = -screen.x();
     const int yTranslate = effects->virtualScreenSize().height() - screen.height() - screen.y();
 
-    const QRegion expandedBlurRegion = expand(shape) & expand(screen);
-
     const bool useSRGB = m_renderTextures.first().internalFormat() == GL_SRGB8_ALPHA8;
 
+    // The blurred background of a window stays valid as long as nothing behind it changes
+    BlurCacheEntry *cache = nullptr;
+    bool cached = false;
+    if (w && m_blurCacheUsable) {
+        cache = &m_blurCache[w][m_currentScreen];
+        cached = cache->target && cache->screen == screen && cache->geometry == w->frameGeometry()
+            && (shape - cache->shape).isEmpty();
+    }
+
+    // A damaged pixel only changes the blur within the kernel footprint around it, so the
+    // passes only have to run for that part of a cached blur
+    QRegion blurShape = shape;
+    if (cached) {
+        cache->damage |= m_changedArea & cache->expandedShape;
+        blurShape = expand(cache->damage) & cache->expandedShape;
+        if ((cache->shape - blurShape).isEmpty()) {
+            cached = false;
+            blurShape = shape;
+        }
+    }
+
+    const QRegion expandedBlurRegion = expand(blurShape) & expand(screen);
+
     // Upload geometry for the down and upsample iterations
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
     vbo->reset();
@@ -670,47 +770,82 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     uploadGeometry(vbo, expandedBlurRegion.translated(xTranslate, yTranslate), shape);
     vbo->bindArrays();
 
-    const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
-    const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
+    const int blurRectCount = expandedBlurRegion.rectCount() * 6;
 
-    GLRenderTarget::pushRenderTargets(m_renderTargetStack);
-    int blurRectCount = expandedBlurRegion.rectCount() * 6;
+    if (!blurShape.isEmpty()) {
+        // The backdrop covers the bottom left corner of the first render texture, it can be
+        // sampled in its place when the texture coordinates are scaled to the output.
+        const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
+        GLTexture *backdrop = GLBackdrop::instance()->grab(sourceRect, m_renderTextures.first().internalFormat());
+        if (!backdrop) {
+            vbo->unbindArrays();
+            return;
+        }
 
-    /*
-     * If the window is a dock or panel we avoid the "extended blur" effect.
-     * Extended blur is when windows that are not under the blurred area affect
-     * the final blur result.
-     * We want to avoid this on panels, because it looks really weird and ugly
-     * when maximized windows or windows near the panel affect the dock blur.
-     */
-    if (isDock) {
-        m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
+        GLRenderTarget::pushRenderTargets(m_renderTargetStack);
 
+        /*
+         * If the window is a dock or panel we avoid the "extended blur" effect.
+         * Extended blur is when windows that are not under the blurred area affect
+         * the final blur result.
+         * We want to avoid this on panels, because it looks really weird and ugly
+         * when maximized windows or windows near the panel affect the dock blur.
+         */
         if (useSRGB) {
             glEnable(GL_FRAMEBUFFER_SRGB);
         }
 
-        const QRect screenRect = effects->virtualScreenGeometry();
-        QMatrix4x4 mvp;
-        mvp.ortho(0, screenRect.width(), screenRect.height(), 0, 0, 65535);
-        copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), mvp);
-    } else {
-        m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+        if (isDock) {
+            const QRect screenRect = effects->virtualScreenGeometry();
+            QMatrix4x4 mvp;
+            mvp.ortho(0, screenRect.width(), screenRect.height(), 0, 0, 65535);
+            const QRegion dockShape = cached ? cache->shape : shape;
+            copyScreenSampleTexture(vbo, blurRectCount, dockShape.translated(-screen.topLeft()), mvp, backdrop, screen.size());
+            downSampleTexture(vbo, blurRectCount, &m_renderTextures[0], m_renderTextures[0].size());
+        } else {
+            // Remove the m_renderTargets[0] from the top of the stack that we will not use
+            GLRenderTarget::popRenderTarget();
+            downSampleTexture(vbo, blurRectCount, backdrop, screen.size());
+        }
 
+        upSampleTexture(vbo, blurRectCount);
+
+        // The cache gets the texels as they are, without any color space conversion
         if (useSRGB) {
-            glEnable(GL_FRAMEBUFFER_SRGB);
+            glDisable(GL_FRAMEBUFFER_SRGB);
         }
 
-        // Remove the m_renderTargets[0] from the top of the stack that we will not use
-        GLRenderTarget::popRenderTarget();
+        if (cached) {
+            QRegion texels;
+            for (const QRect &rect : blurShape.translated(xTranslate, yTranslate)) {
+                texels += blurCacheRect(rect);
+            }
+            updateBlurCache(*cache, texels);
+            cache->damage = QRegion();
+        } else if (cache) {
+            cache->shape = shape;
+            cache->expandedShape = expandedBlurRegion;
+            cache->damage = QRegion();
+            cache->screen = screen;
+            cache->geometry = w->frameGeometry();
+            storeBlurCache(*cache, blurCacheRect(expandedBlurRegion.translated(xTranslate, yTranslate).boundingRect()));
+        }
+
+        // The windows above see the new blur as a change of their background
+        m_changedArea |= blurShape;
+    }
+
+    if (cached) {
+        restoreBlurCache(*cache);
     }
 
-    downSampleTexture(vbo, blurRectCount);
-    upSampleTexture(vbo, blurRectCount);
+    if (useSRGB) {
+        glEnable(GL_FRAMEBUFFER_SRGB);
+    }
 
     // Modulate the blurred texture with the window opacity if the window isn't opaque
     if (opacity < 1.0) {
-        glEnable(GL_BLEND);
+        GLState::enable(GL_BLEND);
 #if 1 // bow shape, always above y = x
         float o = 1.0f-opacity;
         o = 1.0f - o*o;
@@ -719,17 +854,18 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
         o = 0.5f + o / (1.0f + qAbs(o));
 #endif
         glBlendColor(0, 0, 0, o);
-        glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+        GLState::blendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
     }
 
-    upscaleRenderToScreen(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
+    const int vboStart = blurRectCount * (m_downSampleIterations + 1);
+    upscaleRenderToScreen(vbo, vboStart, shape.rectCount() * 6, screenProjection, windowRect.topLeft());
 
     if (useSRGB) {
         glDisable(GL_FRAMEBUFFER_SRGB);
     }
 
     if (opacity < 1.0) {
-        glDisable(GL_BLEND);
+        GLState::disable(GL_BLEND);
     }
 
     if (m_noiseStrength > 0) {
@@ -739,21 +875,111 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
         // The noise is applied in perceptual space (i.e. after glDisable(GL_FRAMEBUFFER_SRGB)). This practice is also
         // seen in other application of noise synthesis (films, image codecs), and makes the noise less visible overall
         // (reduces graininess).
-        glEnable(GL_BLEND);
+        GLState::enable(GL_BLEND);
         if (opacity < 1.0) {
             // We need to modulate the opacity of the noise as well; otherwise a thin layer would appear when applying
             // effects like fade out.
             // glBlendColor should have been set above.
-            glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE);
+            GLState::blendFunc(GL_CONSTANT_ALPHA, GL_ONE);
         } else {
             // Add the shader's output directly to the pixels in framebuffer.
-            glBlendFunc(GL_ONE, GL_ONE);
+            GLState::blendFunc(GL_ONE, GL_ONE);
         }
-        applyNoise(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
-        glDisable(GL_BLEND);
+        applyNoise(vbo, vboStart, shape.rectCount() * 6, screenProjection, windowRect.topLeft());
+        GLState::disable(GL_BLEND);
     }
 
     vbo->unbindArrays();
+
+    // Effects that sample the background after this one, like the contrast, have to see the blur
+    GLBackdrop::instance()->invalidate(shape);
+}
+
+QRect BlurEffect::blurCacheRect(const QRect &rect) const
+{
+    // The passes draw with a top-down projection, but the rows of the texture are bottom-up.
+    // One more texel on each side covers the rounding of the coordinates.
+    const int height = m_renderTextures[1].height();
+    const QRect texels(QPoint(rect.left() / 2 - 1, height - (rect.bottom() + 2) / 2 - 1),
+                       QPoint((rect.right() + 2) / 2, height - rect.top() / 2));
+    return texels & QRect(QPoint(0, 0), m_renderTextures[1].size());
+}
+
+void BlurEffect::storeBlurCache(BlurCacheEntry &entry, const QRect &textureRect)
+{
+    if (entry.target && entry.target->texture()->size() != textureRect.size()) {
+        releaseBlurCache(entry);
+    }
+    if (!entry.target) {
+        entry.target = GLRenderTargetPool::instance()->acquire(textureRect.size(), m_renderTextures[1].internalFormat());
+        if (!entry.target) {
+            return;
+        }
+    }
+    entry.textureRect = textureRect;
+    updateBlurCache(entry, textureRect);
+}
+
+void BlurEffect::updateBlurCache(BlurCacheEntry &entry, const QRegion &texels)
+{
+    GLRenderTarget::pushRenderTarget(m_renderTargets[1]);
+    entry.target->texture()->bind();
+    for (const QRect &rect : texels) {
+        const QRect source = rect & entry.textureRect;
+        if (source.isEmpty()) {
+            continue;
+        }
+        const QPoint destination = source.topLeft() - entry.textureRect.topLeft();
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, destination.x(), destination.y(),
+                            source.x(), source.y(), source.width(), source.height());
+    }
+    entry.target->texture()->unbind();
+    GLRenderTarget::popRenderTarget();
+}
+
+void BlurEffect::restoreBlurCache(const BlurCacheEntry &entry)
+{
+    // Put the blur back where the final pass expects it
+    GLRenderTarget::pushRenderTarget(entry.target->renderTarget());
+    m_renderTextures[1].bind();
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, entry.textureRect.x(), entry.textureRect.y(), 0, 0,
+                        entry.textureRect.width(), entry.textureRect.height());
+    m_renderTextures[1].unbind();
+    GLRenderTarget::popRenderTarget();
+}
+
+void BlurEffect::releaseBlurCache(BlurCacheEntry &entry)
+{
+    if (entry.target) {
+        GLRenderTargetPool::instance()->release(entry.target);
+        entry.target = nullptr;
+    }
+}
+
+void BlurEffect::invalidateBlurCache()
+{
+    for (auto &cache : m_blurCache) {
+        for (BlurCacheEntry &entry : cache) {
+            releaseBlurCache(entry);
+        }
+    }
+    m_blurCache.clear();
+}
+
+void BlurEffect::slotScreenRemoved(EffectScreen *screen)
+{
+    effects->makeOpenGLContextCurrent();
+    for (auto it = m_blurCache.begin(); it != m_blurCache.end(); ++it) {
+        auto entry = it->find(screen);
+        if (entry != it->end()) {
+            releaseBlurCache(*entry);
+            it->erase(entry);
+        }
+    }
+    for (auto &states : m_windowPaintStates) {
+        states.remove(screen);
+    }
+    effects->doneOpenGLContextCurrent();
 }
 
 void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition)
@@ -787,7 +1013,7 @@ void BlurEffect::applyNoise(GLVertexBuffer *vbo, int vboStart, int blurRectCount
     m_shader->unbind();
 }
 
-void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
+void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount, GLTexture *source, const QSize &sourceSize)
 {
     QMatrix4x4 modelViewProjectionMatrix;
 
@@ -799,10 +1025,16 @@ void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
         modelViewProjectionMatrix.ortho(0, m_renderTextures[i].width(), m_renderTextures[i].height(), 0 , 0, 65535);
 
         m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
-        m_shader->setTargetTextureSize(m_renderTextures[i].size());
 
         //Copy the image from this texture
-        m_renderTextures[i - 1].bind();
+        if (i == 1) {
+            // The texture coordinates are relative to the area the source covers
+            m_shader->setTargetTextureSize(sourceSize / 2);
+            source->bind();
+        } else {
+            m_shader->setTargetTextureSize(m_renderTextures[i].size());
+            m_renderTextures[i - 1].bind();
+        }
 
         vbo->draw(GL_TRIANGLES, blurRectCount * i, blurRectCount);
         GLRenderTarget::popRenderTarget();
@@ -835,19 +1067,19 @@ void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
     m_shader->unbind();
 }
 
-void BlurEffect::copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection)
+void BlurEffect::copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection, GLTexture *source, const QSize &sourceSize)
 {
     m_shader->bind(BlurShader::CopySampleType);
 
     m_shader->setModelViewProjectionMatrix(screenProjection);
-    m_shader->setTargetTextureSize(effects->virtualScreenSize());
+    m_shader->setTargetTextureSize(sourceSize);
 
     /*
      * This '1' sized adjustment is necessary do avoid windows affecting the blur that are
      * right next to this window.
      */
-    m_shader->setBlurRect(blurShape.boundingRect().adjusted(1, 1, -1, -1), effects->virtualScreenSize());
-    m_renderTextures.last().bind();
+    m_shader->setBlurRect(blurShape.boundingRect().adjusted(1, 1, -1, -1), sourceSize);
+    source->bind();
 
     vbo->draw(GL_TRIANGLES, 0, blurRectCount);
     GLRenderTarget::popRenderTarget();
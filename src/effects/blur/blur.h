@@ -12,6 +12,7 @@
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
+#include <QHash>
 #include <QVector>
 #include <QVector2D>
 #include <QStack>
@@ -58,8 +59,33 @@ public Q_SLOTS:
     void slotWindowDeleted(KWin::EffectWindow *w);
     void slotPropertyNotify(KWin::EffectWindow *w, long atom);
     void slotScreenGeometryChanged();
+    void slotScreenRemoved(KWin::EffectScreen *screen);
 
 private:
+    /**
+     * The blurred background of a window. It's the half resolution result of the up-sample
+     * passes, so only the final pass to the screen has to run while it is valid.
+     */
+    struct BlurCacheEntry {
+        GLRenderTargetPool::Target *target = nullptr;
+        QRect textureRect;      // the texels of m_renderTextures[1] stored in the target
+        QRegion shape;          // the area the blur has been computed for
+        QRegion expandedShape;  // the area of the screen the blur depends on
+        QRegion damage;         // the damaged areas the blur hasn't been updated for yet
+        QRect screen;
+        QRect geometry;
+    };
+
+    /**
+     * The attributes a window was painted with the last time.
+     */
+    struct WindowPaintState {
+        qreal opacity;
+        qreal brightness;
+        qreal saturation;
+        bool transformed;
+    };
+
     QRect expand(const QRect &rect) const;
     QRegion expand(const QRegion &region) const;
     bool renderTargetsValid() const;
@@ -69,21 +95,30 @@ private:
     QRegion blurRegion(const EffectWindow *w) const;
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
-    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+    void updateChangedArea(EffectWindow *w, int mask, const WindowPaintData &data);
+    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, EffectWindow *w);
     void uploadRegion(QVector2D *&map, const QRegion &region, const int downSampleIterations);
     void uploadGeometry(GLVertexBuffer *vbo, const QRegion &blurRegion, const QRegion &windowRegion);
     void generateNoiseTexture();
 
     void upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition);
     void applyNoise(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition);
-    void downSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
+    void downSampleTexture(GLVertexBuffer *vbo, int blurRectCount, GLTexture *source, const QSize &sourceSize);
     void upSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
-    void copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection);
+    void copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection, GLTexture *source, const QSize &sourceSize);
+
+    QRect blurCacheRect(const QRect &rect) const;
+    void storeBlurCache(BlurCacheEntry &entry, const QRect &textureRect);
+    void updateBlurCache(BlurCacheEntry &entry, const QRegion &region);
+    void restoreBlurCache(const BlurCacheEntry &entry);
+    void releaseBlurCache(BlurCacheEntry &entry);
+    void invalidateBlurCache();
 
 private:
     BlurShader *m_shader;
     QVector <GLRenderTarget*> m_renderTargets;
     QVector <GLTexture> m_renderTextures;
+    QVector <GLRenderTargetPool::Target*> m_pooledTargets;
     QStack <GLRenderTarget*> m_renderTargetStack;
 
     QScopedPointer<GLTexture> m_noiseTexture;
@@ -92,6 +127,15 @@ private:
     long net_wm_blur_region = 0;
     QRegion m_paintedArea; // keeps track of all painted areas (from bottom to top)
     QRegion m_currentBlur; // keeps track of the currently blured area of the windows(from bottom to top)
+    QRegion m_changedArea; // keeps track of the areas that look different than in the last frame (from bottom to top)
+    QRegion m_damagedArea; // keeps track of the damaged areas of the windows (from bottom to top)
+    EffectScreen *m_currentScreen = nullptr;
+
+    // Every output is painted separately, so the caches are kept per output
+    QHash<EffectWindow *, QHash<EffectScreen *, BlurCacheEntry>> m_blurCache;
+    QHash<EffectWindow *, QHash<EffectScreen *, WindowPaintState>> m_windowPaintStates;
+    bool m_blurCacheEnabled;
+    bool m_blurCacheUsable = false;
 
     int m_downSampleIterations; // number of times the texture will be downsized to half size
     int m_offset;
@@ -26,6 +26,9 @@ public:
     int requestedEffectChainPosition() const override {
         return 70;
     }
+    bool declaresWindowInterest() const override {
+        return true;
+    }
 
     bool provides(Feature feature) override;
     bool perform(Feature feature, const QVariantList &arguments) override;
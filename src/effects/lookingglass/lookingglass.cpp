@@ -42,8 +42,7 @@ LookingGlassEffect::LookingGlassEffect()
     : zoom(1.0f)
     , target_zoom(1.0f)
     , polling(false)
-    , m_texture(nullptr)
-    , m_fbo(nullptr)
+    , m_target(nullptr)
     , m_vbo(nullptr)
     , m_shader(nullptr)
     , m_lastPresentTime(std::chrono::milliseconds::zero())
@@ -75,8 +74,7 @@ LookingGlassEffect::LookingGlassEffect()
 
 LookingGlassEffect::~LookingGlassEffect()
 {
-    delete m_texture;
-    delete m_fbo;
+    GLRenderTargetPool::instance()->release(m_target);
     delete m_shader;
     delete m_vbo;
 }
@@ -100,19 +98,6 @@ bool LookingGlassEffect::loadData()
     ensureResources();
 
     const QSize screenSize = effects->virtualScreenSize();
-    int texw = screenSize.width();
-    int texh = screenSize.height();
-
-    // Create texture and render target
-    const int levels = std::log2(qMin(texw, texh)) + 1;
-    m_texture = new GLTexture(GL_RGBA8, texw, texh, levels);
-    m_texture->setFilter(GL_LINEAR_MIPMAP_LINEAR);
-    m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
-
-    m_fbo = new GLRenderTarget(*m_texture);
-    if (!m_fbo->valid()) {
-        return false;
-    }
 
     m_shader = ShaderManager::instance()->generateShaderFromFile(ShaderTrait::MapTexture, QString(), QStringLiteral(":/effects/lookingglass/shaders/lookingglass.frag"));
     if (m_shader->isValid()) {
@@ -220,9 +205,21 @@ void LookingGlassEffect::prePaintScreen(ScreenPrePaintData& data, std::chrono::m
         m_lastPresentTime = std::chrono::milliseconds::zero();
     }
     if (m_valid && m_enabled) {
-        data.mask |= PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS;
-        // Start rendering to texture
-        GLRenderTarget::pushRenderTarget(m_fbo);
+        // The render target is only held while the effect is active
+        const QSize screenSize = effects->virtualScreenSize();
+        if (!m_target || m_target->texture()->size() != screenSize) {
+            GLRenderTargetPool::instance()->release(m_target);
+            const int levels = std::log2(qMin(screenSize.width(), screenSize.height())) + 1;
+            m_target = GLRenderTargetPool::instance()->acquire(screenSize, GL_RGBA8, levels);
+        }
+        if (m_target) {
+            data.mask |= PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS;
+            // Start rendering to texture
+            GLRenderTarget::pushRenderTarget(m_target->renderTarget());
+        }
+    } else if (m_target) {
+        GLRenderTargetPool::instance()->release(m_target);
+        m_target = nullptr;
     }
 
     effects->prePaintScreen(data, presentTime);
@@ -248,13 +245,14 @@ void LookingGlassEffect::paintScreen(int mask, const QRegion &region, ScreenPain
 {
     // Call the next effect.
     effects->paintScreen(mask, region, data);
-    if (m_valid && m_enabled) {
+    if (m_target) {
         // Disable render texture
         GLRenderTarget* target = GLRenderTarget::popRenderTarget();
-        Q_ASSERT(target == m_fbo);
+        Q_ASSERT(target == m_target->renderTarget());
         Q_UNUSED(target);
-        m_texture->bind();
-        m_texture->generateMipmaps();
+        GLTexture *texture = m_target->texture();
+        texture->bind();
+        texture->generateMipmaps();
 
         // Use the shader
         ShaderBinder binder(m_shader);
@@ -263,7 +261,7 @@ void LookingGlassEffect::paintScreen(int mask, const QRegion &region, ScreenPain
         m_shader->setUniform("u_cursor", QVector2D(cursorPos().x(), cursorPos().y()));
         m_shader->setUniform(GLShader::ModelViewProjectionMatrix, data.projectionMatrix());
         m_vbo->render(GL_TRIANGLES);
-        m_texture->unbind();
+        texture->unbind();
     }
 }
 
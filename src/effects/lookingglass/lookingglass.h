@@ -12,15 +12,11 @@
 #define KWIN_LOOKINGGLASS_H
 
 #include <kwineffects.h>
+#include <kwinglutils.h>
 
 namespace KWin
 {
 
-class GLRenderTarget;
-class GLShader;
-class GLTexture;
-class GLVertexBuffer;
-
 /**
  * Enhanced magnifier
  */
@@ -62,8 +58,7 @@ private:
     bool polling; // Mouse polling
     int radius;
     int initialradius;
-    GLTexture *m_texture;
-    GLRenderTarget *m_fbo;
+    GLRenderTargetPool::Target *m_target;
     GLVertexBuffer *m_vbo;
     GLShader *m_shader;
     std::chrono::milliseconds m_lastPresentTime;
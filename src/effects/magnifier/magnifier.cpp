@@ -30,8 +30,7 @@ MagnifierEffect::MagnifierEffect()
     , target_zoom(1)
     , polling(false)
     , m_lastPresentTime(std::chrono::milliseconds::zero())
-    , m_texture(nullptr)
-    , m_fbo(nullptr)
+    , m_target(nullptr)
 {
     initConfig<MagnifierConfig>();
     QAction* a;
@@ -58,8 +57,7 @@ MagnifierEffect::MagnifierEffect()
 
 MagnifierEffect::~MagnifierEffect()
 {
-    delete m_fbo;
-    delete m_texture;
+    GLRenderTargetPool::instance()->release(m_target);
     // Save the zoom value.
     MagnifierConfig::setInitialZoom(target_zoom);
     MagnifierConfig::self()->save();
@@ -94,11 +92,9 @@ void MagnifierEffect::prePaintScreen(ScreenPrePaintData& data, std::chrono::mill
         else {
             zoom = qMax(zoom * qMin(1 - diff, 0.8), target_zoom);
             if (zoom == 1.0) {
-                // zoom ended - delete FBO and texture
-                delete m_fbo;
-                delete m_texture;
-                m_fbo = nullptr;
-                m_texture = nullptr;
+                // zoom ended - hand the render target back
+                GLRenderTargetPool::instance()->release(m_target);
+                m_target = nullptr;
             }
         }
     }
@@ -125,19 +121,20 @@ void MagnifierEffect::paintScreen(int mask, const QRegion &region, ScreenPaintDa
         QRect srcArea(cursor.x() - (double)area.width() / (zoom*2),
                       cursor.y() - (double)area.height() / (zoom*2),
                       (double)area.width() / zoom, (double)area.height() / zoom);
-        if (effects->isOpenGLCompositing()) {
-            m_fbo->blitFromFramebuffer(srcArea);
+        if (m_target) {
+            GLTexture *texture = m_target->texture();
+            m_target->renderTarget()->blitFromFramebuffer(srcArea);
             // paint magnifier
-            m_texture->bind();
+            texture->bind();
             auto s = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
             QMatrix4x4 mvp;
             const QSize size = effects->virtualScreenSize();
             mvp.ortho(0, size.width(), size.height(), 0, 0, 65535);
             mvp.translate(area.x(), area.y());
             s->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-            m_texture->render(infiniteRegion(), area);
+            texture->render(infiniteRegion(), area);
             ShaderManager::instance()->popShader();
-            m_texture->unbind();
+            texture->unbind();
             QVector<float> verts;
             GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
             vbo->reset();
@@ -202,11 +199,9 @@ void MagnifierEffect::zoomIn()
         polling = true;
         effects->startMousePolling();
     }
-    if (effects->isOpenGLCompositing() && !m_texture) {
+    if (effects->isOpenGLCompositing() && !m_target) {
         effects->makeOpenGLContextCurrent();
-        m_texture = new GLTexture(GL_RGBA8, magnifier_size.width(), magnifier_size.height());
-        m_texture->setYInverted(false);
-        m_fbo = new GLRenderTarget(*m_texture);
+        m_target = GLRenderTargetPool::instance()->acquire(magnifier_size);
     }
     effects->addRepaint(magnifierArea().adjusted(-FRAME_WIDTH, -FRAME_WIDTH, FRAME_WIDTH, FRAME_WIDTH));
 }
@@ -221,11 +216,8 @@ void MagnifierEffect::zoomOut()
             effects->stopMousePolling();
         }
         if (zoom == target_zoom) {
-            effects->makeOpenGLContextCurrent();
-            delete m_fbo;
-            delete m_texture;
-            m_fbo = nullptr;
-            m_texture = nullptr;
+            GLRenderTargetPool::instance()->release(m_target);
+            m_target = nullptr;
         }
     }
     effects->addRepaint(magnifierArea().adjusted(-FRAME_WIDTH, -FRAME_WIDTH, FRAME_WIDTH, FRAME_WIDTH));
@@ -241,11 +233,9 @@ void MagnifierEffect::toggle()
             polling = true;
             effects->startMousePolling();
         }
-        if (effects->isOpenGLCompositing() && !m_texture) {
+        if (effects->isOpenGLCompositing() && !m_target) {
             effects->makeOpenGLContextCurrent();
-            m_texture = new GLTexture(GL_RGBA8, magnifier_size.width(), magnifier_size.height());
-            m_texture->setYInverted(false);
-            m_fbo = new GLRenderTarget(*m_texture);
+            m_target = GLRenderTargetPool::instance()->acquire(magnifier_size);
         }
     } else {
         target_zoom = 1;
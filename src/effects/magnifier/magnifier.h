@@ -12,13 +12,11 @@
 #define KWIN_MAGNIFIER_H
 
 #include <kwineffects.h>
+#include <kwinglutils.h>
 
 namespace KWin
 {
 
-class GLRenderTarget;
-class GLTexture;
-
 class MagnifierEffect
     : public Effect
 {
@@ -57,8 +55,7 @@ private:
     bool polling; // Mouse polling
     std::chrono::milliseconds m_lastPresentTime;
     QSize magnifier_size;
-    GLTexture *m_texture;
-    GLRenderTarget *m_fbo;
+    GLRenderTargetPool::Target *m_target;
 };
 
 } // namespace
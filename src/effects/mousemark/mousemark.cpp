@@ -75,8 +75,8 @@ void MouseMarkEffect::paintScreen(int mask, const QRegion &region, ScreenPaintDa
         return;
     if ( effects->isOpenGLCompositing()) {
         if (!GLPlatform::instance()->isGLES()) {
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            GLState::enable(GL_BLEND);
+            GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
             glEnable(GL_LINE_SMOOTH);
             glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
@@ -110,7 +110,7 @@ void MouseMarkEffect::paintScreen(int mask, const QRegion &region, ScreenPaintDa
         glLineWidth(1.0);
         if (!GLPlatform::instance()->isGLES()) {
             glDisable(GL_LINE_SMOOTH);
-            glDisable(GL_BLEND);
+            GLState::disable(GL_BLEND);
         }
     } else if (effects->compositingType() == QPainterCompositing) {
         QPainter *painter = effects->scenePainter();
@@ -85,8 +85,8 @@ void ScreenEdgeEffect::paintScreen(int mask, const QRegion &region, ScreenPaintD
         }
         if (effects->isOpenGLCompositing()) {
             GLTexture *texture = (*it)->texture.data();
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            GLState::enable(GL_BLEND);
+            GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
             texture->bind();
             ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate);
             const QVector4D constant(opacity, opacity, opacity, opacity);
@@ -96,7 +96,7 @@ void ScreenEdgeEffect::paintScreen(int mask, const QRegion &region, ScreenPaintD
             binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
             texture->render(infiniteRegion(), (*it)->geometry);
             texture->unbind();
-            glDisable(GL_BLEND);
+            GLState::disable(GL_BLEND);
         } else if (effects->compositingType() == QPainterCompositing) {
             QImage tmp((*it)->image->size(), QImage::Format_ARGB32_Premultiplied);
             tmp.fill(Qt::transparent);
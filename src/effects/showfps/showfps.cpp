@@ -165,8 +165,8 @@ void ShowFpsEffect::paintGL(int fps, const QMatrix4x4 &projectionMatrix)
 {
     int x = this->x;
     int y = this->y;
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     // TODO painting first the background white and then the contents
     // means that the contents also blend with the background, I guess
     ShaderBinder binder(ShaderTrait::UniformColor);
@@ -235,7 +235,7 @@ void ShowFpsEffect::paintGL(int fps, const QMatrix4x4 &projectionMatrix)
     }
 
     // Paint paint sizes
-    glDisable(GL_BLEND);
+    GLState::disable(GL_BLEND);
 }
 
 void ShowFpsEffect::paintQPainter(int fps)
@@ -71,8 +71,8 @@ void ShowPaintEffect::paintGL(const QMatrix4x4 &projection)
     vbo->setUseColor(true);
     ShaderBinder binder(ShaderTrait::UniformColor);
     binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, projection);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     QColor color = s_colors[m_colorIndex];
     color.setAlphaF(s_alpha);
     vbo->setColor(color);
@@ -88,7 +88,7 @@ void ShowPaintEffect::paintGL(const QMatrix4x4 &projection)
     }
     vbo->setData(verts.count() / 2, 2, verts.data(), nullptr);
     vbo->render(GL_TRIANGLES);
-    glDisable(GL_BLEND);
+    GLState::disable(GL_BLEND);
 }
 
 void ShowPaintEffect::paintQPainter()
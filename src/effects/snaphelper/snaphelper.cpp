@@ -113,8 +113,8 @@ void SnapHelperEffect::paintScreen(int mask, const QRegion &region, ScreenPaintD
         vbo->setUseColor(true);
         ShaderBinder binder(ShaderTrait::UniformColor);
         binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, data.projectionMatrix());
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         QColor color = s_lineColor;
         color.setAlphaF(color.alphaF() * opacityFactor);
@@ -157,7 +157,7 @@ void SnapHelperEffect::paintScreen(int mask, const QRegion &region, ScreenPaintD
         vbo->setData(verts.count() / 2, 2, verts.data(), nullptr);
         vbo->render(GL_LINES);
 
-        glDisable(GL_BLEND);
+        GLState::disable(GL_BLEND);
         glLineWidth(1.0);
     } else if (effects->compositingType() == QPainterCompositing) {
         QPainter *painter = effects->scenePainter();
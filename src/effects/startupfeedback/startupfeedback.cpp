@@ -216,8 +216,8 @@ void StartupFeedbackEffect::paintScreen(int mask, const QRegion &region, ScreenP
         default:
             return; // safety
         }
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         texture->bind();
         if (m_type == BlinkingFeedback && m_blinkingShader && m_blinkingShader->isValid()) {
             const QColor& blinkingColor = BLINKING_COLORS[ FRAME_TO_BLINKING_COLOR[ m_frame ]];
@@ -232,7 +232,7 @@ void StartupFeedbackEffect::paintScreen(int mask, const QRegion &region, ScreenP
         texture->render(m_currentGeometry, m_currentGeometry);
         ShaderManager::instance()->popShader();
         texture->unbind();
-        glDisable(GL_BLEND);
+        GLState::disable(GL_BLEND);
     }
 }
 
@@ -242,13 +242,13 @@ void TouchPointsEffect::paintScreenSetupGl(int, QRegion, ScreenPaintData &data)
     shader->setUniform(GLShader::ModelViewProjectionMatrix, data.projectionMatrix());
 
     glLineWidth(m_lineWidth);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void TouchPointsEffect::paintScreenFinishGl(int, QRegion, ScreenPaintData&)
 {
-    glDisable(GL_BLEND);
+    GLState::disable(GL_BLEND);
 
     ShaderManager::instance()->popShader();
 }
@@ -105,8 +105,8 @@ void TrackMouseEffect::paintScreen(int mask, const QRegion &region, ScreenPaintD
         if (!shader) {
             return;
         }
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
         QMatrix4x4 matrix(data.projectionMatrix());
         const QPointF p = m_lastRect[0].topLeft() + QPoint(m_lastRect[0].width()/2.0, m_lastRect[0].height()/2.0);
         const float x = p.x()*data.xScale() + data.xTranslation();
@@ -122,7 +122,7 @@ void TrackMouseEffect::paintScreen(int mask, const QRegion &region, ScreenPaintD
             m_texture[i]->render(region, m_lastRect[i]);
             m_texture[i]->unbind();
         }
-        glDisable(GL_BLEND);
+        GLState::disable(GL_BLEND);
     } else if (effects->compositingType() == QPainterCompositing && !m_image[0].isNull() && !m_image[1].isNull()) {
         QPainter *painter = effects->scenePainter();
         const QPointF p = m_lastRect[0].topLeft() + QPoint(m_lastRect[0].width()/2.0, m_lastRect[0].height()/2.0);
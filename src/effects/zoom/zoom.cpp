@@ -338,8 +338,8 @@ void ZoomEffect::paintScreen(int mask, const QRegion &region, ScreenPaintData& d
             QRect rect(p * zoom + QPoint(data.xTranslation(), data.yTranslation()), cursorSize);
 
             cursorTexture->bind();
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            GLState::enable(GL_BLEND);
+            GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
             auto s = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture);
             QMatrix4x4 mvp = data.projectionMatrix();
             mvp.translate(rect.x(), rect.y());
@@ -347,7 +347,7 @@ void ZoomEffect::paintScreen(int mask, const QRegion &region, ScreenPaintData& d
             cursorTexture->render(region, rect);
             ShaderManager::instance()->popShader();
             cursorTexture->unbind();
-            glDisable(GL_BLEND);
+            GLState::disable(GL_BLEND);
         }
     }
 }
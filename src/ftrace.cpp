@@ -10,21 +10,152 @@
 
 #include "ftrace.h"
 
+#include <QCoreApplication>
 #include <QDBusConnection>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
 #include <QScopeGuard>
 #include <QTextStream>
 
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
 namespace KWin
 {
 KWIN_SINGLETON_FACTORY(KWin::FTraceLogger)
 
+namespace
+{
+
+/**
+ * A single-producer ring buffer of trace events owned by one thread. Every slot is guarded
+ * by a sequence counter so the events can be read from another thread without locks; a slot
+ * that is being overwritten while it is read is skipped.
+ */
+struct TraceRingBuffer
+{
+    static constexpr quint64 capacity = 8192;
+
+    struct Slot
+    {
+        std::atomic<quint32> sequence = 0;
+        TraceEvent event;
+    };
+
+    void push(const TraceEvent &event)
+    {
+        const quint64 index = head.load(std::memory_order_relaxed);
+        Slot &slot = slots[index % capacity];
+
+        const quint32 sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = event;
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+
+        head.store(index + 1, std::memory_order_release);
+    }
+
+    void read(qint64 since, QVector<QPair<quint64, TraceEvent>> *events) const
+    {
+        const quint64 end = head.load(std::memory_order_acquire);
+        const quint64 begin = end > capacity ? end - capacity : 0;
+        for (quint64 i = begin; i < end; ++i) {
+            const Slot &slot = slots[i % capacity];
+            const quint32 sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                continue;
+            }
+            const TraceEvent event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+            if (event.timestamp >= since) {
+                events->append(qMakePair(threadId, event));
+            }
+        }
+    }
+
+    quint64 threadId = 0;
+    std::atomic<quint64> head = 0;
+    std::array<Slot, capacity> slots;
+};
+
+/**
+ * The ring buffers outlive the threads that own them, so the events recorded by threads
+ * that have already finished are still included in dumps. The buffer of a finished thread
+ * is handed to the next thread that starts tracing, so there are never more buffers than
+ * threads that have been tracing at the same time.
+ */
+struct TraceRingBufferRegistry
+{
+    QMutex mutex;
+    std::vector<std::unique_ptr<TraceRingBuffer>> buffers;
+    std::vector<TraceRingBuffer *> unused;
+};
+
+TraceRingBufferRegistry *ringBufferRegistry()
+{
+    static TraceRingBufferRegistry registry;
+    return &registry;
+}
+
+/**
+ * Returns the ring buffer of the current thread to the registry when the thread exits.
+ */
+struct ThreadRingBuffer
+{
+    ~ThreadRingBuffer()
+    {
+        if (buffer) {
+            auto registry = ringBufferRegistry();
+            QMutexLocker lock(&registry->mutex);
+            registry->unused.push_back(buffer);
+        }
+    }
+
+    TraceRingBuffer *buffer = nullptr;
+};
+
+TraceRingBuffer *threadRingBuffer()
+{
+    static thread_local ThreadRingBuffer local;
+    if (Q_UNLIKELY(!local.buffer)) {
+        auto registry = ringBufferRegistry();
+        QMutexLocker lock(&registry->mutex);
+        if (registry->unused.empty()) {
+            registry->buffers.push_back(std::make_unique<TraceRingBuffer>());
+            local.buffer = registry->buffers.back().get();
+        } else {
+            // The events of the finished thread are dropped, readers hold the same lock.
+            local.buffer = registry->unused.back();
+            registry->unused.pop_back();
+            local.buffer->head.store(0, std::memory_order_release);
+        }
+        local.buffer->threadId = syscall(SYS_gettid);
+    }
+    return local.buffer;
+}
+
+} // anonymous namespace
+
 FTraceLogger::FTraceLogger(QObject *parent)
     : QObject(parent)
 {
+    if (qEnvironmentVariableIsSet("KWIN_PERF_TRACE_RECORD")) {
+        setRecording(true);
+    }
     if (qEnvironmentVariableIsSet("KWIN_PERF_FTRACE")) {
         setEnabled(true);
     } else {
@@ -52,6 +183,81 @@ void FTraceLogger::setEnabled(bool enabled)
     Q_EMIT enabledChanged();
 }
 
+void FTraceLogger::setRecording(bool recording)
+{
+    if (m_recording.exchange(recording) != recording) {
+        Q_EMIT recordingChanged();
+    }
+}
+
+void FTraceLogger::commit(const TraceEvent &event)
+{
+    threadRingBuffer()->push(event);
+}
+
+QVector<QPair<quint64, TraceEvent>> FTraceLogger::recordedEvents(int seconds) const
+{
+    const std::chrono::nanoseconds now = std::chrono::steady_clock::now().time_since_epoch();
+    const qint64 since = (now - std::chrono::seconds(seconds)).count();
+
+    QVector<QPair<quint64, TraceEvent>> events;
+    auto registry = ringBufferRegistry();
+    {
+        QMutexLocker lock(&registry->mutex);
+        for (const auto &buffer : registry->buffers) {
+            buffer->read(since, &events);
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const auto &a, const auto &b) {
+        return a.second.timestamp < b.second.timestamp;
+    });
+    return events;
+}
+
+bool FTraceLogger::dumpTrace(const QString &fileName, int seconds)
+{
+    const auto events = recordedEvents(seconds);
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    for (const auto &[threadId, event] : events) {
+        QJsonObject object;
+        switch (event.phase) {
+        case TraceEvent::Instant:
+            object[QStringLiteral("ph")] = QStringLiteral("i");
+            object[QStringLiteral("s")] = QStringLiteral("t");
+            break;
+        case TraceEvent::Begin:
+            object[QStringLiteral("ph")] = QStringLiteral("B");
+            break;
+        case TraceEvent::End:
+            object[QStringLiteral("ph")] = QStringLiteral("E");
+            break;
+        }
+        object[QStringLiteral("name")] = QString::fromLatin1(event.name, event.nameLength);
+        object[QStringLiteral("ts")] = event.timestamp / 1000.0;
+        object[QStringLiteral("pid")] = pid;
+        object[QStringLiteral("tid")] = qint64(threadId);
+        if (event.context) {
+            object[QStringLiteral("args")] = QJsonObject{{QStringLiteral("ctx"), qint64(event.context)}};
+        }
+        traceEvents.append(object);
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not open" << fileName << "to dump the trace:" << file.errorString();
+        return false;
+    }
+    const QJsonObject trace{
+        {QStringLiteral("traceEvents"), traceEvents},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
 bool FTraceLogger::open()
 {
     const QString path = filePath();
@@ -115,7 +321,12 @@ QString FTraceLogger::filePath()
 
 FTraceDuration::~FTraceDuration()
 {
-    FTraceLogger::self()->trace(m_message, " end_ctx=", m_context);
+    if (FTraceLogger::self()->isRecording()) {
+        FTraceLogger::self()->record(TraceEvent::End, m_context);
+    }
+    if (!m_message.isEmpty()) {
+        FTraceLogger::self()->write(m_message, " end_ctx=", m_context);
+    }
 }
 
 }
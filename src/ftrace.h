@@ -16,9 +16,90 @@
 #include <QMutexLocker>
 #include <QObject>
 #include <QTextStream>
+#include <QVector>
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <optional>
+#include <type_traits>
 
 namespace KWin
 {
+
+/**
+ * TraceEvent is a fixed-size binary record of a trace point.
+ *
+ * The name is the concatenation of the trace arguments, truncated to fit into the event.
+ */
+struct TraceEvent
+{
+    enum Phase : quint8 {
+        Instant,
+        Begin,
+        End,
+    };
+
+    qint64 timestamp = 0;
+    quint32 context = 0;
+    Phase phase = Instant;
+    quint8 nameLength = 0;
+    char name[50];
+};
+
+namespace FTraceDetail
+{
+
+/**
+ * Writes trace arguments into the fixed-size name of a TraceEvent without allocating memory.
+ */
+class TraceEventWriter
+{
+public:
+    explicit TraceEventWriter(TraceEvent *event)
+        : m_event(event)
+    {
+    }
+
+    void append(const char *text)
+    {
+        for (; *text && m_event->nameLength < sizeof(m_event->name); ++text) {
+            m_event->name[m_event->nameLength++] = *text;
+        }
+    }
+
+    void append(const QByteArray &text)
+    {
+        append(text.constData());
+    }
+
+    void append(const QString &text)
+    {
+        for (const QChar &c : text) {
+            if (m_event->nameLength == sizeof(m_event->name)) {
+                break;
+            }
+            m_event->name[m_event->nameLength++] = c.toLatin1() ? c.toLatin1() : '?';
+        }
+    }
+
+    template<typename T>
+    std::enable_if_t<std::is_integral_v<T>> append(T value)
+    {
+        char *begin = m_event->name + m_event->nameLength;
+        char *end = m_event->name + sizeof(m_event->name);
+        const auto result = std::to_chars(begin, end, value);
+        if (result.ec == std::errc()) {
+            m_event->nameLength = result.ptr - m_event->name;
+        }
+    }
+
+private:
+    TraceEvent *m_event;
+};
+
+} // namespace FTraceDetail
+
 /**
  * FTraceLogger is a singleton utility for writing log messages using ftrace
  *
@@ -26,12 +107,21 @@ namespace KWin
  *  Set the KWIN_PERF_FTRACE environment variable before starting the application
  *  Calling on DBus /FTrace org.kde.kwin.FTrace.setEnabled true
  * After having created the ftrace mount
+ *
+ * Alternatively, trace points can be recorded into per-thread ring buffers of binary
+ * events. Recording is cheap enough to be left running, and doesn't need ftrace. The
+ * recorded events can be dumped in the Chrome trace event format, which can be loaded in
+ * Perfetto or chrome://tracing:
+ *  Set the KWIN_PERF_TRACE_RECORD environment variable before starting the application
+ *  Calling on DBus /FTrace org.kde.kwin.FTrace.setRecording true
+ *  Calling on DBus /FTrace org.kde.kwin.FTrace.dumpTrace /tmp/kwin.json 5
  */
 class KWIN_EXPORT FTraceLogger : public QObject
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.FTrace");
     Q_PROPERTY(bool isEnabled READ isEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(bool isRecording READ isRecording NOTIFY recordingChanged)
 
 public:
     /**
@@ -39,13 +129,33 @@ public:
      */
     bool isEnabled() const;
 
+    /**
+     * Whether trace points are recorded into the ring buffers
+     */
+    bool isRecording() const
+    {
+        return m_recording.load(std::memory_order_relaxed);
+    }
+
     /**
      * Main log function
      * Takes any number of arguments that can be written into QTextStream
      */
     template<typename... Args> void trace(Args... args)
     {
-        Q_ASSERT(isEnabled());
+        if (isRecording()) {
+            record(TraceEvent::Instant, 0, args...);
+        }
+        if (isEnabled()) {
+            write(args...);
+        }
+    }
+
+    /**
+     * Writes a message to the ftrace marker file
+     */
+    template<typename... Args> void write(Args... args)
+    {
         QMutexLocker lock(&m_mutex);
         if (!m_file.isOpen()) {
             return;
@@ -54,17 +164,49 @@ public:
         (stream << ... << args) << Qt::endl;
     }
 
+    /**
+     * Records an event into the ring buffer of the calling thread. This function doesn't
+     * take any locks and doesn't allocate memory, except when a thread records its very
+     * first event.
+     */
+    template<typename... Args> void record(TraceEvent::Phase phase, quint32 context, Args... args)
+    {
+        TraceEvent event;
+        event.timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        event.phase = phase;
+        event.context = context;
+        FTraceDetail::TraceEventWriter writer(&event);
+        (writer.append(args), ...);
+        commit(event);
+    }
+
+    /**
+     * Returns the events recorded during the last @p seconds in all threads, ordered by
+     * their timestamps.
+     */
+    QVector<QPair<quint64, TraceEvent>> recordedEvents(int seconds) const;
+
 Q_SIGNALS:
     void enabledChanged();
+    void recordingChanged();
 
 public Q_SLOTS:
     Q_SCRIPTABLE void setEnabled(bool enabled);
+    Q_SCRIPTABLE void setRecording(bool recording);
+
+    /**
+     * Writes the events recorded during the last @p seconds to @p fileName in the Chrome
+     * trace event format. Returns @c true on success.
+     */
+    Q_SCRIPTABLE bool dumpTrace(const QString &fileName, int seconds);
 
 private:
     static QString filePath();
     bool open();
+    void commit(const TraceEvent &event);
     QFile m_file;
     QMutex m_mutex;
+    std::atomic<bool> m_recording = false;
     KWIN_SINGLETON(FTraceLogger)
 };
 
@@ -74,11 +216,16 @@ public:
     template<typename... Args> FTraceDuration(Args... args)
     {
         static QAtomicInteger<quint32> s_context = 0;
-        QTextStream stream(&m_message);
-        (stream << ... << args);
-        stream.flush();
         m_context = ++s_context;
-        FTraceLogger::self()->trace(m_message, " begin_ctx=", m_context);
+        if (FTraceLogger::self()->isRecording()) {
+            FTraceLogger::self()->record(TraceEvent::Begin, m_context, args...);
+        }
+        if (FTraceLogger::self()->isEnabled()) {
+            QTextStream stream(&m_message);
+            (stream << ... << args);
+            stream.flush();
+            FTraceLogger::self()->write(m_message, " begin_ctx=", m_context);
+        }
     }
 
     ~FTraceDuration();
@@ -94,7 +241,7 @@ private:
  * Optimised macro, arguments are only copied if tracing is enabled
  */
 #define fTrace(...)                                                                                                                                            \
-    if (KWin::FTraceLogger::self()->isEnabled())                                                                                                               \
+    if (KWin::FTraceLogger::self()->isEnabled() || KWin::FTraceLogger::self()->isRecording())                                                                  \
         KWin::FTraceLogger::self()->trace(__VA_ARGS__);
 
 /**
@@ -102,4 +249,6 @@ private:
  * In GPUVis this will appear as a timed block with begin_ctx and end_ctx markers
  */
 #define fTraceDuration(...)                                                                                                                                    \
-    QScopedPointer<KWin::FTraceDuration> _duration(KWin::FTraceLogger::self()->isEnabled() ? new KWin::FTraceDuration(__VA_ARGS__) : nullptr);
+    std::optional<KWin::FTraceDuration> _duration;                                                                                                             \
+    if (KWin::FTraceLogger::self()->isEnabled() || KWin::FTraceLogger::self()->isRecording())                                                                  \
+        _duration.emplace(__VA_ARGS__);
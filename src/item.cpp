@@ -26,9 +26,9 @@ Item::Item(Item *parent)
 Item::~Item()
 {
     setParentItem(nullptr);
-    for (const auto &dirty : qAsConst(m_repaints)) {
-        if (!dirty.isEmpty()) {
-            Compositor::self()->scene()->addRepaint(dirty);
+    for (const RepaintSlot &slot : qAsConst(m_repaints)) {
+        if (!slot.region.isEmpty()) {
+            Compositor::self()->scene()->addRepaint(slot.region);
         }
     }
 }
@@ -64,6 +64,7 @@ void Item::setParentItem(Item *item)
         m_parentItem->removeChild(this);
     }
     m_parentItem = item;
+    invalidateWorldTransform();
     if (m_parentItem) {
         m_parentItem->addChild(this);
     }
@@ -76,6 +77,8 @@ void Item::addChild(Item *item)
 
     m_childItems.append(item);
     markSortedChildItemsDirty();
+    // The repaints of the new child are not known on any output yet.
+    markSubtreeRepaintsDirty();
 
     updateBoundingRect();
     scheduleRepaint(item->boundingRect().translated(item->position()));
@@ -107,6 +110,7 @@ void Item::setPosition(const QPoint &point)
     if (m_position != point) {
         scheduleRepaint(boundingRect());
         m_position = point;
+        invalidateWorldTransform();
         if (m_parentItem) {
             m_parentItem->updateBoundingRect();
         }
@@ -159,15 +163,10 @@ void Item::updateBoundingRect()
 
 QPoint Item::rootPosition() const
 {
-    QPoint ret = position();
-
-    Item *parent = parentItem();
-    while (parent) {
-        ret += parent->position();
-        parent = parent->parentItem();
+    if (!m_rootPosition.has_value()) {
+        m_rootPosition = m_parentItem ? m_parentItem->rootPosition() + m_position : m_position;
     }
-
-    return ret;
+    return m_rootPosition.value();
 }
 
 QMatrix4x4 Item::transform() const
@@ -177,7 +176,38 @@ QMatrix4x4 Item::transform() const
 
 void Item::setTransform(const QMatrix4x4 &transform)
 {
-    m_transform = transform;
+    if (m_transform != transform) {
+        m_transform = transform;
+        invalidateWorldTransform();
+    }
+}
+
+QMatrix4x4 Item::worldTransform() const
+{
+    if (!m_worldTransform.has_value()) {
+        QMatrix4x4 matrix;
+        if (m_parentItem) {
+            matrix = m_parentItem->worldTransform();
+        }
+        matrix.translate(m_position.x(), m_position.y());
+        matrix *= m_transform;
+        m_worldTransform = matrix;
+    }
+    return m_worldTransform.value();
+}
+
+void Item::invalidateWorldTransform()
+{
+    // The cached values of the descendants are computed from the cached values of this
+    // item, so they must already be invalid if the cache of this item is invalid.
+    if (!m_rootPosition.has_value() && !m_worldTransform.has_value()) {
+        return;
+    }
+    m_rootPosition.reset();
+    m_worldTransform.reset();
+    for (Item *childItem : qAsConst(m_childItems)) {
+        childItem->invalidateWorldTransform();
+    }
 }
 
 QRegion Item::mapToGlobal(const QRegion &region) const
@@ -257,16 +287,32 @@ void Item::scheduleRepaintInternal(const QRegion &region)
 {
     const QRegion globalRegion = mapToGlobal(region);
     if (kwinApp()->platform()->isPerScreenRenderingEnabled()) {
-        const QVector<AbstractOutput *> outputs = kwinApp()->platform()->enabledOutputs();
-        for (const auto &output : outputs) {
-            const QRegion dirtyRegion = globalRegion & output->geometry();
-            if (!dirtyRegion.isEmpty()) {
-                m_repaints[output] += dirtyRegion;
-                output->renderLoop()->scheduleRepaint(this);
+        const QRect bounds = globalRegion.boundingRect();
+        const QVector<Platform::OutputSlot> &outputSlots = kwinApp()->platform()->outputSlots();
+        for (int i = 0; i < outputSlots.count(); ++i) {
+            const Platform::OutputSlot &outputSlot = outputSlots[i];
+            if (!outputSlot.output || !outputSlot.geometry.intersects(bounds)) {
+                continue;
+            }
+            RepaintSlot &slot = repaintSlot(i);
+            if (outputSlot.geometry.contains(bounds)) {
+                slot.region += globalRegion;
+            } else {
+                const QRegion dirtyRegion = globalRegion & outputSlot.geometry;
+                if (dirtyRegion.isEmpty()) {
+                    continue;
+                }
+                slot.region += dirtyRegion;
             }
+            slot.valid = true;
+            markSubtreeRepaintsDirty(i);
+            outputSlot.output->renderLoop()->scheduleRepaint(this);
         }
     } else {
-        m_repaints[nullptr] += globalRegion;
+        RepaintSlot &slot = repaintSlot(0);
+        slot.region += globalRegion;
+        slot.valid = true;
+        markSubtreeRepaintsDirty(0);
         kwinApp()->platform()->renderLoop()->scheduleRepaint(this);
     }
 }
@@ -278,10 +324,10 @@ void Item::scheduleFrame()
     }
     if (kwinApp()->platform()->isPerScreenRenderingEnabled()) {
         const QRect geometry = mapToGlobal(rect());
-        const QVector<AbstractOutput *> outputs = kwinApp()->platform()->enabledOutputs();
-        for (const AbstractOutput *output : outputs) {
-            if (output->geometry().intersects(geometry)) {
-                output->renderLoop()->scheduleRepaint(this);
+        const QVector<Platform::OutputSlot> &outputSlots = kwinApp()->platform()->outputSlots();
+        for (const Platform::OutputSlot &outputSlot : outputSlots) {
+            if (outputSlot.output && outputSlot.geometry.intersects(geometry)) {
+                outputSlot.output->renderLoop()->scheduleRepaint(this);
             }
         }
     } else {
@@ -293,9 +339,9 @@ void Item::preprocess()
 {
 }
 
-WindowQuadList Item::buildQuads() const
+WindowQuadArray Item::buildQuads() const
 {
-    return WindowQuadList();
+    return WindowQuadArray();
 }
 
 void Item::discardQuads()
@@ -303,7 +349,7 @@ void Item::discardQuads()
     m_quads.reset();
 }
 
-WindowQuadList Item::quads() const
+WindowQuadArray Item::quads() const
 {
     if (!m_quads.has_value()) {
         m_quads = buildQuads();
@@ -311,19 +357,85 @@ WindowQuadList Item::quads() const
     return m_quads.value();
 }
 
+// Without per screen rendering, the repaints are stored for the null output in the first slot.
+static int repaintSlotIndex(const AbstractOutput *output)
+{
+    return output ? output->index() : 0;
+}
+
+Item::RepaintSlot &Item::repaintSlot(int slot)
+{
+    if (slot >= m_repaints.count()) {
+        m_repaints.resize(slot + 1);
+    }
+    return m_repaints[slot];
+}
+
 QRegion Item::repaints(AbstractOutput *output) const
 {
-    return m_repaints.value(output, QRect(QPoint(0, 0), screens()->size()));
+    const int slot = repaintSlotIndex(output);
+    if (slot < 0 || slot >= m_repaints.count() || !m_repaints[slot].valid) {
+        return QRect(QPoint(0, 0), screens()->size());
+    }
+    return m_repaints[slot].region;
 }
 
 void Item::resetRepaints(AbstractOutput *output)
 {
-    m_repaints.insert(output, QRegion());
+    const int slot = repaintSlotIndex(output);
+    Q_ASSERT(slot >= 0);
+
+    RepaintSlot &repaints = repaintSlot(slot);
+    repaints.region = QRegion();
+    repaints.valid = true;
+
+    for (const Item *childItem : qAsConst(m_childItems)) {
+        if (childItem->hasSubtreeRepaints(output)) {
+            return;
+        }
+    }
+    repaints.subtreeClean = true;
 }
 
 void Item::removeRepaints(AbstractOutput *output)
 {
-    m_repaints.remove(output);
+    // The slot can be reused by another output later.
+    const int slot = repaintSlotIndex(output);
+    if (slot >= 0 && slot < m_repaints.count()) {
+        m_repaints[slot] = RepaintSlot();
+    }
+}
+
+bool Item::hasSubtreeRepaints(AbstractOutput *output) const
+{
+    const int slot = repaintSlotIndex(output);
+    return slot < 0 || slot >= m_repaints.count() || !m_repaints[slot].subtreeClean;
+}
+
+void Item::markSubtreeRepaintsDirty(int slot)
+{
+    // An item can't be clean if one of its descendants is dirty, so stop at the first
+    // ancestor that is already dirty.
+    for (Item *item = this; item; item = item->m_parentItem) {
+        if (slot >= item->m_repaints.count() || !item->m_repaints[slot].subtreeClean) {
+            break;
+        }
+        item->m_repaints[slot].subtreeClean = false;
+    }
+}
+
+void Item::markSubtreeRepaintsDirty()
+{
+    for (Item *item = this; item; item = item->m_parentItem) {
+        bool wasClean = false;
+        for (RepaintSlot &slot : item->m_repaints) {
+            wasClean |= slot.subtreeClean;
+            slot.subtreeClean = false;
+        }
+        if (!wasClean) {
+            break;
+        }
+    }
 }
 
 bool Item::isVisible() const
@@ -11,6 +11,7 @@
 
 #include <QMatrix4x4>
 #include <QObject>
+#include <QVarLengthArray>
 
 #include <optional>
 
@@ -57,10 +58,20 @@ public:
     QList<Item *> childItems() const;
     QList<Item *> sortedChildItems() const;
 
+    /**
+     * Returns the position of the item in the scene's coordinate system. The position is
+     * cached and only recomputed after the item or one of its ancestors has moved.
+     */
     QPoint rootPosition() const;
 
     QMatrix4x4 transform() const;
     void setTransform(const QMatrix4x4 &transform);
+    /**
+     * Returns the transform that maps the item's coordinate system to the scene's coordinate
+     * system, i.e. the positions and the transforms of the item and all of its ancestors
+     * combined. The world transform is cached the same way as the root position.
+     */
+    QMatrix4x4 worldTransform() const;
 
     /**
      * Maps the given @a region from the item's coordinate system to the scene's coordinate
@@ -89,8 +100,13 @@ public:
     void scheduleFrame();
     QRegion repaints(AbstractOutput *output) const;
     void resetRepaints(AbstractOutput *output);
+    /**
+     * Returns @c true if this item or any of its descendants has repaints on the specified
+     * @a output. Subtrees without repaints need not be visited when collecting repaints.
+     */
+    bool hasSubtreeRepaints(AbstractOutput *output) const;
 
-    WindowQuadList quads() const;
+    WindowQuadArray quads() const;
     virtual void preprocess();
 
 Q_SIGNALS:
@@ -110,7 +126,7 @@ Q_SIGNALS:
     void boundingRectChanged();
 
 protected:
-    virtual WindowQuadList buildQuads() const;
+    virtual WindowQuadArray buildQuads() const;
     void discardQuads();
 
 private:
@@ -123,6 +139,9 @@ private:
     bool computeEffectiveVisibility() const;
     void updateEffectiveVisibility();
     void removeRepaints(AbstractOutput *output);
+    void markSubtreeRepaintsDirty(int slot);
+    void markSubtreeRepaintsDirty();
+    void invalidateWorldTransform();
 
     QPointer<Item> m_parentItem;
     QList<Item *> m_childItems;
@@ -133,8 +152,21 @@ private:
     int m_z = 0;
     bool m_visible = true;
     bool m_effectiveVisible = true;
-    QMap<AbstractOutput *, QRegion> m_repaints;
-    mutable std::optional<WindowQuadList> m_quads;
+
+    struct RepaintSlot
+    {
+        QRegion region;
+        // If not set, the whole screen needs to be repainted.
+        bool valid = false;
+        // If an item is clean on an output, so are all of its descendants.
+        bool subtreeClean = false;
+    };
+    RepaintSlot &repaintSlot(int slot);
+    // Indexed by AbstractOutput::index().
+    QVarLengthArray<RepaintSlot, 2> m_repaints;
+    mutable std::optional<QPoint> m_rootPosition;
+    mutable std::optional<QMatrix4x4> m_worldTransform;
+    mutable std::optional<WindowQuadArray> m_quads;
     mutable std::optional<QList<Item *>> m_sortedChildItems;
 };
 
@@ -64,7 +64,7 @@ AniData::AniData()
  , startTime(0)
  , waitAtSource(false)
  , keepAlive(true)
- , lastPresentTime(std::chrono::milliseconds::zero())
+ , ticking(false)
 {
 }
 
@@ -81,7 +81,7 @@ AniData::AniData(AnimationEffect::Attribute a, int meta_, const FPx2 &to_,
  , waitAtSource(waitAtSource_)
  , keepAlive(keepAlive)
  , previousWindowPixmapLock(std::move(previousWindowPixmapLock_))
- , lastPresentTime(std::chrono::milliseconds::zero())
+ , ticking(false)
 {
 }
 
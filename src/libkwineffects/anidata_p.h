@@ -88,7 +88,11 @@ public:
     KeepAliveLockPtr keepAliveLock;
     PreviousWindowPixmapLockPtr previousWindowPixmapLock;
     AnimationEffect::TerminationFlags terminationFlags;
-    std::chrono::milliseconds lastPresentTime;
+    /**
+     * Whether the animation has been started in a previous frame. Its time line is advanced
+     * by the time that has passed since then, which is the same for all animations.
+     */
+    bool ticking;
 };
 
 } // namespace
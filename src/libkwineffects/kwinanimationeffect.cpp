@@ -29,12 +29,59 @@ QElapsedTimer AnimationEffect::s_clock;
 
 class AnimationEffectPrivate {
 public:
+    /**
+     * The animations of one window. The entries and their animations are stored next to each
+     * other, so the walks over all animations in every frame don't chase pointers.
+     */
+    struct Entry {
+        EffectWindow *window = nullptr;
+        QVector<AniData> animations;
+        QRect layerRect; // the area repainted for the window, null if it has to be computed again
+    };
+
     AnimationEffectPrivate()
     {
         m_animationsTouched = m_isInitialized = false;
         m_justEndedAnimation = 0;
     }
-    AnimationEffect::AniMap m_animations;
+
+    Entry *find(const EffectWindow *w)
+    {
+        const int index = m_indices.value(w, -1);
+        return index != -1 ? &m_entries[index] : nullptr;
+    }
+    const Entry *find(const EffectWindow *w) const
+    {
+        const int index = m_indices.value(w, -1);
+        return index != -1 ? &m_entries[index] : nullptr;
+    }
+    Entry &findOrInsert(EffectWindow *w)
+    {
+        const int index = m_indices.value(w, -1);
+        if (index != -1) {
+            return m_entries[index];
+        }
+        m_indices.insert(w, m_entries.count());
+        m_entries.append(Entry());
+        m_entries.last().window = w;
+        return m_entries.last();
+    }
+    /**
+     * Removes the entry at @p index by moving the last entry into its place.
+     */
+    void remove(int index)
+    {
+        m_indices.remove(m_entries.at(index).window);
+        if (index != m_entries.count() - 1) {
+            m_entries[index] = std::move(m_entries.last());
+            m_indices.insert(m_entries.at(index).window, index);
+        }
+        m_entries.removeLast();
+    }
+
+    QVector<Entry> m_entries;
+    QHash<const EffectWindow *, int> m_indices;
+    std::chrono::milliseconds m_lastPresentTime = std::chrono::milliseconds::zero();
     static quint64 m_animCounter;
     quint64 m_justEndedAnimation; // protect against cancel
     QWeakPointer<FullScreenEffectLock> m_fullScreenEffectLock;
@@ -75,7 +122,7 @@ void AnimationEffect::init()
 bool AnimationEffect::isActive() const
 {
     Q_D(const AnimationEffect);
-    return !d->m_animations.isEmpty() && !effects->isScreenLocked();
+    return !d->m_entries.isEmpty() && !effects->isScreenLocked();
 }
 
 
@@ -211,13 +258,14 @@ quint64 AnimationEffect::p_animate( EffectWindow *w, Attribute a, uint meta, int
     Q_D(AnimationEffect);
     if (!d->m_isInitialized)
         init(); // needs to ensure the window gets removed if deleted in the same event cycle
-    if (d->m_animations.isEmpty()) {
+    if (d->m_entries.isEmpty()) {
         connect(effects, &EffectsHandler::windowExpandedGeometryChanged,
                 this, &AnimationEffect::_windowExpandedGeometryChanged);
     }
-    AniMap::iterator it = d->m_animations.find(w);
-    if (it == d->m_animations.end())
-        it = d->m_animations.insert(w, QPair<QList<AniData>, QRect>(QList<AniData>(), QRect()));
+    if (!d->find(w)) {
+        effects->setWindowInterest(this, w, true);
+    }
+    AnimationEffectPrivate::Entry &entry = d->findOrInsert(w);
 
     FullScreenEffectLockPtr fullscreen;
     if (fullScreenEffect) {
@@ -234,7 +282,7 @@ quint64 AnimationEffect::p_animate( EffectWindow *w, Attribute a, uint meta, int
         previousPixmap = PreviousWindowPixmapLockPtr::create(w);
     }
 
-    it->first.append(AniData(
+    entry.animations.append(AniData(
         a,              // Attribute
         meta,           // Metadata
         to,             // Target
@@ -247,7 +295,7 @@ quint64 AnimationEffect::p_animate( EffectWindow *w, Attribute a, uint meta, int
     ));
 
     const quint64 ret_id = ++d->m_animCounter;
-    AniData &animation = it->first.last();
+    AniData &animation = entry.animations.last();
     animation.id = ret_id;
 
     animation.timeLine.setDirection(TimeLine::Forward);
@@ -261,7 +309,7 @@ quint64 AnimationEffect::p_animate( EffectWindow *w, Attribute a, uint meta, int
         animation.terminationFlags |= TerminateAtTarget;
     }
 
-    it->second = QRect();
+    entry.layerRect = QRect();
 
     d->m_animationsTouched = true;
 
@@ -272,7 +320,13 @@ quint64 AnimationEffect::p_animate( EffectWindow *w, Attribute a, uint meta, int
             w->addLayerRepaint(0, 0, s.width(), s.height());
     }
     else {
-        triggerRepaint();
+        // Only the repaint area of this window has changed, the others stay cached
+        updateLayerRepaints();
+        if (d->m_needSceneRepaint) {
+            effects->addRepaintFull();
+        } else {
+            w->addLayerRepaint(entry.layerRect);
+        }
     }
     return ret_id;
 }
@@ -282,13 +336,11 @@ bool AnimationEffect::retarget(quint64 animationId, FPx2 newTarget, int newRemai
     Q_D(AnimationEffect);
     if (animationId == d->m_justEndedAnimation)
         return false; // this is just ending, do not try to retarget it
-    for (AniMap::iterator entry = d->m_animations.begin(),
-                         mapEnd = d->m_animations.end(); entry != mapEnd; ++entry) {
-        for (QList<AniData>::iterator anim = entry->first.begin(),
-                                   animEnd = entry->first.end(); anim != animEnd; ++anim) {
+    for (AnimationEffectPrivate::Entry &entry : d->m_entries) {
+        for (auto anim = entry.animations.begin(); anim != entry.animations.end(); ++anim) {
             if (anim->id == animationId) {
                 anim->from.set(interpolated(*anim, 0), interpolated(*anim, 1));
-                validate(anim->attribute, anim->meta, nullptr, &newTarget, entry.key());
+                validate(anim->attribute, anim->meta, nullptr, &newTarget, entry.window);
                 anim->to.set(newTarget[0], newTarget[1]);
 
                 anim->timeLine.setDirection(TimeLine::Forward);
@@ -310,13 +362,13 @@ bool AnimationEffect::redirect(quint64 animationId, Direction direction, Termina
         return false;
     }
 
-    for (auto entryIt = d->m_animations.begin(); entryIt != d->m_animations.end(); ++entryIt) {
-        auto animIt = std::find_if(entryIt->first.begin(), entryIt->first.end(),
+    for (AnimationEffectPrivate::Entry &entry : d->m_entries) {
+        auto animIt = std::find_if(entry.animations.begin(), entry.animations.end(),
             [animationId] (AniData &anim) {
                 return anim.id == animationId;
             }
         );
-        if (animIt == entryIt->first.end()) {
+        if (animIt == entry.animations.end()) {
             continue;
         }
 
@@ -346,13 +398,13 @@ bool AnimationEffect::complete(quint64 animationId)
         return false;
     }
 
-    for (auto entryIt = d->m_animations.begin(); entryIt != d->m_animations.end(); ++entryIt) {
-        auto animIt = std::find_if(entryIt->first.begin(), entryIt->first.end(),
+    for (AnimationEffectPrivate::Entry &entry : d->m_entries) {
+        auto animIt = std::find_if(entry.animations.begin(), entry.animations.end(),
             [animationId] (AniData &anim) {
                 return anim.id == animationId;
             }
         );
-        if (animIt == entryIt->first.end()) {
+        if (animIt == entry.animations.end()) {
             continue;
         }
 
@@ -369,14 +421,16 @@ bool AnimationEffect::cancel(quint64 animationId)
     Q_D(AnimationEffect);
     if (animationId == d->m_justEndedAnimation)
         return true; // this is just ending, do not try to cancel it but fake success
-    for (AniMap::iterator entry = d->m_animations.begin(), mapEnd = d->m_animations.end(); entry != mapEnd; ++entry) {
-        for (QList<AniData>::iterator anim = entry->first.begin(), animEnd = entry->first.end(); anim != animEnd; ++anim) {
+    for (int i = 0; i < d->m_entries.count(); ++i) {
+        AnimationEffectPrivate::Entry &entry = d->m_entries[i];
+        for (auto anim = entry.animations.begin(); anim != entry.animations.end(); ++anim) {
             if (anim->id == animationId) {
-                entry->first.erase(anim); // remove the animation
-                if (entry->first.isEmpty()) { // no other animations on the window, release it.
-                    d->m_animations.erase(entry);
+                entry.animations.erase(anim); // remove the animation
+                if (entry.animations.isEmpty()) { // no other animations on the window, release it.
+                    effects->setWindowInterest(this, entry.window, false);
+                    d->remove(i);
                 }
-                if (d->m_animations.isEmpty())
+                if (d->m_entries.isEmpty())
                     disconnectGeometryChanges();
                 d->m_animationsTouched = true; // could be called from animationEnded
                 return true;
@@ -389,18 +443,24 @@ bool AnimationEffect::cancel(quint64 animationId)
 void AnimationEffect::prePaintScreen( ScreenPrePaintData& data, std::chrono::milliseconds presentTime )
 {
     Q_D(AnimationEffect);
-    if (d->m_animations.isEmpty()) {
+    if (d->m_entries.isEmpty()) {
         effects->prePaintScreen(data, presentTime);
         return;
     }
 
-    for (auto entry = d->m_animations.begin(); entry != d->m_animations.end(); ++entry) {
-        for (auto anim = entry->first.begin(); anim != entry->first.end(); ++anim) {
-            if (anim->startTime <= clock()) {
-                if (anim->lastPresentTime.count()) {
-                    anim->timeLine.update(presentTime - anim->lastPresentTime);
+    // All running animations have been advanced in the same frames, one clock serves them all
+    const std::chrono::milliseconds delta = d->m_lastPresentTime.count() ? presentTime - d->m_lastPresentTime
+                                                                          : std::chrono::milliseconds::zero();
+    d->m_lastPresentTime = presentTime;
+
+    const qint64 now = clock();
+    for (AnimationEffectPrivate::Entry &entry : d->m_entries) {
+        for (AniData &anim : entry.animations) {
+            if (anim.startTime <= now) {
+                if (anim.ticking) {
+                    anim.timeLine.update(delta);
                 }
-                anim->lastPresentTime = presentTime;
+                anim.ticking = true;
             }
         }
     }
@@ -457,11 +517,11 @@ void AnimationEffect::disconnectGeometryChanges()
 void AnimationEffect::prePaintWindow( EffectWindow* w, WindowPrePaintData& data, std::chrono::milliseconds presentTime )
 {
     Q_D(AnimationEffect);
-    AniMap::const_iterator entry = d->m_animations.constFind( w );
-    if ( entry != d->m_animations.constEnd() ) {
+    const AnimationEffectPrivate::Entry *entry = d->find(w);
+    if (entry) {
         bool isUsed = false;
         bool paintDeleted = false;
-        for (QList<AniData>::const_iterator anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim) {
+        for (auto anim = entry->animations.constBegin(); anim != entry->animations.constEnd(); ++anim) {
             if (anim->startTime > clock() && !anim->waitAtSource)
                 continue;
 
@@ -500,9 +560,9 @@ static inline float geometryCompensation(int flags, float v)
 void AnimationEffect::paintWindow( EffectWindow* w, int mask, QRegion region, WindowPaintData& data )
 {
     Q_D(AnimationEffect);
-    AniMap::const_iterator entry = d->m_animations.constFind( w );
-    if ( entry != d->m_animations.constEnd() ) {
-        for ( QList<AniData>::const_iterator anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim ) {
+    const AnimationEffectPrivate::Entry *entry = d->find(w);
+    if (entry) {
+        for (auto anim = entry->animations.constBegin(); anim != entry->animations.constEnd(); ++anim) {
 
             if (anim->startTime > clock() && !anim->waitAtSource)
                 continue;
@@ -611,46 +671,41 @@ void AnimationEffect::postPaintScreen()
     d->m_animationsTouched = false;
     bool damageDirty = false;
 
-    for (auto entry = d->m_animations.begin(); entry != d->m_animations.end();) {
+    const qint64 now = clock();
+    for (int i = 0; i < d->m_entries.count();) {
         bool invalidateLayerRect = false;
-        int animCounter = 0;
-        for (auto anim = entry->first.begin(); anim != entry->first.end();) {
-            if (anim->isActive() || anim->startTime > clock() && !anim->waitAtSource) {
-                ++anim;
-                ++animCounter;
+        for (int j = 0; j < d->m_entries.at(i).animations.count();) {
+            const AniData &anim = d->m_entries.at(i).animations.at(j);
+            if (anim.isActive() || anim.startTime > now && !anim.waitAtSource) {
+                ++j;
                 continue;
             }
-            EffectWindow *window = entry.key();
-            d->m_justEndedAnimation = anim->id;
-            animationEnded(window, anim->attribute, anim->meta);
+            EffectWindow *window = d->m_entries.at(i).window;
+            d->m_justEndedAnimation = anim.id;
+            animationEnded(window, anim.attribute, anim.meta);
             d->m_justEndedAnimation = 0;
             // NOTICE animationEnded is an external call and might have called "::animate"
-            // as a result our iterators could now point random junk on the heap
-            // so we've to restore the former states, ie. find our window list and animation
+            // as a result the storage could have been reallocated, so we've to look up our
+            // window again. New animations are appended, our animation keeps its position
             if (d->m_animationsTouched) {
                 d->m_animationsTouched = false;
-                entry = d->m_animations.begin();
-                while (entry.key() != window && entry != d->m_animations.end()) {
-                    ++entry;
-                }
-                Q_ASSERT(entry != d->m_animations.end()); // usercode should not delete animations from animationEnded (not even possible atm.)
-                anim = entry->first.begin();
-                Q_ASSERT(animCounter < entry->first.count());
-                for (int i = 0; i < animCounter; ++i) {
-                    ++anim;
-                }
+                i = d->m_indices.value(window, -1);
+                Q_ASSERT(i != -1); // usercode should not delete animations from animationEnded (not even possible atm.)
+                Q_ASSERT(j < d->m_entries.at(i).animations.count());
             }
-            anim = entry->first.erase(anim);
+            d->m_entries[i].animations.remove(j);
             invalidateLayerRect = damageDirty = true;
         }
-        if (entry->first.isEmpty()) {
-            effects->addRepaint(entry->second);
-            entry = d->m_animations.erase(entry);
+        AnimationEffectPrivate::Entry &entry = d->m_entries[i];
+        if (entry.animations.isEmpty()) {
+            effects->addRepaint(entry.layerRect);
+            effects->setWindowInterest(this, entry.window, false);
+            d->remove(i); // the last entry takes its place
         } else {
             if (invalidateLayerRect) {
-                *const_cast<QRect*>(&(entry->second)) = QRect(); // invalidate
+                entry.layerRect = QRect(); // invalidate
             }
-            ++entry;
+            ++i;
         }
     }
 
@@ -660,12 +715,12 @@ void AnimationEffect::postPaintScreen()
     if (d->m_needSceneRepaint) {
         effects->addRepaintFull();
     } else {
-        for (auto entry = d->m_animations.constBegin(); entry != d->m_animations.constEnd(); ++entry) {
-            for (auto anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim) {
-                if (anim->startTime > clock())
+        for (const AnimationEffectPrivate::Entry &entry : qAsConst(d->m_entries)) {
+            for (const AniData &anim : entry.animations) {
+                if (anim.startTime > now)
                     continue;
-                if (!anim->timeLine.done()) {
-                    entry.key()->addLayerRepaint(entry->second);
+                if (!anim.timeLine.done()) {
+                    entry.window->addLayerRepaint(entry.layerRect);
                     break;
                 }
             }
@@ -673,7 +728,7 @@ void AnimationEffect::postPaintScreen()
     }
 
     // janitorial...
-    if (d->m_animations.isEmpty()) {
+    if (d->m_entries.isEmpty()) {
         disconnectGeometryChanges();
     }
 
@@ -754,15 +809,14 @@ void AnimationEffect::setMetaData( MetaType type, uint value, uint &meta )
 void AnimationEffect::triggerRepaint()
 {
     Q_D(AnimationEffect);
-    for (AniMap::const_iterator entry = d->m_animations.constBegin(), mapEnd = d->m_animations.constEnd(); entry != mapEnd; ++entry)
-        *const_cast<QRect*>(&(entry->second)) = QRect();
+    for (AnimationEffectPrivate::Entry &entry : d->m_entries)
+        entry.layerRect = QRect();
     updateLayerRepaints();
     if (d->m_needSceneRepaint) {
         effects->addRepaintFull();
     } else {
-        AniMap::const_iterator it = d->m_animations.constBegin(), end = d->m_animations.constEnd();
-        for (; it != end; ++it) {
-            it.key()->addLayerRepaint(it->second);
+        for (const AnimationEffectPrivate::Entry &entry : qAsConst(d->m_entries)) {
+            entry.window->addLayerRepaint(entry.layerRect);
         }
     }
 }
@@ -789,16 +843,17 @@ void AnimationEffect::updateLayerRepaints()
 {
     Q_D(AnimationEffect);
     d->m_needSceneRepaint = false;
-    for (AniMap::const_iterator entry = d->m_animations.constBegin(), mapEnd = d->m_animations.constEnd(); entry != mapEnd; ++entry) {
-        if (!entry->second.isNull())
+    const qint64 now = clock();
+    for (auto entry = d->m_entries.begin(), entriesEnd = d->m_entries.end(); entry != entriesEnd; ++entry) {
+        if (!entry->layerRect.isNull())
             continue;
         float f[2] = {1.0, 1.0};
         float t[2] = {0.0, 0.0};
         bool createRegion = false;
         QList<QRect> rects;
-        QRect *layerRect = const_cast<QRect*>(&(entry->second));
-        for (QList<AniData>::const_iterator anim = entry->first.constBegin(), animEnd = entry->first.constEnd(); anim != animEnd; ++anim) {
-            if (anim->startTime > clock())
+        QRect *layerRect = &entry->layerRect;
+        for (auto anim = entry->animations.constBegin(), animEnd = entry->animations.constEnd(); anim != animEnd; ++anim) {
+            if (anim->startTime > now)
                 continue;
             switch (anim->attribute) {
                 case Opacity:
@@ -817,7 +872,7 @@ void AnimationEffect::updateLayerRepaints()
                 case Translation:
                 case Position: {
                     createRegion = true;
-                    QRect r(entry.key()->frameGeometry());
+                    QRect r(entry->window->frameGeometry());
                     int x[2] = {0,0};
                     int y[2] = {0,0};
                     if (anim->attribute == Translation) {
@@ -835,7 +890,7 @@ void AnimationEffect::updateLayerRepaints()
                             y[1] = anim->to[1] - yCoord(r, metaData(TargetAnchor, anim->meta));
                         }
                     }
-                    r = entry.key()->expandedGeometry();
+                    r = entry->window->expandedGeometry();
                     rects << r.translated(x[0], y[0]) << r.translated(x[1], y[1]);
                     break;
                 }
@@ -845,7 +900,7 @@ void AnimationEffect::updateLayerRepaints()
                 case Size:
                 case Scale: {
                     createRegion = true;
-                    const QSize sz = entry.key()->frameGeometry().size();
+                    const QSize sz = entry->window->frameGeometry().size();
                     float fx = qMax(fixOvershoot(anim->from[0], *anim, 1), fixOvershoot(anim->to[0], *anim, 2));
 //                     float fx = qMax(interpolated(*anim,0), anim->to[0]);
                     if (fx >= 0.0) {
@@ -873,7 +928,7 @@ void AnimationEffect::updateLayerRepaints()
         }
 region_creation:
         if (createRegion) {
-            const QRect geo = entry.key()->expandedGeometry();
+            const QRect geo = entry->window->expandedGeometry();
             if (rects.isEmpty())
                 rects << geo;
             QList<QRect>::const_iterator r, rEnd = rects.constEnd();
@@ -897,12 +952,12 @@ region_creation:
 void AnimationEffect::_windowExpandedGeometryChanged(KWin::EffectWindow *w)
 {
     Q_D(AnimationEffect);
-    AniMap::const_iterator entry = d->m_animations.constFind(w);
-    if (entry != d->m_animations.constEnd()) {
-        *const_cast<QRect*>(&(entry->second)) = QRect();
+    AnimationEffectPrivate::Entry *entry = d->find(w);
+    if (entry) {
+        entry->layerRect = QRect();
         updateLayerRepaints();
-        if (!entry->second.isNull()) // actually got updated, ie. is in use - ensure it get's a repaint
-            w->addLayerRepaint(entry->second);
+        if (!entry->layerRect.isNull()) // actually got updated, ie. is in use - ensure it get's a repaint
+            w->addLayerRepaint(entry->layerRect);
     }
 }
 
@@ -910,14 +965,14 @@ void AnimationEffect::_windowClosed( EffectWindow* w )
 {
     Q_D(AnimationEffect);
 
-    auto it = d->m_animations.find(w);
-    if (it == d->m_animations.end()) {
+    AnimationEffectPrivate::Entry *entry = d->find(w);
+    if (!entry) {
         return;
     }
 
     KeepAliveLockPtr keepAliveLock;
 
-    QList<AniData> &animations = (*it).first;
+    QVector<AniData> &animations = entry->animations;
     for (auto animationIt = animations.begin();
             animationIt != animations.end();
             ++animationIt) {
@@ -936,7 +991,11 @@ void AnimationEffect::_windowClosed( EffectWindow* w )
 void AnimationEffect::_windowDeleted( EffectWindow* w )
 {
     Q_D(AnimationEffect);
-    d->m_animations.remove( w );
+    const int index = d->m_indices.value(w, -1);
+    if (index != -1) {
+        d->remove(index);
+        effects->setWindowInterest(this, w, false);
+    }
 }
 
 
@@ -944,18 +1003,16 @@ QString AnimationEffect::debug(const QString &/*parameter*/) const
 {
     Q_D(const AnimationEffect);
     QString dbg;
-    if (d->m_animations.isEmpty())
+    if (d->m_entries.isEmpty())
         dbg = QStringLiteral("No window is animated");
     else {
-        AniMap::const_iterator entry = d->m_animations.constBegin(), mapEnd = d->m_animations.constEnd();
-        for (; entry != mapEnd; ++entry) {
-            QString caption = entry.key()->isDeleted() ? QStringLiteral("[Deleted]") : entry.key()->caption();
+        for (const AnimationEffectPrivate::Entry &entry : d->m_entries) {
+            QString caption = entry.window->isDeleted() ? QStringLiteral("[Deleted]") : entry.window->caption();
             if (caption.isEmpty())
                 caption = QStringLiteral("[Untitled]");
             dbg += QLatin1String("Animating window: ") + caption + QLatin1Char('\n');
-            QList<AniData>::const_iterator anim = entry->first.constBegin(), animEnd = entry->first.constEnd();
-            for (; anim != animEnd; ++anim)
-                dbg += anim->debugInfo();
+            for (const AniData &anim : entry.animations)
+                dbg += anim.debugInfo();
         }
     }
     return dbg;
@@ -964,7 +1021,11 @@ QString AnimationEffect::debug(const QString &/*parameter*/) const
 AnimationEffect::AniMap AnimationEffect::state() const
 {
     Q_D(const AnimationEffect);
-    return d->m_animations;
+    AniMap state;
+    for (const AnimationEffectPrivate::Entry &entry : d->m_entries) {
+        state.insert(entry.window, qMakePair(entry.animations.toList(), entry.layerRect));
+    }
+    return state;
 }
 
 } // namespace KWin
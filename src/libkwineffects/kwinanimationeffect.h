@@ -93,6 +93,10 @@ class AnimationEffectPrivate;
  * You can provide your own implementation of the Generic attribute if none of the
  * standard attributes(e.g. size, position, etc) satisfy your requirements.
  *
+ * The animated windows are declared with EffectsHandler::setWindowInterest(). Subclasses that
+ * don't paint any other windows can return @c true from declaresWindowInterest(), so they are
+ * skipped for the windows that aren't animated.
+ *
  * @since 4.8
  */
 class KWINEFFECTS_EXPORT AnimationEffect : public Effect
@@ -13,8 +13,12 @@ namespace KWin
 
 struct DeformOffscreenData
 {
-    QScopedPointer<GLTexture> texture;
-    QScopedPointer<GLRenderTarget> renderTarget;
+    ~DeformOffscreenData()
+    {
+        GLRenderTargetPool::instance()->release(target);
+    }
+
+    GLRenderTargetPool::Target *target = nullptr;
     bool isDirty = true;
 };
 
@@ -85,16 +89,17 @@ GLTexture *DeformEffectPrivate::maybeRender(EffectWindow *window, DeformOffscree
         textureSize *= screen->devicePixelRatio();
     }
 
-    if (!offscreenData->texture || offscreenData->texture->size() != textureSize) {
-        offscreenData->texture.reset(new GLTexture(GL_RGBA8, textureSize));
-        offscreenData->texture->setFilter(GL_LINEAR);
-        offscreenData->texture->setWrapMode(GL_CLAMP_TO_EDGE);
-        offscreenData->renderTarget.reset(new GLRenderTarget(*offscreenData->texture));
+    if (!offscreenData->target || offscreenData->target->texture()->size() != textureSize) {
+        GLRenderTargetPool::instance()->release(offscreenData->target);
+        offscreenData->target = GLRenderTargetPool::instance()->acquire(textureSize);
+        if (!offscreenData->target) {
+            return nullptr;
+        }
         offscreenData->isDirty = true;
     }
 
     if (offscreenData->isDirty) {
-        GLRenderTarget::pushRenderTarget(offscreenData->renderTarget.data());
+        GLRenderTarget::pushRenderTarget(offscreenData->target->renderTarget());
         glClearColor(0.0, 0.0, 0.0, 0.0);
         glClear(GL_COLOR_BUFFER_BIT);
 
@@ -114,7 +119,7 @@ GLTexture *DeformEffectPrivate::maybeRender(EffectWindow *window, DeformOffscree
         offscreenData->isDirty = false;
     }
 
-    return offscreenData->texture.data();
+    return offscreenData->target->texture();
 }
 
 void DeformEffectPrivate::paint(EffectWindow *window, GLTexture *texture, const QRegion &region,
@@ -141,9 +146,9 @@ void DeformEffectPrivate::paint(EffectWindow *window, GLTexture *texture, const
     quads.makeInterleavedArrays(primitiveType, map, texture->matrix(NormalizedCoordinates));
     vbo->unmap();
     vbo->bindArrays();
-    glEnable(GL_SCISSOR_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::enable(GL_SCISSOR_TEST);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     const qreal rgb = data.brightness() * data.opacity();
     const qreal a = data.opacity();
@@ -158,8 +163,8 @@ void DeformEffectPrivate::paint(EffectWindow *window, GLTexture *texture, const
     vbo->draw(region, primitiveType, 0, verticesPerQuad * quads.count(), true);
     texture->unbind();
 
-    glDisable(GL_BLEND);
-    glDisable(GL_SCISSOR_TEST);
+    GLState::disable(GL_BLEND);
+    GLState::disable(GL_SCISSOR_TEST);
     vbo->unbindArrays();
 }
 
@@ -187,6 +192,10 @@ void DeformEffect::drawWindow(EffectWindow *window, int mask, const QRegion& reg
     deform(window, mask, data, quads);
 
     GLTexture *texture = d->maybeRender(window, offscreenData);
+    if (!texture) {
+        effects->drawWindow(window, mask, region, data);
+        return;
+    }
     d->paint(window, texture, region, data, quads);
 }
 
@@ -21,11 +21,15 @@
 #include <QPixmap>
 #include <QtMath>
 
+#include <algorithm>
+
 #include <ksharedconfig.h>
 #include <kconfiggroup.h>
 
 #if defined(__SSE2__)
 #  include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#  include <arm_neon.h>
 #endif
 
 
@@ -729,6 +733,11 @@ bool Effect::blocksDirectScanout() const
     return true;
 }
 
+bool Effect::declaresWindowInterest() const
+{
+    return false;
+}
+
 //****************************************
 // EffectFactory
 //****************************************
@@ -1236,6 +1245,309 @@ void WindowQuadList::makeArrays(float **vertices, float **texcoords, const QSize
     }
 }
 
+/***************************************************************
+ WindowQuadArray
+***************************************************************/
+
+WindowQuadArray::WindowQuadArray(const WindowQuadList &quads)
+{
+    reserve(quads.count());
+    for (const WindowQuad &quad : quads) {
+        append(quad);
+    }
+}
+
+int WindowQuadArray::count() const
+{
+    return m_x.count() / 4;
+}
+
+bool WindowQuadArray::isEmpty() const
+{
+    return m_x.isEmpty();
+}
+
+void WindowQuadArray::reserve(int count)
+{
+    m_x.reserve(count * 4);
+    m_y.reserve(count * 4);
+    m_u.reserve(count * 4);
+    m_v.reserve(count * 4);
+}
+
+void WindowQuadArray::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_u.clear();
+    m_v.clear();
+}
+
+void WindowQuadArray::append(const WindowQuad &quad)
+{
+    for (int i = 0; i < 4; ++i) {
+        m_x.append(quad[i].x());
+        m_y.append(quad[i].y());
+        m_u.append(quad[i].u());
+        m_v.append(quad[i].v());
+    }
+}
+
+void WindowQuadArray::append(const WindowQuadArray &other, int index)
+{
+    const int first = index * 4;
+    m_x.append(other.m_x.constData() + first, 4);
+    m_y.append(other.m_y.constData() + first, 4);
+    m_u.append(other.m_u.constData() + first, 4);
+    m_v.append(other.m_v.constData() + first, 4);
+}
+
+void WindowQuadArray::appendSubQuad(const WindowQuadArray &other, int index, float x1, float y1, float x2, float y2)
+{
+    const QRectF bounds = other.boundingRect(index);
+    Q_ASSERT(x1 < x2 && y1 < y2 && x1 >= bounds.left() && x2 <= bounds.right() && y1 >= bounds.top() && y2 <= bounds.bottom());
+
+    const int first = index * 4;
+    const float *u = other.m_u.constData() + first;
+    const float *v = other.m_v.constData() + first;
+
+    // vertices are clockwise starting from topleft
+    const float xs[] = { x1, x2, x2, x1 };
+    const float ys[] = { y1, y1, y2, y2 };
+
+    const double widthReciprocal = 1 / bounds.width();
+    const double heightReciprocal = 1 / bounds.height();
+
+    for (int i = 0; i < 4; ++i) {
+        const double w1 = (xs[i] - bounds.left()) * widthReciprocal;
+        const double w2 = (ys[i] - bounds.top()) * heightReciprocal;
+
+        // Use bilinear interpolation to compute the texture coords.
+        m_x.append(xs[i]);
+        m_y.append(ys[i]);
+        m_u.append((1 - w1) * (1 - w2) * u[0] + w1 * (1 - w2) * u[1] + w1 * w2 * u[2] + (1 - w1) * w2 * u[3]);
+        m_v.append((1 - w1) * (1 - w2) * v[0] + w1 * (1 - w2) * v[1] + w1 * w2 * v[2] + (1 - w1) * w2 * v[3]);
+    }
+}
+
+WindowQuadArray &WindowQuadArray::operator<<(const WindowQuad &quad)
+{
+    append(quad);
+    return *this;
+}
+
+WindowQuad WindowQuadArray::at(int index) const
+{
+    WindowQuad quad;
+    for (int i = 0; i < 4; ++i) {
+        const int vertex = index * 4 + i;
+        quad[i] = WindowVertex(m_x[vertex], m_y[vertex], m_u[vertex], m_v[vertex]);
+    }
+    return quad;
+}
+
+QRectF WindowQuadArray::boundingRect(int index) const
+{
+    const float *x = m_x.constData() + index * 4;
+    const float *y = m_y.constData() + index * 4;
+    const float left = std::min({x[0], x[1], x[2], x[3]});
+    const float right = std::max({x[0], x[1], x[2], x[3]});
+    const float top = std::min({y[0], y[1], y[2], y[3]});
+    const float bottom = std::max({y[0], y[1], y[2], y[3]});
+    return QRectF(QPointF(left, top), QPointF(right, bottom));
+}
+
+WindowQuadList WindowQuadArray::toList() const
+{
+    WindowQuadList quads;
+    quads.reserve(count());
+    for (int i = 0; i < count(); ++i) {
+        quads.append(at(i));
+    }
+    return quads;
+}
+
+const float *WindowQuadArray::xData() const
+{
+    return m_x.constData();
+}
+
+const float *WindowQuadArray::yData() const
+{
+    return m_y.constData();
+}
+
+const float *WindowQuadArray::uData() const
+{
+    return m_u.constData();
+}
+
+const float *WindowQuadArray::vData() const
+{
+    return m_v.constData();
+}
+
+static void scaleAndTranslate(float *values, int count, float scale, float offset)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 scale4 = _mm_set1_ps(scale);
+    const __m128 offset4 = _mm_set1_ps(offset);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 value = _mm_loadu_ps(values + i);
+        _mm_storeu_ps(values + i, _mm_add_ps(_mm_mul_ps(value, scale4), offset4));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t offset4 = vdupq_n_f32(offset);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(values + i, vmlaq_n_f32(offset4, vld1q_f32(values + i), scale));
+    }
+#endif
+    for (; i < count; ++i) {
+        values[i] = values[i] * scale + offset;
+    }
+}
+
+void WindowQuadArray::transformTextureCoordinates(const QMatrix4x4 &matrix)
+{
+    // Since we know that the texture matrix just scales and translates
+    // we can use this information to optimize the transformation
+    scaleAndTranslate(m_u.data(), m_u.count(), matrix(0, 0), matrix(0, 3));
+    scaleAndTranslate(m_v.data(), m_v.count(), matrix(1, 1), matrix(1, 3));
+}
+
+#if defined(__SSE2__)
+template <bool aligned>
+static inline void storeVertex(GLVertex2D *vertex, __m128 value)
+{
+    if (aligned) {
+        _mm_stream_ps(reinterpret_cast<float *>(vertex), value);
+    } else {
+        _mm_storeu_ps(reinterpret_cast<float *>(vertex), value);
+    }
+}
+
+template <bool aligned>
+static void interleaveQuads(unsigned int type, GLVertex2D *vertex, const float *xs, const float *ys,
+                            const float *us, const float *vs, int quadCount, const QVector2D &coeff, const QVector2D &offset)
+{
+    const __m128 uScale = _mm_set1_ps(coeff.x());
+    const __m128 vScale = _mm_set1_ps(coeff.y());
+    const __m128 uOffset = _mm_set1_ps(offset.x());
+    const __m128 vOffset = _mm_set1_ps(offset.y());
+
+    for (int i = 0; i < quadCount * 4; i += 4) {
+        const __m128 x = _mm_loadu_ps(xs + i);
+        const __m128 y = _mm_loadu_ps(ys + i);
+        const __m128 u = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(us + i), uScale), uOffset);
+        const __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vs + i), vScale), vOffset);
+
+        const __m128 xy01 = _mm_unpacklo_ps(x, y);
+        const __m128 xy23 = _mm_unpackhi_ps(x, y);
+        const __m128 uv01 = _mm_unpacklo_ps(u, v);
+        const __m128 uv23 = _mm_unpackhi_ps(u, v);
+
+        const __m128 topLeft = _mm_movelh_ps(xy01, uv01);
+        const __m128 topRight = _mm_movehl_ps(uv01, xy01);
+        const __m128 bottomRight = _mm_movelh_ps(xy23, uv23);
+        const __m128 bottomLeft = _mm_movehl_ps(uv23, xy23);
+
+        if (type == GL_QUADS) {
+            storeVertex<aligned>(vertex++, topLeft);
+            storeVertex<aligned>(vertex++, topRight);
+            storeVertex<aligned>(vertex++, bottomRight);
+            storeVertex<aligned>(vertex++, bottomLeft);
+        } else {
+            // First triangle
+            storeVertex<aligned>(vertex++, topRight);
+            storeVertex<aligned>(vertex++, topLeft);
+            storeVertex<aligned>(vertex++, bottomLeft);
+
+            // Second triangle
+            storeVertex<aligned>(vertex++, bottomLeft);
+            storeVertex<aligned>(vertex++, bottomRight);
+            storeVertex<aligned>(vertex++, topRight);
+        }
+    }
+}
+#endif // __SSE2__
+
+void WindowQuadArray::makeInterleavedArrays(unsigned int type, GLVertex2D *vertices, const QMatrix4x4 &textureMatrix) const
+{
+    // Since we know that the texture matrix just scales and translates
+    // we can use this information to optimize the transformation
+    const QVector2D coeff(textureMatrix(0, 0), textureMatrix(1, 1));
+    const QVector2D offset(textureMatrix(0, 3), textureMatrix(1, 3));
+
+    Q_ASSERT(type == GL_QUADS || type == GL_TRIANGLES);
+
+    const float *xs = m_x.constData();
+    const float *ys = m_y.constData();
+    const float *us = m_u.constData();
+    const float *vs = m_v.constData();
+    const int quadCount = count();
+
+#if defined(__SSE2__)
+    if (!(intptr_t(vertices) & 0xf)) {
+        interleaveQuads<true>(type, vertices, xs, ys, us, vs, quadCount, coeff, offset);
+    } else {
+        interleaveQuads<false>(type, vertices, xs, ys, us, vs, quadCount, coeff, offset);
+    }
+#elif defined(__ARM_NEON)
+    GLVertex2D *vertex = vertices;
+    for (int i = 0; i < quadCount * 4; i += 4) {
+        const float32x4_t x = vld1q_f32(xs + i);
+        const float32x4_t y = vld1q_f32(ys + i);
+        const float32x4_t u = vmlaq_n_f32(vdupq_n_f32(offset.x()), vld1q_f32(us + i), coeff.x());
+        const float32x4_t v = vmlaq_n_f32(vdupq_n_f32(offset.y()), vld1q_f32(vs + i), coeff.y());
+
+        const float32x4x2_t xy = vzipq_f32(x, y);
+        const float32x4x2_t uv = vzipq_f32(u, v);
+
+        const float32x4_t topLeft = vcombine_f32(vget_low_f32(xy.val[0]), vget_low_f32(uv.val[0]));
+        const float32x4_t topRight = vcombine_f32(vget_high_f32(xy.val[0]), vget_high_f32(uv.val[0]));
+        const float32x4_t bottomRight = vcombine_f32(vget_low_f32(xy.val[1]), vget_low_f32(uv.val[1]));
+        const float32x4_t bottomLeft = vcombine_f32(vget_high_f32(xy.val[1]), vget_high_f32(uv.val[1]));
+
+        float *dst = reinterpret_cast<float *>(vertex);
+        if (type == GL_QUADS) {
+            vst1q_f32(dst, topLeft);
+            vst1q_f32(dst + 4, topRight);
+            vst1q_f32(dst + 8, bottomRight);
+            vst1q_f32(dst + 12, bottomLeft);
+            vertex += 4;
+        } else {
+            // First triangle
+            vst1q_f32(dst, topRight);
+            vst1q_f32(dst + 4, topLeft);
+            vst1q_f32(dst + 8, bottomLeft);
+
+            // Second triangle
+            vst1q_f32(dst + 12, bottomLeft);
+            vst1q_f32(dst + 16, bottomRight);
+            vst1q_f32(dst + 20, topRight);
+            vertex += 6;
+        }
+    }
+#else
+    // Four unique vertices / quad, stored clockwise starting from the top-left
+    const int quadIndices[] = { 0, 1, 2, 3 };
+    const int triangleIndices[] = { 1, 0, 3, 3, 2, 1 };
+    const int *indices = type == GL_QUADS ? quadIndices : triangleIndices;
+    const int verticesPerQuad = type == GL_QUADS ? 4 : 6;
+
+    GLVertex2D *vertex = vertices;
+    for (int i = 0; i < quadCount * 4; i += 4) {
+        for (int j = 0; j < verticesPerQuad; ++j) {
+            const int k = i + indices[j];
+            vertex->position = QVector2D(xs[k], ys[k]);
+            vertex->texcoord = QVector2D(us[k], vs[k]) * coeff + offset;
+            ++vertex;
+        }
+    }
+#endif
+}
+
 /***************************************************************
  Motion1D
 ***************************************************************/
@@ -175,7 +175,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 233
+#define KWIN_EFFECT_API_VERSION_MINOR 235
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -705,6 +705,19 @@ public:
      */
     virtual bool blocksDirectScanout() const;
 
+    /**
+     * Overwrite this method to return @c true if your effect only touches the windows it has
+     * declared an interest in with EffectsHandler::setWindowInterest(). The prePaintWindow(),
+     * paintWindow(), postPaintWindow() and drawWindow() methods of such an effect are not called
+     * for any other window, the chain continues with the next effect right away.
+     *
+     * Like isActive(), this method is called directly before the paint loop begins.
+     *
+     * The default implementation returns @c false, the effect is called for all windows.
+     * @since 5.25
+     */
+    virtual bool declaresWindowInterest() const;
+
 public Q_SLOTS:
     virtual bool borderActivated(ElectricBorder border);
 
@@ -1137,6 +1150,14 @@ public:
     virtual EffectWindowList stackingOrder() const = 0;
     // window will be temporarily painted as if being at the top of the stack
     Q_SCRIPTABLE virtual void setElevatedWindow(KWin::EffectWindow* w, bool set) = 0;
+    /**
+     * Declares whether @p effect touches the window @p w. Only effects returning @c true from
+     * Effect::declaresWindowInterest() are skipped for the windows they have no interest in.
+     * The interest in a window is dropped when the window is deleted.
+     *
+     * @since 5.25
+     */
+    virtual void setWindowInterest(Effect *effect, EffectWindow *w, bool interested) = 0;
 
     virtual void setTabBoxWindow(EffectWindow*) = 0;
     virtual void setTabBoxDesktop(int) = 0;
@@ -1621,7 +1642,7 @@ Q_SIGNALS:
      * Signal emitted when an area of a window is scheduled for repainting.
      * Use this signal in an effect if another area needs to be synced as well.
      * @param w The window which is scheduled for repainting
-     * @param r Always empty.
+     * @param r The damaged area, relative to the top-left corner of the frame geometry of the window
      * @since 4.7
      */
     void windowDamaged(KWin::EffectWindow *w, const QRegion &r);
@@ -2708,6 +2729,76 @@ public:
     void makeArrays(float** vertices, float** texcoords, const QSizeF &size, bool yInverted) const;
 };
 
+/**
+ * @short Compact storage for a list of window quads.
+ *
+ * Unlike WindowQuadList, which stores the vertices of every quad as doubles next to each
+ * other, the WindowQuadArray keeps the x and y positions and the u and v texture coordinates
+ * of all vertices as floats in four separate contiguous arrays. The four vertices of the
+ * quad at index @c i are stored at indices @c 4*i to @c 4*i+3 in every array, in the same
+ * clockwise order as in WindowQuad.
+ *
+ * This layout allows converting all quads into vertex data with SIMD instructions and
+ * without any conversion from double to float.
+ *
+ * @since 5.25
+ */
+class KWINEFFECTS_EXPORT WindowQuadArray
+{
+public:
+    WindowQuadArray() = default;
+    explicit WindowQuadArray(const WindowQuadList &quads);
+
+    int count() const;
+    bool isEmpty() const;
+    void reserve(int count);
+    void clear();
+
+    void append(const WindowQuad &quad);
+    /**
+     * Appends the quad at @a index in the @a other array.
+     */
+    void append(const WindowQuadArray &other, int index);
+    /**
+     * Appends the part of the quad at @a index in the @a other array that is bounded by the
+     * given rectangle. The texture coordinates are interpolated bilinearly.
+     *
+     * @see WindowQuad::makeSubQuad
+     */
+    void appendSubQuad(const WindowQuadArray &other, int index, float x1, float y1, float x2, float y2);
+    WindowQuadArray &operator<<(const WindowQuad &quad);
+
+    WindowQuad at(int index) const;
+    /**
+     * Returns the bounding rectangle of the quad at @a index.
+     */
+    QRectF boundingRect(int index) const;
+    WindowQuadList toList() const;
+
+    const float *xData() const;
+    const float *yData() const;
+    const float *uData() const;
+    const float *vData() const;
+
+    /**
+     * Applies the scale and the translation in the texture @a matrix to the texture
+     * coordinates of all quads.
+     */
+    void transformTextureCoordinates(const QMatrix4x4 &matrix);
+    /**
+     * Writes the vertices of all quads to @a vertices as either GL_QUADS or GL_TRIANGLES,
+     * with the texture coordinates transformed by the texture @a matrix. The texture matrix
+     * may only scale and translate.
+     */
+    void makeInterleavedArrays(unsigned int type, GLVertex2D *vertices, const QMatrix4x4 &matrix) const;
+
+private:
+    QVector<float> m_x;
+    QVector<float> m_y;
+    QVector<float> m_u;
+    QVector<float> m_v;
+};
+
 class KWINEFFECTS_EXPORT WindowPrePaintData
 {
 public:
@@ -2716,6 +2807,13 @@ public:
      * Region that will be painted, in screen coordinates.
      */
     QRegion paint;
+    /**
+     * Parts of the window that changed since it was last painted, in screen coordinates.
+     * Unlike the paint region it doesn't include areas that are painted again only
+     * because something else on the screen changed.
+     * @since 5.25
+     */
+    QRegion damage;
     /**
      * The clip region will be subtracted from paint region of following windows.
      * I.e. window will definitely cover it's clip region
@@ -0,0 +1,208 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwinglshadercache_p.h"
+#include "kwinconfig.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace KWin
+{
+
+static const quint32 s_magic = 0x4b575042; // "KWPB"
+static const int s_maximumAge = 30; // days after which unused cache directories are removed
+
+GLShaderCache::GLShaderCache()
+{
+    if (qgetenv("KWIN_GL_SHADER_CACHE") == QByteArrayLiteral("0")) {
+        return;
+    }
+
+    GLPlatform *platform = GLPlatform::instance();
+    if (platform->isGLES()) {
+        m_hasCoreSupport = hasGLVersion(3, 0);
+        if (!m_hasCoreSupport && !hasGLExtension(QByteArrayLiteral("GL_OES_get_program_binary"))) {
+            return;
+        }
+    } else {
+        m_hasCoreSupport = hasGLVersion(4, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"));
+        if (!m_hasCoreSupport) {
+            return;
+        }
+    }
+
+    // Some drivers support the extension without supporting any binary format.
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        return;
+    }
+    m_formats.resize(formatCount);
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, m_formats.data());
+
+    const QByteArray driver = platform->glVendorString() + '\n'
+        + platform->glRendererString() + '\n'
+        + platform->glVersionString() + '\n'
+        + KWIN_PLUGIN_VERSION_STRING;
+    const QString driverHash = QString::fromLatin1(QCryptographicHash::hash(driver, QCryptographicHash::Sha1).toHex());
+
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + QLatin1String("/kwin/glsl/") + driverHash;
+    if (!QDir().mkpath(m_directory)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to create the shader cache directory" << m_directory;
+        return;
+    }
+    removeStaleDirectories();
+
+    m_supported = true;
+}
+
+bool GLShaderCache::isSupported() const
+{
+    return m_supported;
+}
+
+QByteArray GLShaderCache::key(const QByteArray &vertexSource, const QByteArray &fragmentSource) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertexSource);
+    hash.addData("\0", 1);
+    hash.addData(fragmentSource);
+    return hash.result().toHex();
+}
+
+QString GLShaderCache::filePath(const QByteArray &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key) + QLatin1String(".bin");
+}
+
+void GLShaderCache::removeStaleDirectories() const
+{
+    // Other GPUs and sessions with a different driver use their own directories next to this
+    // one, so only the directories that haven't been used for a long time are removed. The
+    // marker file is rewritten on every start to keep track of when a directory was used.
+    QFile marker(m_directory + QLatin1String("/lastused"));
+    if (!marker.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return;
+    }
+    marker.close();
+
+    QDir root(m_directory);
+    const QString current = root.dirName();
+    root.cdUp();
+
+    const QDateTime expiry = QDateTime::currentDateTimeUtc().addDays(-s_maximumAge);
+    const QStringList entries = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        if (entry == current) {
+            continue;
+        }
+        QDir directory(root.filePath(entry));
+        const QFileInfo info(directory.filePath(QStringLiteral("lastused")));
+        const QDateTime lastUsed = info.exists() ? info.lastModified() : QFileInfo(directory.path()).lastModified();
+        if (lastUsed.toUTC() < expiry) {
+            directory.removeRecursively();
+        }
+    }
+}
+
+void GLShaderCache::prepare(GLuint program) const
+{
+    if (m_supported && m_hasCoreSupport) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool GLShaderCache::load(GLuint program, const QByteArray &key)
+{
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    quint32 magic = 0;
+    quint32 format = 0;
+    QByteArray binary;
+    quint16 checksum = 0;
+
+    QDataStream stream(&file);
+    stream >> magic >> format >> binary >> checksum;
+
+    // Passing a format that the driver doesn't know would raise a GL error.
+    if (stream.status() != QDataStream::Ok || magic != s_magic || binary.isEmpty()
+        || checksum != qChecksum(binary.constData(), binary.size())
+        || !m_formats.contains(GLint(format))) {
+        qCWarning(LIBKWINGLUTILS) << "Removing invalid shader binary" << file.fileName();
+        file.remove();
+        return false;
+    }
+
+    if (m_hasCoreSupport) {
+        glProgramBinary(program, format, binary.constData(), binary.size());
+    } else {
+        glProgramBinaryOES(program, format, binary.constData(), binary.size());
+    }
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        qCDebug(LIBKWINGLUTILS) << "The driver rejected the shader binary" << file.fileName();
+        file.remove();
+        return false;
+    }
+
+    return true;
+}
+
+void GLShaderCache::store(GLuint program, const QByteArray &key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray binary(length, Qt::Uninitialized);
+    GLsizei written = 0;
+    GLenum format = 0;
+    if (m_hasCoreSupport) {
+        glGetProgramBinary(program, length, &written, &format, binary.data());
+    } else {
+        glGetProgramBinaryOES(program, length, &written, &format, binary.data());
+    }
+    if (written <= 0) {
+        return;
+    }
+    binary.truncate(written);
+
+    // Several compositor processes can share the cache, so the file is replaced atomically.
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to open" << file.fileName() << "for writing";
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << s_magic << quint32(format) << binary << qChecksum(binary.constData(), binary.size());
+    if (!file.commit()) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to write the shader binary" << file.fileName();
+    }
+}
+
+} // namespace KWin
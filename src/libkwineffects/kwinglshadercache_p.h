@@ -0,0 +1,78 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KWIN_GLSHADERCACHE_P_H
+#define KWIN_GLSHADERCACHE_P_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+/**
+ * The GLShaderCache class stores linked shader programs on disk, so they don't have to be
+ * compiled again the next time they are needed.
+ *
+ * The programs are stored with glGetProgramBinary() in the cache directory of the user. The
+ * files of a driver are kept in a directory of their own, named after a hash of the vendor,
+ * renderer and version strings and the version of KWin. Other GPUs or sessions may use a
+ * different driver at the same time, so the directories of other drivers are only removed once
+ * they haven't been used for 30 days, which keeps an update of the driver from leaving stale
+ * binaries behind forever. Every file is named after a hash of the shader sources.
+ *
+ * The driver may still reject a binary, e.g. if it has been updated without changing its version
+ * string. A rejected binary is removed and the program has to be built from the sources.
+ *
+ * The cache can be disabled by setting the environment variable KWIN_GL_SHADER_CACHE to 0.
+ */
+class GLShaderCache
+{
+public:
+    GLShaderCache();
+
+    bool isSupported() const;
+
+    /**
+     * Returns the key of the program built from @a vertexSource and @a fragmentSource.
+     */
+    QByteArray key(const QByteArray &vertexSource, const QByteArray &fragmentSource) const;
+
+    /**
+     * Loads the binary stored for @a key into @a program. Returns @c true if the program has
+     * been linked successfully.
+     */
+    bool load(GLuint program, const QByteArray &key);
+    /**
+     * Stores the binary of the linked @a program for @a key.
+     */
+    void store(GLuint program, const QByteArray &key);
+
+    /**
+     * Asks the driver to keep the binary of the @a program retrievable. This must be called
+     * before the program is linked.
+     */
+    void prepare(GLuint program) const;
+
+private:
+    QString filePath(const QByteArray &key) const;
+    void removeStaleDirectories() const;
+
+    QString m_directory;
+    QVector<GLint> m_formats;
+    bool m_supported = false;
+    bool m_hasCoreSupport = false;
+};
+
+} // namespace KWin
+
+#endif
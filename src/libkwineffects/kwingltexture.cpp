@@ -16,6 +16,7 @@
 #include "kwinglutils.h"
 
 #include "kwingltexture_p.h"
+#include "logging_p.h"
 
 #include <QPixmap>
 #include <QImage>
@@ -23,6 +24,9 @@
 #include <QVector3D>
 #include <QVector4D>
 
+#include <cstring>
+#include <limits>
+
 namespace KWin
 {
 
@@ -36,7 +40,10 @@ bool GLTexturePrivate::s_supportsUnpack = false;
 bool GLTexturePrivate::s_supportsTextureStorage = false;
 bool GLTexturePrivate::s_supportsTextureSwizzle = false;
 bool GLTexturePrivate::s_supportsTextureFormatRG = false;
+bool GLTexturePrivate::s_supportsPixelBuffers = false;
+bool GLTexturePrivate::s_supportsPersistentPixelBuffers = false;
 uint GLTexturePrivate::s_fbo = 0;
+GLPixelUnpackBuffer *GLTexturePrivate::s_unpackBuffer = nullptr;
 
 // Table of GL formats/types associated with different values of QImage::Format.
 // Zero values indicate a direct upload is not feasible.
@@ -291,8 +298,12 @@ GLTexturePrivate::GLTexturePrivate()
 GLTexturePrivate::~GLTexturePrivate()
 {
     delete m_vbo;
-    if (m_texture != 0 && !m_foreign) {
-        glDeleteTextures(1, &m_texture);
+    if (m_texture != 0) {
+        // A foreign texture may be deleted by its owner once it's no longer wrapped.
+        GLState::textureDeleted(m_texture);
+        if (!m_foreign) {
+            glDeleteTextures(1, &m_texture);
+        }
     }
 }
 
@@ -307,6 +318,10 @@ void GLTexturePrivate::initStatic()
         s_supportsTextureFormatRG = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_ARB_texture_rg"));
         s_supportsARGB32 = true;
         s_supportsUnpack = true;
+        s_supportsPixelBuffers = hasGLVersion(3, 0) ||
+            (hasGLExtension(QByteArrayLiteral("GL_ARB_pixel_buffer_object")) && hasGLExtension(QByteArrayLiteral("GL_ARB_map_buffer_range")));
+        s_supportsPersistentPixelBuffers = (hasGLVersion(4, 4) || hasGLExtension(QByteArrayLiteral("GL_ARB_buffer_storage"))) &&
+            (hasGLVersion(3, 2) || hasGLExtension(QByteArrayLiteral("GL_ARB_sync")));
     } else {
         s_supportsFramebufferObjects = true;
         s_supportsTextureStorage = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_EXT_texture_storage"));
@@ -319,7 +334,15 @@ void GLTexturePrivate::initStatic()
         s_supportsARGB32 = QSysInfo::ByteOrder == QSysInfo::LittleEndian &&
             hasGLExtension(QByteArrayLiteral("GL_EXT_texture_format_BGRA8888"));
 
-        s_supportsUnpack = hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+        // GL_UNPACK_ROW_LENGTH and friends are part of OpenGL ES 3.0
+        s_supportsUnpack = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+        s_supportsPixelBuffers = hasGLVersion(3, 0);
+        s_supportsPersistentPixelBuffers = s_supportsPixelBuffers && hasGLExtension(QByteArrayLiteral("GL_EXT_buffer_storage"));
+    }
+
+    if (qgetenv("KWIN_GL_PIXEL_BUFFERS") == QByteArrayLiteral("0")) {
+        s_supportsPixelBuffers = false;
+        s_supportsPersistentPixelBuffers = false;
     }
 }
 
@@ -327,10 +350,15 @@ void GLTexturePrivate::cleanup()
 {
     s_supportsFramebufferObjects = false;
     s_supportsARGB32 = false;
+    s_supportsPixelBuffers = false;
+    s_supportsPersistentPixelBuffers = false;
     if (s_fbo) {
+        GLState::framebufferDeleted(s_fbo);
         glDeleteFramebuffers(1, &s_fbo);
         s_fbo = 0;
     }
+    delete s_unpackBuffer;
+    s_unpackBuffer = nullptr;
 }
 
 bool GLTexture::isNull() const
@@ -355,41 +383,45 @@ void GLTexture::setSize(const QSize &size)
     d->updateMatrix();
 }
 
-void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &src)
+static QImage::Format uploadFormat(const QImage &image, GLenum *glFormat, GLenum *type)
 {
-    if (image.isNull() || isNull())
-        return;
-
-    Q_D(GLTexture);
-    Q_ASSERT(!d->m_foreign);
-
-    GLenum glFormat;
-    GLenum type;
-    QImage::Format uploadFormat;
     if (!GLPlatform::instance()->isGLES()) {
         const QImage::Format index = image.format();
 
         if (index < sizeof(formatTable) / sizeof(formatTable[0]) && formatTable[index].internalFormat) {
-            glFormat = formatTable[index].format;
-            type = formatTable[index].type;
-            uploadFormat = index;
+            *glFormat = formatTable[index].format;
+            *type = formatTable[index].type;
+            return index;
         } else {
-            glFormat = GL_BGRA;
-            type = GL_UNSIGNED_INT_8_8_8_8_REV;
-            uploadFormat = QImage::Format_ARGB32_Premultiplied;
+            *glFormat = GL_BGRA;
+            *type = GL_UNSIGNED_INT_8_8_8_8_REV;
+            return QImage::Format_ARGB32_Premultiplied;
         }
     } else {
-        if (d->s_supportsARGB32) {
-            glFormat = GL_BGRA_EXT;
-            type = GL_UNSIGNED_BYTE;
-            uploadFormat = QImage::Format_ARGB32_Premultiplied;
+        if (GLTexturePrivate::s_supportsARGB32) {
+            *glFormat = GL_BGRA_EXT;
+            *type = GL_UNSIGNED_BYTE;
+            return QImage::Format_ARGB32_Premultiplied;
         } else {
-            glFormat = GL_RGBA;
-            type = GL_UNSIGNED_BYTE;
-            uploadFormat = QImage::Format_RGBA8888_Premultiplied;
+            *glFormat = GL_RGBA;
+            *type = GL_UNSIGNED_BYTE;
+            return QImage::Format_RGBA8888_Premultiplied;
         }
     }
-    bool useUnpack = d->s_supportsUnpack && image.format() == uploadFormat && !src.isNull();
+}
+
+void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &src)
+{
+    if (image.isNull() || isNull())
+        return;
+
+    Q_D(GLTexture);
+    Q_ASSERT(!d->m_foreign);
+
+    GLenum glFormat;
+    GLenum type;
+    const QImage::Format format = uploadFormat(image, &glFormat, &type);
+    bool useUnpack = d->s_supportsUnpack && image.format() == format && !src.isNull();
 
     QImage im;
     if (useUnpack) {
@@ -404,8 +436,8 @@ void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &s
         } else {
             im = image.copy(src);
         }
-        if (im.format() != uploadFormat) {
-            im.convertTo(uploadFormat);
+        if (im.format() != format) {
+            im.convertTo(format);
         }
     }
 
@@ -419,6 +451,7 @@ void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &s
     bind();
 
     glTexSubImage2D(d->m_target, 0, offset.x(), offset.y(), width, height, glFormat, type, im.constBits());
+    GLStatistics::add(GLStatistics::TextureUploads);
 
     unbind();
 
@@ -429,6 +462,138 @@ void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &s
     }
 }
 
+static qint64 area(const QRect &rect)
+{
+    return qint64(rect.width()) * rect.height();
+}
+
+/**
+ * Merges the rectangles of @a region into at most @a maxCount boxes. The pair of boxes that
+ * wastes the fewest pixels is merged first; pairs that waste nothing are always merged.
+ */
+static QVector<QRect> coalesceRegion(const QRegion &region, int maxCount)
+{
+    // The search is quadratic, a region with that many rectangles is uploaded in one go.
+    if (region.rectCount() > 32) {
+        return {region.boundingRect()};
+    }
+
+    QVector<QRect> boxes(region.begin(), region.end());
+    while (boxes.count() > 1) {
+        int first = 0;
+        int second = 1;
+        qint64 smallestWaste = std::numeric_limits<qint64>::max();
+        for (int i = 0; i < boxes.count(); ++i) {
+            for (int j = i + 1; j < boxes.count(); ++j) {
+                const qint64 waste = area(boxes[i] | boxes[j]) - area(boxes[i]) - area(boxes[j]);
+                if (waste < smallestWaste) {
+                    smallestWaste = waste;
+                    first = i;
+                    second = j;
+                }
+            }
+        }
+        if (boxes.count() <= maxCount && smallestWaste > 0) {
+            break;
+        }
+        boxes[first] |= boxes[second];
+        boxes.remove(second);
+    }
+    return boxes;
+}
+
+void GLTexture::update(const QImage &image, const QRegion &region)
+{
+    if (image.isNull() || isNull())
+        return;
+
+    Q_D(GLTexture);
+    Q_ASSERT(!d->m_foreign);
+
+    const QVector<QRect> boxes = coalesceRegion(region & image.rect() & QRect(QPoint(0, 0), d->m_size), 4);
+    if (boxes.isEmpty()) {
+        return;
+    }
+
+    GLenum glFormat;
+    GLenum type;
+    const QImage::Format format = uploadFormat(image, &glFormat, &type);
+    // The conversion needs a copy of the image anyway.
+    if (image.format() != format) {
+        for (const QRect &box : boxes) {
+            update(image, box.topLeft(), box);
+        }
+        return;
+    }
+
+    const int bytesPerPixel = image.depth() / 8;
+    QVector<QRect> pending = boxes;
+
+    // Rows are packed tightly in the pixel buffer, so they have to satisfy the default
+    // GL_UNPACK_ALIGNMENT of 4 bytes.
+    if (d->s_supportsPixelBuffers && bytesPerPixel == 4) {
+        if (!d->s_unpackBuffer) {
+            d->s_unpackBuffer = new GLPixelUnpackBuffer(d->s_supportsPersistentPixelBuffers);
+        }
+
+        bind();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, d->s_unpackBuffer->buffer());
+        pending.clear();
+        for (const QRect &box : boxes) {
+            const size_t rowSize = box.width() * bytesPerPixel;
+            intptr_t offset = 0;
+            uint8_t *data = d->s_unpackBuffer->map(rowSize * box.height(), &offset);
+            if (!data) {
+                pending.append(box);
+                continue;
+            }
+            for (int y = 0; y < box.height(); ++y) {
+                memcpy(data + y * rowSize, image.constScanLine(box.y() + y) + box.x() * bytesPerPixel, rowSize);
+            }
+            d->s_unpackBuffer->unmap();
+
+            glTexSubImage2D(d->m_target, 0, box.x(), box.y(), box.width(), box.height(),
+                            glFormat, type, reinterpret_cast<const void *>(offset));
+            GLStatistics::add(GLStatistics::TextureUploads);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        unbind();
+    }
+
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    if (d->s_supportsUnpack) {
+        for (const QRect &box : qAsConst(pending)) {
+            update(image, box.topLeft(), box);
+        }
+        return;
+    }
+
+    // Without GL_UNPACK_ROW_LENGTH, the pixels are uploaded straight from the image, rather
+    // than copying the boxes. If the image is as wide as the texture and its scanlines are
+    // padded to the default GL_UNPACK_ALIGNMENT of 4 bytes, as QImage does on its own, every
+    // box is uploaded as a stripe of full rows. Otherwise the boxes are uploaded row by row.
+    const bool fullRows = image.width() == d->m_size.width()
+        && image.bytesPerLine() == ((image.width() * bytesPerPixel + 3) & ~3);
+    bind();
+    for (const QRect &box : qAsConst(pending)) {
+        if (fullRows) {
+            glTexSubImage2D(d->m_target, 0, 0, box.y(), image.width(), box.height(),
+                            glFormat, type, image.constScanLine(box.y()));
+            GLStatistics::add(GLStatistics::TextureUploads);
+        } else {
+            for (int y = box.top(); y <= box.bottom(); ++y) {
+                glTexSubImage2D(d->m_target, 0, box.x(), y, box.width(), 1,
+                                glFormat, type, image.constScanLine(y) + box.x() * bytesPerPixel);
+                GLStatistics::add(GLStatistics::TextureUploads);
+            }
+        }
+    }
+    unbind();
+}
+
 void GLTexture::discard()
 {
     d_ptr = new GLTexturePrivate();
@@ -439,7 +604,7 @@ void GLTexture::bind()
     Q_D(GLTexture);
     Q_ASSERT(d->m_texture);
 
-    glBindTexture(d->m_target, d->m_texture);
+    GLState::bindTexture(d->m_target, d->m_texture);
 
     if (d->m_markedDirty) {
         d->onDamage();
@@ -493,7 +658,7 @@ void GLTexture::generateMipmaps()
 void GLTexture::unbind()
 {
     Q_D(GLTexture);
-    glBindTexture(d->m_target, 0);
+    GLState::bindTexture(d->m_target, 0);
 }
 
 void GLTexture::render(const QRegion &region, const QRect& rect, bool hardwareClipping)
@@ -566,15 +731,14 @@ void GLTexture::clear()
 
     if (GLTexturePrivate::s_fbo) {
         // Clear the texture
-        GLuint previousFramebuffer = 0;
-        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, reinterpret_cast<GLint *>(&previousFramebuffer));
+        const GLuint previousFramebuffer = GLState::drawFramebuffer();
         if (GLTexturePrivate::s_fbo != previousFramebuffer)
-            glBindFramebuffer(GL_FRAMEBUFFER, GLTexturePrivate::s_fbo);
+            GLState::bindFramebuffer(GL_FRAMEBUFFER, GLTexturePrivate::s_fbo);
         glClearColor(0, 0, 0, 0);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, d->m_texture, 0);
         glClear(GL_COLOR_BUFFER_BIT);
         if (GLTexturePrivate::s_fbo != previousFramebuffer)
-            glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+            GLState::bindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
     } else {
         if (const int size = width()*height()) {
             uint32_t *buffer = new uint32_t[size];
@@ -719,4 +883,102 @@ QImage GLTexture::toImage() const
     return ret;
 }
 
+//****************************************
+// GLPixelUnpackBuffer
+//****************************************
+
+static const size_t s_pixelBufferSegmentSize = 8 * 1024 * 1024;
+
+GLPixelUnpackBuffer::GLPixelUnpackBuffer(bool persistent)
+    : m_persistent(persistent)
+{
+    glGenBuffers(1, &m_buffer);
+    if (m_persistent) {
+        const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const size_t size = s_pixelBufferSegmentSize * s_segmentCount;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, access);
+        m_map = static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, access));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (!m_map) {
+            qCWarning(LIBKWINGLUTILS) << "Failed to map the pixel buffer persistently";
+            m_persistent = false;
+            glDeleteBuffers(1, &m_buffer);
+            glGenBuffers(1, &m_buffer);
+        }
+    }
+}
+
+GLPixelUnpackBuffer::~GLPixelUnpackBuffer()
+{
+    for (GLsync fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (m_map) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &m_buffer);
+}
+
+GLuint GLPixelUnpackBuffer::buffer() const
+{
+    return m_buffer;
+}
+
+size_t GLPixelUnpackBuffer::maximumSize()
+{
+    return s_pixelBufferSegmentSize;
+}
+
+uint8_t *GLPixelUnpackBuffer::map(size_t size, intptr_t *offset)
+{
+    if (size == 0 || size > maximumSize()) {
+        return nullptr;
+    }
+
+    if (!m_persistent) {
+        // Orphaning the storage lets the driver hand out new memory while the GPU still
+        // fetches the previous upload.
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        *offset = 0;
+        return static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    }
+
+    if (m_segmentOffset + size > s_pixelBufferSegmentSize) {
+        m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_segment = (m_segment + 1) % s_segmentCount;
+        m_segmentOffset = 0;
+
+        // The GPU may still fetch pixels from the segment the ring has wrapped around to.
+        if (GLsync fence = m_fences[m_segment]) {
+            const GLenum ret = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            glDeleteSync(fence);
+            m_fences[m_segment] = nullptr;
+            if (ret == GL_TIMEOUT_EXPIRED || ret == GL_WAIT_FAILED) {
+                qCCritical(LIBKWINGLUTILS) << "Waiting for the pixel buffer fence failed";
+                return nullptr;
+            }
+        }
+    }
+
+    *offset = m_segment * s_pixelBufferSegmentSize + m_segmentOffset;
+    // Keep the uploads aligned, some drivers take a slow path otherwise.
+    m_segmentOffset += (size + 255) & ~size_t(255);
+    return m_map + *offset;
+}
+
+void GLPixelUnpackBuffer::unmap()
+{
+    if (!m_persistent) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+}
+
 } // namespace KWin
@@ -100,6 +100,16 @@ public:
     QMatrix4x4 matrix(TextureCoordinateType type) const;
 
     void update(const QImage& image, const QPoint &offset = QPoint(0, 0), const QRect &src = QRect());
+    /**
+     * Uploads the pixels of @a image within @a region to the same position in the texture.
+     *
+     * The rectangles of the region are merged into a few boxes, which are streamed through
+     * a pixel buffer object if the driver supports it, so the upload doesn't wait for the GPU.
+     * Otherwise the pixels are uploaded straight from the image without copying it.
+     *
+     * @since 5.25
+     */
+    void update(const QImage &image, const QRegion &region);
     virtual void discard();
     void bind();
     void unbind();
@@ -27,6 +27,47 @@ namespace KWin
 // forward declarations
 class GLVertexBuffer;
 
+/**
+ * The GLPixelUnpackBuffer class streams pixel data to textures through a pixel buffer object,
+ * so glTexSubImage2D() returns without waiting for the GPU to fetch the data.
+ *
+ * If the driver supports persistently mapped buffers, the buffer is split into a ring of
+ * segments, each guarded by a fence that is inserted when the ring moves on to the next
+ * segment. Otherwise the storage of the buffer is orphaned for every upload.
+ *
+ * The buffer must be bound to GL_PIXEL_UNPACK_BUFFER while it's being mapped.
+ */
+class GLPixelUnpackBuffer
+{
+public:
+    explicit GLPixelUnpackBuffer(bool persistent);
+    ~GLPixelUnpackBuffer();
+
+    GLuint buffer() const;
+    /**
+     * Returns the size of the largest upload that fits into the buffer.
+     */
+    static size_t maximumSize();
+
+    /**
+     * Returns a pointer to @a size bytes of the buffer that can be written until unmap() is
+     * called, or @c nullptr if the upload doesn't fit. @a offset receives the offset of the
+     * bytes in the buffer.
+     */
+    uint8_t *map(size_t size, intptr_t *offset);
+    void unmap();
+
+private:
+    static const int s_segmentCount = 4;
+
+    GLuint m_buffer = 0;
+    uint8_t *m_map = nullptr;
+    bool m_persistent;
+    int m_segment = 0;
+    size_t m_segmentOffset = 0;
+    GLsync m_fences[s_segmentCount] = {};
+};
+
 class KWINGLUTILS_EXPORT GLTexturePrivate
     : public QSharedData
 {
@@ -68,7 +109,10 @@ public:
     static bool s_supportsTextureStorage;
     static bool s_supportsTextureSwizzle;
     static bool s_supportsTextureFormatRG;
+    static bool s_supportsPixelBuffers;
+    static bool s_supportsPersistentPixelBuffers;
     static GLuint s_fbo;
+    static GLPixelUnpackBuffer *s_unpackBuffer;
 private:
     friend void KWin::cleanupGL();
     static void cleanup();
@@ -0,0 +1,163 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwingluniforms_p.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+
+#include <cstring>
+
+namespace KWin
+{
+
+int GLUniformCache::location(GLuint program, const char *name)
+{
+    // The name is only copied if it has to be inserted.
+    const QByteArray key = QByteArray::fromRawData(name, qstrlen(name));
+    auto it = m_locations.constFind(key);
+    if (it != m_locations.constEnd()) {
+        return *it;
+    }
+
+    const int location = glGetUniformLocation(program, name);
+    GLStatistics::add(GLStatistics::UniformLocationQueries);
+    m_locations.insert(QByteArray(name), location);
+    return location;
+}
+
+bool GLUniformCache::update(int location, const void *data, int size)
+{
+    Q_ASSERT(size <= int(sizeof(Value::data)));
+
+    Value &value = m_values[location];
+    if (value.size == size && std::memcmp(value.data, data, size) == 0) {
+        GLStatistics::add(GLStatistics::ElidedUniformUpdates);
+        return false;
+    }
+    std::memcpy(value.data, data, size);
+    value.size = size;
+    GLStatistics::add(GLStatistics::UniformUpdates);
+    return true;
+}
+
+void GLUniformCache::clear()
+{
+    m_locations.clear();
+    m_values.clear();
+}
+
+GLDrawDataBuffer *GLDrawDataBuffer::s_instance = nullptr;
+
+bool GLDrawDataBuffer::isSupported()
+{
+    static const bool disabled = qgetenv("KWIN_GL_UNIFORM_BUFFERS") == QByteArrayLiteral("0");
+    if (disabled) {
+        return false;
+    }
+
+    // The generated shaders only declare the block if they are written in a GLSL version
+    // that knows uniform blocks.
+    GLPlatform *platform = GLPlatform::instance();
+    if (platform->isGLES()) {
+        return hasGLVersion(3, 0) && platform->glslVersion() >= kVersionNumber(3, 0);
+    }
+    return (hasGLVersion(3, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_uniform_buffer_object")))
+        && (hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_ARB_map_buffer_range")))
+        && platform->glslVersion() >= kVersionNumber(1, 40);
+}
+
+GLDrawDataBuffer *GLDrawDataBuffer::instance()
+{
+    if (!s_instance) {
+        s_instance = new GLDrawDataBuffer();
+    }
+    return s_instance;
+}
+
+void GLDrawDataBuffer::cleanup()
+{
+    delete s_instance;
+    s_instance = nullptr;
+}
+
+void GLDrawDataBuffer::invalidate()
+{
+    if (s_instance) {
+        s_instance->m_bound = false;
+        s_instance->m_boundOffset = -1;
+    }
+}
+
+GLDrawDataBuffer::GLDrawDataBuffer()
+    : m_size(64 * 1024)
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = qMax(alignment, 16);
+    m_stride = (int(sizeof(GLDrawData)) + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, m_size, nullptr, GL_STREAM_DRAW);
+    m_bound = true;
+}
+
+GLDrawDataBuffer::~GLDrawDataBuffer()
+{
+    glDeleteBuffers(1, &m_buffer);
+}
+
+int GLDrawDataBuffer::upload(const GLDrawData &data)
+{
+    if (!m_bound) {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        m_bound = true;
+    }
+
+    // The ranges are written without synchronization, the draws that still read from the
+    // buffer only use ranges that are never written again before it is orphaned.
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (m_offset + m_stride > m_size) {
+        // Orphan the buffer, the draws that still read from it keep the old storage.
+        access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+        m_offset = 0;
+        m_boundOffset = -1;
+        ++m_generation;
+    }
+
+    const int offset = m_offset;
+    void *map = glMapBufferRange(GL_UNIFORM_BUFFER, offset, sizeof(GLDrawData), access);
+    if (map) {
+        std::memcpy(map, &data, sizeof(GLDrawData));
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    } else {
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(GLDrawData), &data);
+    }
+    GLStatistics::add(GLStatistics::UniformUpdates);
+    m_offset += m_stride;
+    return offset;
+}
+
+void GLDrawDataBuffer::bind(int offset)
+{
+    if (m_boundOffset == offset) {
+        return;
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, 0, m_buffer, offset, sizeof(GLDrawData));
+    GLStatistics::add(GLStatistics::UniformUpdates);
+    m_boundOffset = offset;
+    m_bound = true;
+}
+
+quint64 GLDrawDataBuffer::generation() const
+{
+    return m_generation;
+}
+
+} // namespace KWin
@@ -0,0 +1,120 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KWIN_GLUNIFORMS_P_H
+#define KWIN_GLUNIFORMS_P_H
+
+#include <QByteArray>
+#include <QHash>
+
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+/**
+ * The GLUniformCache class remembers the uniform locations and values of a shader program.
+ *
+ * glGetUniformLocation() is only called the first time a name is looked up. The values are
+ * kept per location, so setting a uniform to the value it already has doesn't reach the driver.
+ * Both are only valid until the program is linked again.
+ */
+class GLUniformCache
+{
+public:
+    int location(GLuint program, const char *name);
+
+    /**
+     * Stores the @a size bytes at @a data as the value of the uniform at @a location. Returns
+     * @c false if the uniform already has this value.
+     */
+    bool update(int location, const void *data, int size);
+
+    void clear();
+
+private:
+    struct Value
+    {
+        GLfloat data[16];
+        int size = 0;
+    };
+
+    QHash<QByteArray, int> m_locations;
+    QHash<int, Value> m_values;
+};
+
+/**
+ * The per-draw uniforms of the generated shaders, laid out like the KWinDrawData uniform
+ * block with the std140 rules.
+ */
+struct GLDrawData
+{
+    GLfloat modelViewProjectionMatrix[16];
+    GLfloat modulation[4];
+    GLfloat saturation;
+    GLfloat padding[3];
+};
+
+/**
+ * The GLDrawDataBuffer class streams the per-draw uniforms of the generated shaders into a
+ * uniform buffer object.
+ *
+ * Every upload goes to a new range of the buffer, which is mapped without synchronization
+ * like the ranges of the streaming vertex buffer, so the driver never has to wait for a draw
+ * that still reads an older range. The buffer is orphaned when it is full; the generation()
+ * changes then, telling the shaders that their uploaded data is gone.
+ *
+ * The buffer is bound to the uniform block binding point 0.
+ */
+class GLDrawDataBuffer
+{
+public:
+    /**
+     * Returns whether the generated shaders can use the KWinDrawData uniform block. The
+     * uniform blocks can be disabled by setting the environment variable
+     * KWIN_GL_UNIFORM_BUFFERS to 0.
+     */
+    static bool isSupported();
+
+    static GLDrawDataBuffer *instance();
+    static void cleanup();
+    /**
+     * Forgets the bound buffer range, e.g. because another context has been made current.
+     */
+    static void invalidate();
+
+    /**
+     * Uploads @a data and returns the offset it has been written to.
+     */
+    int upload(const GLDrawData &data);
+    /**
+     * Binds the range at @a offset to the binding point.
+     */
+    void bind(int offset);
+
+    quint64 generation() const;
+
+private:
+    GLDrawDataBuffer();
+    ~GLDrawDataBuffer();
+
+    GLuint m_buffer = 0;
+    int m_size;
+    int m_stride;
+    int m_offset = 0;
+    int m_boundOffset = -1;
+    bool m_bound = false;
+    quint64 m_generation = 1;
+
+    static GLDrawDataBuffer *s_instance;
+};
+
+} // namespace KWin
+
+#endif
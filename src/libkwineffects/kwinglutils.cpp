@@ -15,6 +15,8 @@
 
 #include "kwineffects.h"
 #include "kwinglplatform.h"
+#include "kwinglshadercache_p.h"
+#include "kwingluniforms_p.h"
 #include "logging_p.h"
 
 #include <QPixmap>
@@ -27,9 +29,13 @@
 #include <QMatrix4x4>
 #include <QVarLengthArray>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <deque>
+#include <iterator>
+#include <optional>
 
 #define DEBUG_GLRENDERTARGET 0
 
@@ -149,6 +155,8 @@ void initGL(const std::function<resolveFuncPtr(const char*)> &resolveFunction)
 
     initDebugOutput();
 
+    GLState::invalidate();
+
     GLTexturePrivate::initStatic();
     GLRenderTarget::initStatic();
     GLVertexBuffer::initStatic();
@@ -156,11 +164,15 @@ void initGL(const std::function<resolveFuncPtr(const char*)> &resolveFunction)
 
 void cleanupGL()
 {
+    GLBackdrop::cleanup();
+    GLRenderTargetPool::cleanup();
     ShaderManager::cleanup();
+    GLDrawDataBuffer::cleanup();
     GLTexturePrivate::cleanup();
     GLRenderTarget::cleanup();
     GLVertexBuffer::cleanup();
     GLPlatform::cleanup();
+    GLState::invalidate();
 
     glExtensions.clear();
 }
@@ -218,10 +230,21 @@ bool checkGLError(const char* txt)
 // GLShader
 //****************************************
 
+struct GLShader::DrawDataBlock
+{
+    GLDrawData values = {};
+    int offset = 0;
+    // The data has to be uploaded if it doesn't match the generation of the buffer
+    quint64 generation = 0;
+};
+
+GLShader *GLShader::s_boundShader = nullptr;
+
 GLShader::GLShader(unsigned int flags)
     : mValid(false)
     , mLocationsResolved(false)
     , mExplicitLinking(flags & ExplicitLinking)
+    , mUniformCache(new GLUniformCache)
 {
     mProgram = glCreateProgram();
 }
@@ -230,6 +253,7 @@ GLShader::GLShader(const QString& vertexfile, const QString& fragmentfile, unsig
     : mValid(false)
     , mLocationsResolved(false)
     , mExplicitLinking(flags & ExplicitLinking)
+    , mUniformCache(new GLUniformCache)
 {
     mProgram = glCreateProgram();
     loadFromFiles(vertexfile, fragmentfile);
@@ -237,6 +261,9 @@ GLShader::GLShader(const QString& vertexfile, const QString& fragmentfile, unsig
 
 GLShader::~GLShader()
 {
+    if (s_boundShader == this) {
+        s_boundShader = nullptr;
+    }
     if (mProgram) {
         glDeleteProgram(mProgram);
     }
@@ -266,6 +293,10 @@ bool GLShader::link()
     // Be optimistic
     mValid = true;
 
+    // Linking resets the locations and values of all uniforms
+    mUniformCache->clear();
+    mLocationsResolved = false;
+
     glLinkProgram(mProgram);
 
     // Get the program info log
@@ -388,12 +419,65 @@ void GLShader::bindFragDataLocation(const char *name, int index)
 
 void GLShader::bind()
 {
-    glUseProgram(mProgram);
+    GLState::useProgram(mProgram);
+    s_boundShader = this;
 }
 
 void GLShader::unbind()
 {
-    glUseProgram(0);
+    GLState::useProgram(0);
+    s_boundShader = nullptr;
+}
+
+void GLShader::resolveDrawDataBlock()
+{
+    if (!mValid || !GLDrawDataBuffer::isSupported()) {
+        return;
+    }
+
+    const GLuint index = glGetUniformBlockIndex(mProgram, "KWinDrawData");
+    if (index == GL_INVALID_INDEX) {
+        return;
+    }
+    glUniformBlockBinding(mProgram, index, 0);
+    mDrawData.reset(new DrawDataBlock);
+}
+
+bool GLShader::updateUniform(int location, const void *data, int size)
+{
+    // glUniform*() changes the bound program, the cached values are only known for it
+    if (s_boundShader != this) {
+        GLStatistics::add(GLStatistics::UniformUpdates);
+        return true;
+    }
+    return mUniformCache->update(location, data, size);
+}
+
+bool GLShader::setDrawData(int offset, const float *values, int count)
+{
+    float *data = reinterpret_cast<float *>(reinterpret_cast<char *>(&mDrawData->values) + offset);
+    if (std::equal(values, values + count, data)) {
+        GLStatistics::add(GLStatistics::ElidedUniformUpdates);
+        return true;
+    }
+    std::copy(values, values + count, data);
+    mDrawData->generation = 0;
+    return true;
+}
+
+void GLShader::flushDrawData()
+{
+    if (!s_boundShader || !s_boundShader->mDrawData) {
+        return;
+    }
+
+    DrawDataBlock *block = s_boundShader->mDrawData.data();
+    GLDrawDataBuffer *buffer = GLDrawDataBuffer::instance();
+    if (block->generation != buffer->generation()) {
+        block->offset = buffer->upload(block->values);
+        block->generation = buffer->generation();
+    }
+    buffer->bind(block->offset);
 }
 
 void GLShader::resolveLocations()
@@ -421,12 +505,14 @@ void GLShader::resolveLocations()
 
 int GLShader::uniformLocation(const char *name)
 {
-    const int location = glGetUniformLocation(mProgram, name);
-    return location;
+    return mUniformCache->location(mProgram, name);
 }
 
 bool GLShader::setUniform(GLShader::MatrixUniform uniform, const QMatrix4x4 &matrix)
 {
+    if (mDrawData && uniform == ModelViewProjectionMatrix) {
+        return setDrawData(offsetof(GLDrawData, modelViewProjectionMatrix), matrix.constData(), 16);
+    }
     resolveLocations();
     return setUniform(mMatrixLocation[uniform], matrix);
 }
@@ -439,12 +525,19 @@ bool GLShader::setUniform(GLShader::Vec2Uniform uniform, const QVector2D &value)
 
 bool GLShader::setUniform(GLShader::Vec4Uniform uniform, const QVector4D &value)
 {
+    if (mDrawData && uniform == ModulationConstant) {
+        const float values[] = { value.x(), value.y(), value.z(), value.w() };
+        return setDrawData(offsetof(GLDrawData, modulation), values, 4);
+    }
     resolveLocations();
     return setUniform(mVec4Location[uniform], value);
 }
 
 bool GLShader::setUniform(GLShader::FloatUniform uniform, float value)
 {
+    if (mDrawData && uniform == Saturation) {
+        return setDrawData(offsetof(GLDrawData, saturation), &value, 1);
+    }
     resolveLocations();
     return setUniform(mFloatLocation[uniform], value);
 }
@@ -511,7 +604,7 @@ bool GLShader::setUniform(const char *name, const QColor& color)
 
 bool GLShader::setUniform(int location, float value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniform(location, &value, sizeof(value))) {
         glUniform1f(location, value);
     }
     return (location >= 0);
@@ -519,7 +612,7 @@ bool GLShader::setUniform(int location, float value)
 
 bool GLShader::setUniform(int location, int value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniform(location, &value, sizeof(value))) {
         glUniform1i(location, value);
     }
     return (location >= 0);
@@ -527,7 +620,7 @@ bool GLShader::setUniform(int location, int value)
 
 bool GLShader::setUniform(int location, const QVector2D &value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniform(location, &value, sizeof(value))) {
         glUniform2fv(location, 1, (const GLfloat*)&value);
     }
     return (location >= 0);
@@ -535,7 +628,7 @@ bool GLShader::setUniform(int location, const QVector2D &value)
 
 bool GLShader::setUniform(int location, const QVector3D &value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniform(location, &value, sizeof(value))) {
         glUniform3fv(location, 1, (const GLfloat*)&value);
     }
     return (location >= 0);
@@ -543,7 +636,7 @@ bool GLShader::setUniform(int location, const QVector3D &value)
 
 bool GLShader::setUniform(int location, const QVector4D &value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniform(location, &value, sizeof(value))) {
         glUniform4fv(location, 1, (const GLfloat*)&value);
     }
     return (location >= 0);
@@ -551,7 +644,7 @@ bool GLShader::setUniform(int location, const QVector4D &value)
 
 bool GLShader::setUniform(int location, const QMatrix4x4 &value)
 {
-    if (location >= 0) {
+    if (location >= 0 && updateUniform(location, value.constData(), 16 * sizeof(GLfloat))) {
         glUniformMatrix4fv(location, 1, GL_FALSE, value.constData());
     }
     return (location >= 0);
@@ -560,7 +653,10 @@ bool GLShader::setUniform(int location, const QMatrix4x4 &value)
 bool GLShader::setUniform(int location, const QColor &color)
 {
     if (location >= 0) {
-        glUniform4f(location, color.redF(), color.greenF(), color.blueF(), color.alphaF());
+        const GLfloat values[] = { GLfloat(color.redF()), GLfloat(color.greenF()), GLfloat(color.blueF()), GLfloat(color.alphaF()) };
+        if (updateUniform(location, values, sizeof(values))) {
+            glUniform4fv(location, 1, values);
+        }
     }
     return (location >= 0);
 }
@@ -617,6 +713,8 @@ void ShaderManager::cleanup()
 }
 
 ShaderManager::ShaderManager()
+    : m_shaderCache(new GLShaderCache)
+    , m_drawDataBlock(GLDrawDataBuffer::isSupported())
 {
 }
 
@@ -630,7 +728,16 @@ ShaderManager::~ShaderManager()
     m_shaderHash.clear();
 }
 
-QByteArray ShaderManager::generateVertexSource(ShaderTraits traits) const
+static void writeDrawDataBlock(QTextStream &stream)
+{
+    stream << "layout(std140) uniform KWinDrawData {\n";
+    stream << "    mat4 modelViewProjectionMatrix;\n";
+    stream << "    vec4 modulation;\n";
+    stream << "    float saturation;\n";
+    stream << "};\n\n";
+}
+
+QByteArray ShaderManager::generateVertexSource(ShaderTraits traits, bool drawDataBlock) const
 {
     QByteArray source;
     QTextStream stream(&source);
@@ -663,7 +770,11 @@ QByteArray ShaderManager::generateVertexSource(ShaderTraits traits) const
     } else
         stream << "\n";
 
-    stream << "uniform mat4 modelViewProjectionMatrix;\n\n";
+    if (drawDataBlock) {
+        writeDrawDataBlock(stream);
+    } else {
+        stream << "uniform mat4 modelViewProjectionMatrix;\n\n";
+    }
 
     stream << "void main()\n{\n";
     if (traits & ShaderTrait::MapTexture)
@@ -676,7 +787,7 @@ QByteArray ShaderManager::generateVertexSource(ShaderTraits traits) const
     return source;
 }
 
-QByteArray ShaderManager::generateFragmentSource(ShaderTraits traits) const
+QByteArray ShaderManager::generateFragmentSource(ShaderTraits traits, bool drawDataBlock) const
 {
     QByteArray source;
     QTextStream stream(&source);
@@ -712,10 +823,18 @@ QByteArray ShaderManager::generateFragmentSource(ShaderTraits traits) const
     if (traits & ShaderTrait::MapTexture) {
         stream << "uniform sampler2D sampler;\n";
 
-        if (traits & ShaderTrait::Modulate)
-            stream << "uniform vec4 modulation;\n";
-        if (traits & ShaderTrait::AdjustSaturation)
-            stream << "uniform float saturation;\n";
+        if (drawDataBlock) {
+            // The block has to be declared like in the vertex shader
+            if (traits & (ShaderTrait::Modulate | ShaderTrait::AdjustSaturation)) {
+                stream << "\n";
+                writeDrawDataBlock(stream);
+            }
+        } else {
+            if (traits & ShaderTrait::Modulate)
+                stream << "uniform vec4 modulation;\n";
+            if (traits & ShaderTrait::AdjustSaturation)
+                stream << "uniform float saturation;\n";
+        }
 
         stream << "\n" << varying << " vec2 texcoord0;\n";
 
@@ -755,8 +874,10 @@ GLShader *ShaderManager::generateShader(ShaderTraits traits)
 
 GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
-    const QByteArray vertex   = vertexSource.isEmpty() ? generateVertexSource(traits) : vertexSource;
-    const QByteArray fragment = fragmentSource.isEmpty() ? generateFragmentSource(traits) : fragmentSource;
+    // Custom sources may declare the uniforms of the block on their own
+    const bool drawDataBlock = m_drawDataBlock && vertexSource.isEmpty() && fragmentSource.isEmpty();
+    const QByteArray vertex   = vertexSource.isEmpty() ? generateVertexSource(traits, drawDataBlock) : vertexSource;
+    const QByteArray fragment = fragmentSource.isEmpty() ? generateFragmentSource(traits, drawDataBlock) : fragmentSource;
 
 #if 0
     qCDebug(LIBKWINGLUTILS) << "**************";
@@ -767,16 +888,57 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
 #endif
 
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+
+    // The attribute and output locations are the same for all these shaders, so they
+    // are part of the stored binary and don't need to be part of the key.
+    QByteArray key;
+    if (m_shaderCache->isSupported()) {
+        key = m_shaderCache->key(vertex, fragment);
+        if (m_shaderCache->load(shader->mProgram, key)) {
+            shader->mValid = true;
+            GLStatistics::add(GLStatistics::ProgramBinaryLoads);
+            if (drawDataBlock) {
+                shader->resolveDrawDataBlock();
+            }
+            return shader;
+        }
+    }
+
     shader->load(vertex, fragment);
 
     shader->bindAttributeLocation("position", VA_Position);
     shader->bindAttributeLocation("texcoord", VA_TexCoord);
     shader->bindFragDataLocation("fragColor", 0);
 
+    if (!key.isEmpty()) {
+        m_shaderCache->prepare(shader->mProgram);
+    }
     shader->link();
+    GLStatistics::add(GLStatistics::ShaderCompilations);
+
+    if (shader->isValid() && !key.isEmpty()) {
+        m_shaderCache->store(shader->mProgram, key);
+    }
+    if (drawDataBlock) {
+        shader->resolveDrawDataBlock();
+    }
     return shader;
 }
 
+void ShaderManager::preloadShaders()
+{
+    const ShaderTraits commonTraits[] = {
+        ShaderTrait::MapTexture,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate,
+        ShaderTrait::MapTexture | ShaderTrait::AdjustSaturation,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation,
+        ShaderTrait::UniformColor,
+    };
+    for (const ShaderTraits &traits : commonTraits) {
+        shader(traits);
+    }
+}
+
 static QString resolveShaderFilePath(const QString &filePath)
 {
     QString suffix;
@@ -915,6 +1077,7 @@ QRect GLRenderTarget::s_virtualScreenGeometry;
 qreal GLRenderTarget::s_virtualScreenScale = 1.0;
 GLint GLRenderTarget::s_virtualScreenViewport[4];
 GLuint GLRenderTarget::s_kwinFramebuffer = 0;
+int GLRenderTarget::s_kwinFramebufferDepth = -1;
 
 void GLRenderTarget::initStatic()
 {
@@ -937,6 +1100,7 @@ void GLRenderTarget::cleanup()
     Q_ASSERT(s_renderTargets.isEmpty());
     sSupported = false;
     s_blitSupported = false;
+    s_kwinFramebufferDepth = -1;
 }
 
 bool GLRenderTarget::isRenderTargetBound()
@@ -944,6 +1108,26 @@ bool GLRenderTarget::isRenderTargetBound()
     return !s_renderTargets.isEmpty();
 }
 
+bool GLRenderTarget::isDepthBufferBound()
+{
+    if (isRenderTargetBound()) {
+        return false; // render targets only have a color attachment
+    }
+    if (s_kwinFramebufferDepth == -1) {
+        if (hasGLVersion(3, 0)) {
+            GLint type = GL_NONE;
+            const GLenum attachment = s_kwinFramebuffer ? GL_DEPTH_ATTACHMENT : GL_DEPTH;
+            glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
+            s_kwinFramebufferDepth = type != GL_NONE;
+        } else {
+            GLint bits = 0;
+            glGetIntegerv(GL_DEPTH_BITS, &bits);
+            s_kwinFramebufferDepth = bits > 0;
+        }
+    }
+    return s_kwinFramebufferDepth;
+}
+
 bool GLRenderTarget::blitSupported()
 {
     return s_blitSupported;
@@ -952,7 +1136,7 @@ bool GLRenderTarget::blitSupported()
 void GLRenderTarget::pushRenderTarget(GLRenderTarget* target)
 {
     if (s_renderTargets.isEmpty()) {
-        glGetIntegerv(GL_VIEWPORT, s_virtualScreenViewport);
+        GLState::viewport(s_virtualScreenViewport);
     }
     target->enable();
     s_renderTargets.push(target);
@@ -961,7 +1145,7 @@ void GLRenderTarget::pushRenderTarget(GLRenderTarget* target)
 void GLRenderTarget::pushRenderTargets(QStack <GLRenderTarget*> targets)
 {
     if (s_renderTargets.isEmpty()) {
-        glGetIntegerv(GL_VIEWPORT, s_virtualScreenViewport);
+        GLState::viewport(s_virtualScreenViewport);
     }
     targets.top()->enable();
     s_renderTargets.append(targets);
@@ -976,7 +1160,7 @@ GLRenderTarget* GLRenderTarget::popRenderTarget()
         s_renderTargets.top()->enable();
     } else {
         ret->disable();
-        glViewport (s_virtualScreenViewport[0], s_virtualScreenViewport[1], s_virtualScreenViewport[2], s_virtualScreenViewport[3]);
+        GLState::viewport(s_virtualScreenViewport[0], s_virtualScreenViewport[1], s_virtualScreenViewport[2], s_virtualScreenViewport[3]);
     }
 
     return ret;
@@ -1002,6 +1186,7 @@ GLRenderTarget::GLRenderTarget(const GLTexture& color)
 GLRenderTarget::~GLRenderTarget()
 {
     if (mValid) {
+        GLState::framebufferDeleted(mFramebuffer);
         glDeleteFramebuffers(1, &mFramebuffer);
     }
 }
@@ -1017,8 +1202,8 @@ bool GLRenderTarget::enable()
         return false;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
-    glViewport(0, 0, mTexture.width(), mTexture.height());
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    GLState::viewport(0, 0, mTexture.width(), mTexture.height());
     mTexture.setDirty();
 
     return true;
@@ -1035,7 +1220,7 @@ bool GLRenderTarget::disable()
         return false;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, s_kwinFramebuffer);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, s_kwinFramebuffer);
     mTexture.setDirty();
 
     return true;
@@ -1090,11 +1275,12 @@ void GLRenderTarget::initFBO()
     }
 #endif
 
-    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
 
 #if DEBUG_GLRENDERTARGET
     if ((err = glGetError()) != GL_NO_ERROR) {
         qCCritical(LIBKWINGLUTILS) << "glBindFramebuffer failed: " << formatGLError(err);
+        GLState::framebufferDeleted(mFramebuffer);
         glDeleteFramebuffers(1, &mFramebuffer);
         return;
     }
@@ -1106,7 +1292,8 @@ void GLRenderTarget::initFBO()
 #if DEBUG_GLRENDERTARGET
     if ((err = glGetError()) != GL_NO_ERROR) {
         qCCritical(LIBKWINGLUTILS) << "glFramebufferTexture2D failed: " << formatGLError(err);
-        glBindFramebuffer(GL_FRAMEBUFFER, s_kwinFramebuffer);
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, s_kwinFramebuffer);
+        GLState::framebufferDeleted(mFramebuffer);
         glDeleteFramebuffers(1, &mFramebuffer);
         return;
     }
@@ -1114,7 +1301,7 @@ void GLRenderTarget::initFBO()
 
     const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, s_kwinFramebuffer);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, s_kwinFramebuffer);
 
     if (status != GL_FRAMEBUFFER_COMPLETE) {
         // We have an incomplete framebuffer, consider it invalid
@@ -1122,6 +1309,7 @@ void GLRenderTarget::initFBO()
             qCCritical(LIBKWINGLUTILS) << "glCheckFramebufferStatus failed: " << formatGLError(glGetError());
         else
             qCCritical(LIBKWINGLUTILS) << "Invalid framebuffer status: " << formatFramebufferStatus(status);
+        GLState::framebufferDeleted(mFramebuffer);
         glDeleteFramebuffers(1, &mFramebuffer);
         return;
     }
@@ -1140,8 +1328,8 @@ void GLRenderTarget::blitFromFramebuffer(const QRect &source, const QRect &desti
     }
 
     GLRenderTarget::pushRenderTarget(this);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFramebuffer);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, s_kwinFramebuffer);
+    GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, mFramebuffer);
+    GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, s_kwinFramebuffer);
     const QRect s = source.isNull() ? s_virtualScreenGeometry : source;
     const QRect d = destination.isNull() ? QRect(0, 0, mTexture.width(), mTexture.height()) : destination;
 
@@ -1188,6 +1376,309 @@ void GLRenderTarget::detachTexture()
 }
 
 
+//****************************************
+// GLRenderTargetPool
+//****************************************
+GLRenderTargetPool *GLRenderTargetPool::s_instance = nullptr;
+
+static int bytesPerPixel(GLenum internalFormat)
+{
+    switch (internalFormat) {
+    case GL_RGBA16F:
+    case GL_RGBA16:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
+GLRenderTargetPool::Target::Target(GLenum internalFormat, const QSize &size, int levels)
+    : m_texture(new GLTexture(internalFormat, size, levels))
+    , m_internalFormat(internalFormat)
+    , m_levels(levels)
+{
+    m_renderTarget.reset(new GLRenderTarget(*m_texture));
+
+    // A full chain of mipmaps adds a third to the size of the texture.
+    m_bytes = qint64(size.width()) * size.height() * bytesPerPixel(internalFormat);
+    if (levels > 1) {
+        m_bytes += m_bytes / 3;
+    }
+}
+
+GLTexture *GLRenderTargetPool::Target::texture() const
+{
+    return m_texture.data();
+}
+
+GLRenderTarget *GLRenderTargetPool::Target::renderTarget() const
+{
+    return m_renderTarget.data();
+}
+
+GLRenderTargetPool::GLRenderTargetPool()
+    : m_budget(64 * 1024 * 1024)
+    , m_maximumAge(300)
+{
+}
+
+GLRenderTargetPool::~GLRenderTargetPool()
+{
+    // Targets that are still checked out are left alone, their owners may still touch them.
+    for (Target *target : qAsConst(m_targets)) {
+        Q_ASSERT_X(!target->m_inUse, "~GLRenderTargetPool", "render target has not been released");
+        if (target->m_inUse) {
+            qCWarning(LIBKWINGLUTILS) << "A render target has not been released before the pool is destroyed";
+            continue;
+        }
+        delete target;
+    }
+}
+
+GLRenderTargetPool *GLRenderTargetPool::instance()
+{
+    if (!s_instance) {
+        s_instance = new GLRenderTargetPool();
+    }
+    return s_instance;
+}
+
+void GLRenderTargetPool::cleanup()
+{
+    delete s_instance;
+    s_instance = nullptr;
+}
+
+GLRenderTargetPool::Target *GLRenderTargetPool::acquire(const QSize &size, GLenum internalFormat, int levels)
+{
+    if (size.isEmpty() || !GLRenderTarget::supported()) {
+        return nullptr;
+    }
+
+    Target *target = nullptr;
+    for (Target *candidate : qAsConst(m_targets)) {
+        if (candidate->m_inUse || candidate->m_internalFormat != internalFormat
+                || candidate->m_levels != levels || candidate->m_texture->size() != size) {
+            continue;
+        }
+        if (!target || candidate->m_lastUsed > target->m_lastUsed) {
+            target = candidate;
+        }
+    }
+
+    if (target) {
+        target->m_inUse = true;
+        m_idleUsage -= target->m_bytes;
+    } else {
+        target = new Target(internalFormat, size, levels);
+        if (!target->m_renderTarget->valid()) {
+            delete target;
+            return nullptr;
+        }
+        m_targets.append(target);
+        m_usage += target->m_bytes;
+        trim(m_budget);
+    }
+
+    target->m_lastUsed = m_frame;
+    target->m_texture->setFilter(levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    target->m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
+    target->m_texture->setYInverted(false);
+    return target;
+}
+
+void GLRenderTargetPool::release(Target *target)
+{
+    if (!m_targets.contains(target) || !target->m_inUse) {
+        return;
+    }
+    target->m_inUse = false;
+    target->m_lastUsed = m_frame;
+    m_idleUsage += target->m_bytes;
+}
+
+qint64 GLRenderTargetPool::budget() const
+{
+    return m_budget;
+}
+
+void GLRenderTargetPool::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+}
+
+int GLRenderTargetPool::maximumAge() const
+{
+    return m_maximumAge;
+}
+
+void GLRenderTargetPool::setMaximumAge(int frames)
+{
+    m_maximumAge = frames;
+}
+
+qint64 GLRenderTargetPool::usage() const
+{
+    return m_usage;
+}
+
+void GLRenderTargetPool::beginFrame()
+{
+    ++m_frame;
+
+    for (auto it = m_targets.begin(); it != m_targets.end();) {
+        Target *target = *it;
+        if (!target->m_inUse && m_frame - target->m_lastUsed > quint64(m_maximumAge)) {
+            m_usage -= target->m_bytes;
+            m_idleUsage -= target->m_bytes;
+            delete target;
+            it = m_targets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    trim(m_budget);
+}
+
+void GLRenderTargetPool::trim(qint64 bytes)
+{
+    // Only a handful of targets is pooled, a linear search for the oldest one is cheap.
+    while (m_idleUsage > bytes) {
+        auto oldest = m_targets.end();
+        for (auto it = m_targets.begin(); it != m_targets.end(); ++it) {
+            if (!(*it)->m_inUse && (oldest == m_targets.end() || (*it)->m_lastUsed < (*oldest)->m_lastUsed)) {
+                oldest = it;
+            }
+        }
+        if (oldest == m_targets.end()) {
+            break;
+        }
+        m_usage -= (*oldest)->m_bytes;
+        m_idleUsage -= (*oldest)->m_bytes;
+        delete *oldest;
+        m_targets.erase(oldest);
+    }
+}
+
+
+//****************************************
+// GLBackdrop
+//****************************************
+GLBackdrop *GLBackdrop::s_instance = nullptr;
+
+GLBackdrop::GLBackdrop()
+{
+}
+
+GLBackdrop::~GLBackdrop()
+{
+    for (const Backdrop &backdrop : qAsConst(m_backdrops)) {
+        GLRenderTargetPool::instance()->release(backdrop.target);
+    }
+}
+
+GLBackdrop *GLBackdrop::instance()
+{
+    if (!s_instance) {
+        s_instance = new GLBackdrop();
+    }
+    return s_instance;
+}
+
+void GLBackdrop::cleanup()
+{
+    delete s_instance;
+    s_instance = nullptr;
+}
+
+GLTexture *GLBackdrop::grab(const QRegion &region, GLenum internalFormat)
+{
+    const QRect screen = GLRenderTarget::virtualScreenGeometry();
+    const qreal scale = GLRenderTarget::virtualScreenScale();
+    const QSize textureSize = screen.size() * scale;
+
+    // The copies only hold what is in the framebuffer of the output that is being painted
+    const GLuint framebuffer = GLState::drawFramebuffer();
+    if (framebuffer != m_framebuffer || screen != m_screen || scale != m_scale) {
+        for (Backdrop &backdrop : m_backdrops) {
+            backdrop.valid = QRegion();
+        }
+        m_framebuffer = framebuffer;
+        m_screen = screen;
+        m_scale = scale;
+    }
+
+    auto it = std::find_if(m_backdrops.begin(), m_backdrops.end(), [&](const Backdrop &backdrop) {
+        const GLTexture *texture = backdrop.target->texture();
+        return texture->internalFormat() == internalFormat && texture->size() == textureSize;
+    });
+    if (it == m_backdrops.end()) {
+        GLRenderTargetPool::Target *target = GLRenderTargetPool::instance()->acquire(textureSize, internalFormat);
+        if (!target) {
+            return nullptr;
+        }
+        m_backdrops.append(Backdrop{target, QRegion(), true});
+        it = m_backdrops.end() - 1;
+    }
+    it->used = true;
+
+    GLTexture *texture = it->target->texture();
+    const QRegion missing = (region & screen) - it->valid;
+    if (missing.isEmpty()) {
+        return texture;
+    }
+
+    GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    texture->bind();
+    const QRect bounds(QPoint(0, 0), textureSize);
+    for (const QRect &rect : missing) {
+        const QRect texels = QRect((rect.x() - screen.x()) * scale,
+                                   (screen.height() - (rect.y() - screen.y() + rect.height())) * scale,
+                                   rect.width() * scale, rect.height() * scale) & bounds;
+        if (texels.isEmpty()) {
+            continue;
+        }
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, texels.x(), texels.y(), texels.x(), texels.y(),
+                            texels.width(), texels.height());
+        GLStatistics::add(GLStatistics::BackdropCopies);
+    }
+    texture->unbind();
+    it->valid |= missing;
+
+    return texture;
+}
+
+void GLBackdrop::invalidate(const QRegion &region)
+{
+    for (Backdrop &backdrop : m_backdrops) {
+        backdrop.valid -= region;
+    }
+}
+
+void GLBackdrop::beginFrame()
+{
+    for (Backdrop &backdrop : m_backdrops) {
+        backdrop.valid = QRegion();
+    }
+}
+
+void GLBackdrop::releaseUnused()
+{
+    for (auto it = m_backdrops.begin(); it != m_backdrops.end();) {
+        if (it->used) {
+            it->used = false;
+            ++it;
+        } else {
+            GLRenderTargetPool::instance()->release(it->target);
+            it = m_backdrops.erase(it);
+        }
+    }
+}
+
+
 // ------------------------------------------------------------------
 
 static const uint16_t indices[] = {
@@ -1854,6 +2345,355 @@ GLvoid *GLVertexBufferPrivate::mapNextFreeRange(size_t size)
 }
 
 
+//*********************************
+// GLStatistics
+//*********************************
+int GLStatistics::s_current[GLStatistics::CounterCount] = {};
+int GLStatistics::s_lastFrame[GLStatistics::CounterCount] = {};
+
+int GLStatistics::current(Counter counter)
+{
+    return s_current[counter];
+}
+
+int GLStatistics::lastFrame(Counter counter)
+{
+    return s_lastFrame[counter];
+}
+
+void GLStatistics::beginFrame()
+{
+    std::copy(std::begin(s_current), std::end(s_current), std::begin(s_lastFrame));
+    std::fill(std::begin(s_current), std::end(s_current), 0);
+}
+
+//*********************************
+// GLState
+//*********************************
+namespace
+{
+
+enum Capability {
+    Blend,
+    ScissorTest,
+    DepthTest,
+    CapabilityCount,
+};
+
+enum TextureTarget {
+    Texture2D,
+    TextureRectangle,
+    TextureExternal,
+    TextureTargetCount,
+};
+
+const int maxTextureUnits = 16;
+
+struct ShadowState
+{
+    std::optional<GLuint> program;
+    std::optional<int> activeTexture;
+    std::optional<GLuint> textures[maxTextureUnits][TextureTargetCount];
+    std::optional<GLuint> drawFramebuffer;
+    std::optional<GLuint> readFramebuffer;
+    std::optional<bool> capabilities[CapabilityCount];
+    std::optional<std::array<GLenum, 2>> blendFunc;
+    std::optional<std::array<GLint, 4>> viewport;
+    std::optional<std::array<GLint, 4>> scissor;
+};
+
+}
+
+static ShadowState s_glState;
+
+static int capabilityIndex(GLenum capability)
+{
+    switch (capability) {
+    case GL_BLEND:
+        return Blend;
+    case GL_SCISSOR_TEST:
+        return ScissorTest;
+    case GL_DEPTH_TEST:
+        return DepthTest;
+    default:
+        return -1;
+    }
+}
+
+static int textureTargetIndex(GLenum target)
+{
+    switch (target) {
+    case GL_TEXTURE_2D:
+        return Texture2D;
+    case GL_TEXTURE_RECTANGLE:
+        return TextureRectangle;
+    case GL_TEXTURE_EXTERNAL_OES:
+        return TextureExternal;
+    default:
+        return -1;
+    }
+}
+
+static bool isStateValidationEnabled()
+{
+#ifndef NDEBUG
+    static const bool enabled = qEnvironmentVariableIntValue("KWIN_GL_STATE_VALIDATION") == 1;
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Sends a state change to the driver with @a apply unless @a shadow already holds @a value.
+ */
+template<typename T, typename Apply>
+static void changeState(std::optional<T> &shadow, const T &value, Apply apply)
+{
+    if (isStateValidationEnabled()) {
+        GLState::validate();
+    }
+    if (shadow == value) {
+        GLStatistics::add(GLStatistics::ElidedStateChanges);
+        return;
+    }
+    apply();
+    shadow = value;
+    GLStatistics::add(GLStatistics::StateChanges);
+}
+
+void GLState::useProgram(GLuint program)
+{
+    changeState(s_glState.program, program, [program]() {
+        glUseProgram(program);
+    });
+}
+
+void GLState::activeTexture(GLenum unit)
+{
+    changeState(s_glState.activeTexture, int(unit - GL_TEXTURE0), [unit]() {
+        glActiveTexture(unit);
+    });
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+    const int targetIndex = textureTargetIndex(target);
+    if (targetIndex == -1) {
+        glBindTexture(target, texture);
+        GLStatistics::add(GLStatistics::StateChanges);
+        return;
+    }
+
+    if (!s_glState.activeTexture) {
+        GLint unit = GL_TEXTURE0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &unit);
+        s_glState.activeTexture = unit - GL_TEXTURE0;
+    }
+
+    const int unit = *s_glState.activeTexture;
+    if (unit >= maxTextureUnits) {
+        glBindTexture(target, texture);
+        GLStatistics::add(GLStatistics::StateChanges);
+        return;
+    }
+
+    changeState(s_glState.textures[unit][targetIndex], texture, [target, texture]() {
+        glBindTexture(target, texture);
+    });
+}
+
+void GLState::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    switch (target) {
+    case GL_DRAW_FRAMEBUFFER:
+        changeState(s_glState.drawFramebuffer, framebuffer, [framebuffer]() {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        });
+        break;
+    case GL_READ_FRAMEBUFFER:
+        changeState(s_glState.readFramebuffer, framebuffer, [framebuffer]() {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        });
+        break;
+    default:
+        if (isStateValidationEnabled()) {
+            validate();
+        }
+        if (s_glState.drawFramebuffer == framebuffer && s_glState.readFramebuffer == framebuffer) {
+            GLStatistics::add(GLStatistics::ElidedStateChanges);
+            return;
+        }
+        glBindFramebuffer(target, framebuffer);
+        s_glState.drawFramebuffer = framebuffer;
+        s_glState.readFramebuffer = framebuffer;
+        GLStatistics::add(GLStatistics::StateChanges);
+        break;
+    }
+}
+
+GLuint GLState::drawFramebuffer()
+{
+    if (!s_glState.drawFramebuffer) {
+        GLint framebuffer = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        s_glState.drawFramebuffer = framebuffer;
+    }
+    return *s_glState.drawFramebuffer;
+}
+
+void GLState::enable(GLenum capability)
+{
+    setEnabled(capability, true);
+}
+
+void GLState::disable(GLenum capability)
+{
+    setEnabled(capability, false);
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled)
+{
+    const auto apply = [capability, enabled]() {
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    };
+
+    const int index = capabilityIndex(capability);
+    if (index == -1) {
+        apply();
+        GLStatistics::add(GLStatistics::StateChanges);
+    } else {
+        changeState(s_glState.capabilities[index], enabled, apply);
+    }
+}
+
+bool GLState::isEnabled(GLenum capability)
+{
+    const int index = capabilityIndex(capability);
+    if (index == -1) {
+        return glIsEnabled(capability);
+    }
+    if (!s_glState.capabilities[index]) {
+        s_glState.capabilities[index] = glIsEnabled(capability);
+    }
+    return *s_glState.capabilities[index];
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination)
+{
+    changeState(s_glState.blendFunc, std::array<GLenum, 2>{source, destination}, [source, destination]() {
+        glBlendFunc(source, destination);
+    });
+}
+
+void GLState::viewport(int x, int y, int width, int height)
+{
+    changeState(s_glState.viewport, std::array<GLint, 4>{x, y, width, height}, [x, y, width, height]() {
+        glViewport(x, y, width, height);
+    });
+}
+
+void GLState::viewport(GLint *viewport)
+{
+    if (!s_glState.viewport) {
+        std::array<GLint, 4> current;
+        glGetIntegerv(GL_VIEWPORT, current.data());
+        s_glState.viewport = current;
+    }
+    std::copy(s_glState.viewport->cbegin(), s_glState.viewport->cend(), viewport);
+}
+
+void GLState::scissor(int x, int y, int width, int height)
+{
+    changeState(s_glState.scissor, std::array<GLint, 4>{x, y, width, height}, [x, y, width, height]() {
+        glScissor(x, y, width, height);
+    });
+}
+
+void GLState::textureDeleted(GLuint texture)
+{
+    for (auto &unit : s_glState.textures) {
+        for (std::optional<GLuint> &binding : unit) {
+            if (binding == texture) {
+                binding = 0;
+            }
+        }
+    }
+}
+
+void GLState::framebufferDeleted(GLuint framebuffer)
+{
+    if (s_glState.drawFramebuffer == framebuffer) {
+        s_glState.drawFramebuffer = 0;
+    }
+    if (s_glState.readFramebuffer == framebuffer) {
+        s_glState.readFramebuffer = 0;
+    }
+}
+
+void GLState::invalidate()
+{
+    s_glState = ShadowState();
+    GLDrawDataBuffer::invalidate();
+}
+
+template<typename T>
+static bool validateState(const char *name, const std::optional<T> &shadow, const T &actual)
+{
+    if (shadow && *shadow != actual) {
+        qCWarning(LIBKWINGLUTILS) << "The shadow state of" << name << "doesn't match the GL state";
+        return false;
+    }
+    return true;
+}
+
+bool GLState::validate()
+{
+    bool valid = true;
+    GLint value = 0;
+
+    glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+    valid &= validateState("GL_CURRENT_PROGRAM", s_glState.program, GLuint(value));
+
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+    valid &= validateState("GL_ACTIVE_TEXTURE", s_glState.activeTexture, int(value - GL_TEXTURE0));
+
+    // Only the 2D binding of the active unit can be checked without changing the state.
+    const int unit = value - GL_TEXTURE0;
+    if (unit < maxTextureUnits) {
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+        valid &= validateState("GL_TEXTURE_BINDING_2D", s_glState.textures[unit][Texture2D], GLuint(value));
+    }
+
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &value);
+    valid &= validateState("GL_DRAW_FRAMEBUFFER_BINDING", s_glState.drawFramebuffer, GLuint(value));
+    if (hasGLVersion(3, 0)) {
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &value);
+        valid &= validateState("GL_READ_FRAMEBUFFER_BINDING", s_glState.readFramebuffer, GLuint(value));
+    }
+
+    valid &= validateState("GL_BLEND", s_glState.capabilities[Blend], bool(glIsEnabled(GL_BLEND)));
+    valid &= validateState("GL_SCISSOR_TEST", s_glState.capabilities[ScissorTest], bool(glIsEnabled(GL_SCISSOR_TEST)));
+    valid &= validateState("GL_DEPTH_TEST", s_glState.capabilities[DepthTest], bool(glIsEnabled(GL_DEPTH_TEST)));
+
+    std::array<GLint, 2> blendFunc;
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blendFunc[0]);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blendFunc[1]);
+    valid &= validateState("the blend function", s_glState.blendFunc, std::array<GLenum, 2>{GLenum(blendFunc[0]), GLenum(blendFunc[1])});
+
+    std::array<GLint, 4> box;
+    glGetIntegerv(GL_VIEWPORT, box.data());
+    valid &= validateState("GL_VIEWPORT", s_glState.viewport, box);
+    glGetIntegerv(GL_SCISSOR_BOX, box.data());
+    valid &= validateState("GL_SCISSOR_BOX", s_glState.scissor, box);
+
+    return valid;
+}
+
 //*********************************
 // GLVertexBuffer
 //*********************************
@@ -1899,6 +2739,7 @@ GLvoid *GLVertexBuffer::map(size_t size)
 {
     d->mappedSize = size;
     d->frameSize += size;
+    GLStatistics::add(GLStatistics::BufferUploads);
 
     if (d->persistent)
         return d->getIdleRange(size);
@@ -2016,6 +2857,8 @@ void GLVertexBuffer::draw(GLenum primitiveMode, int first, int count)
 
 void GLVertexBuffer::draw(const QRegion &region, GLenum primitiveMode, int first, int count, bool hardwareClipping)
 {
+    GLShader::flushDrawData();
+
     if (primitiveMode == GL_QUADS) {
         IndexBuffer *&indexBuffer = GLVertexBufferPrivate::s_indexBuffer;
 
@@ -2029,14 +2872,16 @@ void GLVertexBuffer::draw(const QRegion &region, GLenum primitiveMode, int first
 
         if (!hardwareClipping) {
             glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, nullptr, first);
+            GLStatistics::add(GLStatistics::DrawCalls);
         } else {
             // Clip using scissoring
             for (const QRect &r : region) {
-                glScissor((r.x() - s_virtualScreenGeometry.x()) * s_virtualScreenScale,
+                GLState::scissor((r.x() - s_virtualScreenGeometry.x()) * s_virtualScreenScale,
                 (s_virtualScreenGeometry.height() + s_virtualScreenGeometry.y() - r.y() - r.height()) * s_virtualScreenScale,
                 r.width() * s_virtualScreenScale,
                 r.height() * s_virtualScreenScale);
                 glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, nullptr, first);
+                GLStatistics::add(GLStatistics::DrawCalls);
             }
         }
         return;
@@ -2044,14 +2889,16 @@ void GLVertexBuffer::draw(const QRegion &region, GLenum primitiveMode, int first
 
     if (!hardwareClipping) {
         glDrawArrays(primitiveMode, first, count);
+        GLStatistics::add(GLStatistics::DrawCalls);
     } else {
         // Clip using scissoring
         for (const QRect &r : region) {
-            glScissor((r.x() - s_virtualScreenGeometry.x()) * s_virtualScreenScale,
+            GLState::scissor((r.x() - s_virtualScreenGeometry.x()) * s_virtualScreenScale,
                       (s_virtualScreenGeometry.height()  + s_virtualScreenGeometry.y() - r.y() - r.height()) * s_virtualScreenScale,
                       r.width() * s_virtualScreenScale,
                       r.height() * s_virtualScreenScale);
             glDrawArrays(primitiveMode, first, count);
+            GLStatistics::add(GLStatistics::DrawCalls);
         }
     }
 }
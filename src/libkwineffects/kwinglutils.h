@@ -17,6 +17,7 @@
 #include "kwingltexture.h"
 
 // Qt
+#include <QScopedPointer>
 #include <QSize>
 #include <QStack>
 
@@ -34,6 +35,8 @@ template< class K, class V > class QHash;
 namespace KWin
 {
 
+class GLShaderCache;
+class GLUniformCache;
 class GLVertexBuffer;
 class GLVertexBufferPrivate;
 
@@ -75,6 +78,10 @@ public:
 
     bool link();
 
+    /**
+     * Returns the location of the uniform @a name. The locations are cached, so looking up
+     * a name again doesn't query the driver.
+     */
     int uniformLocation(const char* name);
 
     bool setUniform(const char* name, float value);
@@ -155,10 +162,19 @@ protected:
     void resolveLocations();
 
 private:
+    struct DrawDataBlock;
+
+    void resolveDrawDataBlock();
+    bool updateUniform(int location, const void *data, int size);
+    bool setDrawData(int offset, const float *values, int count);
+    static void flushDrawData();
+
     unsigned int mProgram;
     bool mValid:1;
     bool mLocationsResolved:1;
     bool mExplicitLinking:1;
+    QScopedPointer<GLUniformCache> mUniformCache;
+    QScopedPointer<DrawDataBlock> mDrawData;
     int mMatrixLocation[MatrixCount];
     int mVec2Location[Vec2UniformCount];
     int mVec4Location[Vec4UniformCount];
@@ -166,7 +182,10 @@ private:
     int mIntLocation[IntUniformCount];
     int mColorLocation[ColorUniformCount];
 
+    static GLShader *s_boundShader;
+
     friend class ShaderManager;
+    friend class GLVertexBuffer;
 };
 
 
@@ -282,6 +301,15 @@ public:
      */
     GLShader *generateShaderFromFile(ShaderTraits traits, const QString &vertexFile = QString(), const QString &fragmentFile = QString());
 
+    /**
+     * Creates the shaders for the commonly used traits in advance, so painting doesn't have
+     * to wait for them later. The shaders are loaded from the program binary cache if it is
+     * available.
+     *
+     * @since 5.25
+     */
+    void preloadShaders();
+
     /**
      * @return a pointer to the ShaderManager instance
      */
@@ -299,12 +327,14 @@ private:
     void bindFragDataLocations(GLShader *shader);
     void bindAttributeLocations(GLShader *shader) const;
 
-    QByteArray generateVertexSource(ShaderTraits traits) const;
-    QByteArray generateFragmentSource(ShaderTraits traits) const;
+    QByteArray generateVertexSource(ShaderTraits traits, bool drawDataBlock = false) const;
+    QByteArray generateFragmentSource(ShaderTraits traits, bool drawDataBlock = false) const;
     GLShader *generateShader(ShaderTraits traits);
 
     QStack<GLShader*> m_boundShaders;
     QHash<ShaderTraits, GLShader *> m_shaderHash;
+    QScopedPointer<GLShaderCache> m_shaderCache;
+    bool m_drawDataBlock;
     static ShaderManager *s_shaderManager;
 };
 
@@ -451,6 +481,13 @@ public:
     static void pushRenderTarget(GLRenderTarget *target);
     static GLRenderTarget *popRenderTarget();
     static bool isRenderTargetBound();
+    /**
+     * Whether the framebuffer that is currently rendered to has a depth buffer.
+     *
+     * Render targets never have one. Whether KWin's framebuffer has one is queried once
+     * and remembered until a different framebuffer is set with setKWinFramebuffer().
+     */
+    static bool isDepthBufferBound();
     /**
      * Whether the GL_EXT_framebuffer_blit extension is supported.
      * This functionality is not available in OpenGL ES 2.0.
@@ -523,7 +560,10 @@ public:
      * @since 5.18
      */
     static void setKWinFramebuffer(GLuint fb) {
-        s_kwinFramebuffer = fb;
+        if (s_kwinFramebuffer != fb) {
+            s_kwinFramebuffer = fb;
+            s_kwinFramebufferDepth = -1;
+        }
     }
 
 
@@ -542,6 +582,7 @@ private:
     static qreal s_virtualScreenScale;
     static GLint s_virtualScreenViewport[4];
     static GLuint s_kwinFramebuffer;
+    static int s_kwinFramebufferDepth;
 
     GLTexture mTexture;
     bool mValid;
@@ -549,6 +590,170 @@ private:
     GLuint mFramebuffer;
 };
 
+/**
+ * @short Recycles render targets and the textures they render into.
+ *
+ * Effects that render into offscreen textures acquire a render target of the size and
+ * format they need and release it once they are done with it. Released render targets are
+ * kept for a while, so the next request of the same size and format doesn't have to
+ * allocate a new texture and framebuffer object.
+ *
+ * Targets are matched by their exact size, format and number of mipmap levels, because the
+ * textures are sampled in whole. Released targets are deleted when they haven't been used for
+ * maximumAge() frames or when they don't fit into the budget() anymore. The contents of an
+ * acquired render target are undefined.
+ *
+ * release() doesn't need a current OpenGL context, the targets are deleted in beginFrame() and
+ * acquire().
+ *
+ * @since 5.25
+ */
+class KWINGLUTILS_EXPORT GLRenderTargetPool
+{
+public:
+    /**
+     * A render target together with the texture it renders into.
+     */
+    class KWINGLUTILS_EXPORT Target
+    {
+    public:
+        GLTexture *texture() const;
+        GLRenderTarget *renderTarget() const;
+
+    private:
+        Target(GLenum internalFormat, const QSize &size, int levels);
+
+        QScopedPointer<GLTexture> m_texture;
+        QScopedPointer<GLRenderTarget> m_renderTarget;
+        GLenum m_internalFormat;
+        int m_levels;
+        qint64 m_bytes;
+        quint64 m_lastUsed = 0;
+        bool m_inUse = true;
+        friend class GLRenderTargetPool;
+    };
+
+    static GLRenderTargetPool *instance();
+
+    /**
+     * Returns a render target with a texture of the given @a size, @a internalFormat and number
+     * of mipmap @a levels, or @c nullptr if it can't be created. The texture uses linear
+     * filtering, is clamped to its edges and isn't y-inverted.
+     */
+    Target *acquire(const QSize &size, GLenum internalFormat = GL_RGBA8, int levels = 1);
+    /**
+     * Hands the @a target back to the pool. The caller must not use it anymore.
+     */
+    void release(Target *target);
+
+    /**
+     * Returns the number of bytes that released render targets may occupy.
+     */
+    qint64 budget() const;
+    void setBudget(qint64 bytes);
+    /**
+     * Returns the number of frames a released render target is kept for.
+     */
+    int maximumAge() const;
+    void setMaximumAge(int frames);
+    /**
+     * Returns the number of bytes occupied by all render targets, including the ones in use.
+     */
+    qint64 usage() const;
+
+    /**
+     * Ages the released render targets and deletes the ones that have expired. The compositor
+     * calls this once per frame, not once per painted output.
+     */
+    void beginFrame();
+
+private:
+    GLRenderTargetPool();
+    ~GLRenderTargetPool();
+    void trim(qint64 bytes);
+
+    friend void KWin::cleanupGL();
+    static void cleanup();
+    static GLRenderTargetPool *s_instance;
+
+    QVector<Target *> m_targets;
+    qint64 m_budget;
+    qint64 m_usage = 0;
+    qint64 m_idleUsage = 0;
+    quint64 m_frame = 0;
+    int m_maximumAge;
+};
+
+/**
+ * @short Shares copies of the framebuffer behind the windows between effects.
+ *
+ * Effects that sample what has been painted behind a window, like the blur and the background
+ * contrast, copy the area they need with grab() instead of copying it into a texture of their
+ * own. The copy is laid out like the framebuffer of the output that is being painted, the bottom
+ * left texel holds the bottom left pixel of the output.
+ *
+ * The parts of the framebuffer that have been grabbed already are only copied again if
+ * something has drawn over them since then, so effects sampling the same area one after another
+ * share one copy. The grabbed contents are forgotten at the start of every frame.
+ *
+ * The backdrop can't tell on its own when the framebuffer changes. The scene invalidates what it
+ * draws, and every effect that draws into the framebuffer, e.g. the result of a blur, has to call
+ * invalidate() for the area it has drawn, otherwise effects after it see stale contents.
+ *
+ * @since 5.25
+ */
+class KWINGLUTILS_EXPORT GLBackdrop
+{
+public:
+    static GLBackdrop *instance();
+
+    /**
+     * Copies the parts of @a region that haven't been grabbed yet from the currently bound
+     * framebuffer and returns the texture holding them. The texture covers the output that is
+     * being painted at its scale and has the given @a internalFormat. The texels outside of
+     * the grabbed regions are undefined.
+     *
+     * Returns @c nullptr if the texture can't be created.
+     */
+    GLTexture *grab(const QRegion &region, GLenum internalFormat = GL_RGBA8);
+
+    /**
+     * Marks @a region, in global coordinates, as drawn over. The scene and effects call this
+     * for everything they draw into the framebuffer. Only reading the backdrop doesn't need it.
+     */
+    void invalidate(const QRegion &region);
+
+    /**
+     * Forgets the grabbed contents. The compositor calls this before it paints an output.
+     */
+    void beginFrame();
+
+    /**
+     * Releases the textures that haven't been grabbed since the last call. The compositor
+     * calls this once per frame.
+     */
+    void releaseUnused();
+
+private:
+    GLBackdrop();
+    ~GLBackdrop();
+
+    friend void KWin::cleanupGL();
+    static void cleanup();
+    static GLBackdrop *s_instance;
+
+    struct Backdrop {
+        GLRenderTargetPool::Target *target;
+        QRegion valid;
+        bool used;
+    };
+
+    QVector<Backdrop> m_backdrops;
+    QRect m_screen;
+    qreal m_scale = 1;
+    GLuint m_framebuffer = 0;
+};
+
 enum VertexAttributeType {
     VA_Position = 0,
     VA_TexCoord = 1,
@@ -570,6 +775,129 @@ struct GLVertexAttrib
     int relativeOffset;   /** The relative offset of the attribute */
 };
 
+/**
+ * @short Counters of the GL calls issued by the helpers in this library.
+ *
+ * The counters are collected per frame. The compositor calls beginFrame() before it starts
+ * painting a frame; the values of the previous frame remain available through lastFrame().
+ *
+ * @since 5.25
+ */
+class KWINGLUTILS_EXPORT GLStatistics
+{
+public:
+    enum Counter {
+        DrawCalls, ///< glDrawArrays() and glDrawElements() calls
+        BufferUploads, ///< Uploads of vertex data, i.e. mapped or written buffer ranges
+        ShaderCompilations, ///< Shader programs that have been built from their sources
+        ProgramBinaryLoads, ///< Shader programs that have been loaded from the program binary cache
+        TextureUploads, ///< glTexSubImage2D() calls uploading client pixel data
+        StateChanges, ///< State changes that GLState has sent to the driver
+        ElidedStateChanges, ///< State changes that GLState has skipped because they were redundant
+        UniformUpdates, ///< glUniform*() calls, uploads and bindings of uniform buffer ranges
+        ElidedUniformUpdates, ///< Uniform updates that have been skipped because the value didn't change
+        UniformLocationQueries, ///< glGetUniformLocation() calls
+        BackdropCopies, ///< Copies of framebuffer areas into the backdrop of GLBackdrop
+        CounterCount,
+    };
+
+    /**
+     * Increments the @a counter of the current frame by @a count.
+     */
+    static void add(Counter counter, int count = 1)
+    {
+        s_current[counter] += count;
+    }
+    /**
+     * Returns the value of the @a counter in the frame that is currently being painted.
+     */
+    static int current(Counter counter);
+    /**
+     * Returns the value of the @a counter in the previous frame.
+     */
+    static int lastFrame(Counter counter);
+    /**
+     * Finishes the current frame and resets all counters.
+     */
+    static void beginFrame();
+
+private:
+    static int s_current[CounterCount];
+    static int s_lastFrame[CounterCount];
+};
+
+/**
+ * @short Shadow copy of the OpenGL state that changes most often.
+ *
+ * GLState remembers the bound program, the textures bound to each texture unit, the bound
+ * framebuffers, the viewport, the scissor box, the blend function and whether blending,
+ * scissor and depth testing are enabled. Changes that wouldn't alter the state aren't sent
+ * to the driver; the StateChanges and ElidedStateChanges counters of GLStatistics tell how
+ * many calls have been issued and skipped.
+ *
+ * The shadow state is only correct if all changes of the tracked state go through this class.
+ * Code that changes the state behind its back, e.g. a library doing its own rendering, has to
+ * call invalidate() afterwards. The state is invalidated whenever the compositor makes its
+ * context current.
+ *
+ * In debug builds the shadow state is checked against glGet*() before every change if the
+ * environment variable KWIN_GL_STATE_VALIDATION is set to 1.
+ *
+ * @since 5.25
+ */
+class KWINGLUTILS_EXPORT GLState
+{
+public:
+    static void useProgram(GLuint program);
+    /**
+     * Selects the texture unit that bindTexture() operates on, e.g. GL_TEXTURE0.
+     */
+    static void activeTexture(GLenum unit);
+    static void bindTexture(GLenum target, GLuint texture);
+    /**
+     * Binds @a framebuffer to @a target, which is GL_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER or
+     * GL_READ_FRAMEBUFFER.
+     */
+    static void bindFramebuffer(GLenum target, GLuint framebuffer);
+    /**
+     * Returns the framebuffer that is bound to GL_DRAW_FRAMEBUFFER.
+     */
+    static GLuint drawFramebuffer();
+
+    static void enable(GLenum capability);
+    static void disable(GLenum capability);
+    static void setEnabled(GLenum capability, bool enabled);
+    static bool isEnabled(GLenum capability);
+
+    static void blendFunc(GLenum source, GLenum destination);
+    static void viewport(int x, int y, int width, int height);
+    /**
+     * Returns the current viewport as x, y, width and height.
+     */
+    static void viewport(GLint *viewport);
+    static void scissor(int x, int y, int width, int height);
+
+    /**
+     * Tells the tracker that @a texture is about to be deleted. Deleting a bound texture
+     * unbinds it, and its name may be reused by the next texture.
+     */
+    static void textureDeleted(GLuint texture);
+    /**
+     * Tells the tracker that @a framebuffer is about to be deleted.
+     */
+    static void framebufferDeleted(GLuint framebuffer);
+
+    /**
+     * Forgets the shadow state, the next change of each state is sent to the driver.
+     */
+    static void invalidate();
+    /**
+     * Compares the shadow state with the state of the current context and logs a warning
+     * for every difference. Returns @c true if they match.
+     */
+    static bool validate();
+};
+
 /**
  * @short Vertex Buffer Object
  *
@@ -56,6 +56,15 @@ Options::Options(QObject *parent)
     , m_xwaylandMaxCrashCount(Options::defaultXwaylandMaxCrashCount())
     , m_latencyPolicy(Options::defaultLatencyPolicy())
     , m_renderTimeEstimator(Options::defaultRenderTimeEstimator())
+    , m_minimumSafetyMargin(Options::defaultMinimumSafetyMargin())
+    , m_maximumSafetyMargin(Options::defaultMaximumSafetyMargin())
+    , m_targetFrameMissRate(Options::defaultTargetFrameMissRate())
+    , m_occludedWindowFrameRate(Options::defaultOccludedWindowFrameRate())
+    , m_outputDeadlineScheduling(Options::defaultOutputDeadlineScheduling())
+    , m_tiledDamageTracking(Options::defaultTiledDamageTracking())
+    , m_frontToBackRendering(Options::defaultFrontToBackRendering())
+    , m_windowLayerCaching(Options::defaultWindowLayerCaching())
+    , m_windowLayerCacheBudget(Options::defaultWindowLayerCacheBudget())
     , m_compositingMode(Options::defaultCompositingMode())
     , m_useCompositing(Options::defaultUseCompositing())
     , m_hiddenPreviews(Options::defaultHiddenPreviews())
@@ -643,6 +652,134 @@ void Options::setRenderTimeEstimator(RenderTimeEstimator estimator)
     Q_EMIT renderTimeEstimatorChanged();
 }
 
+int Options::minimumSafetyMargin() const
+{
+    return m_minimumSafetyMargin;
+}
+
+void Options::setMinimumSafetyMargin(int margin)
+{
+    if (m_minimumSafetyMargin == margin) {
+        return;
+    }
+    m_minimumSafetyMargin = margin;
+    Q_EMIT minimumSafetyMarginChanged();
+}
+
+int Options::maximumSafetyMargin() const
+{
+    return m_maximumSafetyMargin;
+}
+
+void Options::setMaximumSafetyMargin(int margin)
+{
+    if (m_maximumSafetyMargin == margin) {
+        return;
+    }
+    m_maximumSafetyMargin = margin;
+    Q_EMIT maximumSafetyMarginChanged();
+}
+
+qreal Options::targetFrameMissRate() const
+{
+    return m_targetFrameMissRate;
+}
+
+void Options::setTargetFrameMissRate(qreal rate)
+{
+    rate = std::clamp(rate, 0.001, 0.5);
+    if (qFuzzyCompare(m_targetFrameMissRate, rate)) {
+        return;
+    }
+    m_targetFrameMissRate = rate;
+    Q_EMIT targetFrameMissRateChanged();
+}
+
+int Options::occludedWindowFrameRate() const
+{
+    return m_occludedWindowFrameRate;
+}
+
+void Options::setOccludedWindowFrameRate(int rate)
+{
+    rate = std::max(rate, 0);
+    if (m_occludedWindowFrameRate == rate) {
+        return;
+    }
+    m_occludedWindowFrameRate = rate;
+    Q_EMIT occludedWindowFrameRateChanged();
+}
+
+bool Options::isOutputDeadlineScheduling() const
+{
+    return m_outputDeadlineScheduling;
+}
+
+void Options::setOutputDeadlineScheduling(bool set)
+{
+    if (m_outputDeadlineScheduling == set) {
+        return;
+    }
+    m_outputDeadlineScheduling = set;
+    Q_EMIT outputDeadlineSchedulingChanged();
+}
+
+bool Options::isTiledDamageTracking() const
+{
+    return m_tiledDamageTracking;
+}
+
+void Options::setTiledDamageTracking(bool set)
+{
+    if (m_tiledDamageTracking == set) {
+        return;
+    }
+    m_tiledDamageTracking = set;
+    Q_EMIT tiledDamageTrackingChanged();
+}
+
+bool Options::isFrontToBackRendering() const
+{
+    return m_frontToBackRendering;
+}
+
+void Options::setFrontToBackRendering(bool set)
+{
+    if (m_frontToBackRendering == set) {
+        return;
+    }
+    m_frontToBackRendering = set;
+    Q_EMIT frontToBackRenderingChanged();
+}
+
+bool Options::isWindowLayerCaching() const
+{
+    return m_windowLayerCaching;
+}
+
+void Options::setWindowLayerCaching(bool set)
+{
+    if (m_windowLayerCaching == set) {
+        return;
+    }
+    m_windowLayerCaching = set;
+    Q_EMIT windowLayerCachingChanged();
+}
+
+int Options::windowLayerCacheBudget() const
+{
+    return m_windowLayerCacheBudget;
+}
+
+void Options::setWindowLayerCacheBudget(int value)
+{
+    if (m_windowLayerCacheBudget == value) {
+        return;
+    }
+    m_windowLayerCacheBudget = value;
+    Q_EMIT windowLayerCacheBudgetChanged();
+}
+
 void Options::setGlPlatformInterface(OpenGLPlatformInterface interface)
 {
     // check environment variable
@@ -792,6 +929,15 @@ void Options::syncFromKcfgc()
     setMoveMinimizedWindowsToEndOfTabBoxFocusChain(m_settings->moveMinimizedWindowsToEndOfTabBoxFocusChain());
     setLatencyPolicy(m_settings->latencyPolicy());
     setRenderTimeEstimator(m_settings->renderTimeEstimator());
+    setMinimumSafetyMargin(m_settings->minimumSafetyMargin());
+    setMaximumSafetyMargin(m_settings->maximumSafetyMargin());
+    setTargetFrameMissRate(m_settings->targetFrameMissRate());
+    setOccludedWindowFrameRate(m_settings->occludedWindowFrameRate());
+    setOutputDeadlineScheduling(m_settings->outputDeadlineScheduling());
+    setTiledDamageTracking(m_settings->tiledDamageTracking());
+    setFrontToBackRendering(m_settings->frontToBackRendering());
+    setWindowLayerCaching(m_settings->windowLayerCaching());
+    setWindowLayerCacheBudget(m_settings->windowLayerCacheBudget());
 }
 
 bool Options::loadCompositingConfig (bool force)
@@ -51,6 +51,7 @@ enum LatencyPolicy {
     LatencyMedium,
     LatencyHigh,
     LatencyExtremelyHigh,
+    LatencyAdaptive,
 };
 
 /**
@@ -60,6 +61,9 @@ enum RenderTimeEstimator {
     RenderTimeEstimatorMinimum,
     RenderTimeEstimatorMaximum,
     RenderTimeEstimatorAverage,
+    RenderTimeEstimatorPercentile50,
+    RenderTimeEstimatorPercentile90,
+    RenderTimeEstimatorPercentile99,
 };
 
 class Settings;
@@ -194,6 +198,48 @@ class KWIN_EXPORT Options : public QObject
     Q_PROPERTY(bool windowsBlockCompositing READ windowsBlockCompositing WRITE setWindowsBlockCompositing NOTIFY windowsBlockCompositingChanged)
     Q_PROPERTY(LatencyPolicy latencyPolicy READ latencyPolicy WRITE setLatencyPolicy NOTIFY latencyPolicyChanged)
     Q_PROPERTY(RenderTimeEstimator renderTimeEstimator READ renderTimeEstimator WRITE setRenderTimeEstimator NOTIFY renderTimeEstimatorChanged)
+    /**
+     * The lower bound of the safety margin when the latency policy is LatencyAdaptive, in microseconds.
+     */
+    Q_PROPERTY(int minimumSafetyMargin READ minimumSafetyMargin WRITE setMinimumSafetyMargin NOTIFY minimumSafetyMarginChanged)
+    /**
+     * The upper bound of the safety margin when the latency policy is LatencyAdaptive, in microseconds.
+     */
+    Q_PROPERTY(int maximumSafetyMargin READ maximumSafetyMargin WRITE setMaximumSafetyMargin NOTIFY maximumSafetyMarginChanged)
+    /**
+     * The fraction of frames that are allowed to miss their presentation deadline when the
+     * latency policy is LatencyAdaptive.
+     */
+    Q_PROPERTY(qreal targetFrameMissRate READ targetFrameMissRate WRITE setTargetFrameMissRate NOTIFY targetFrameMissRateChanged)
+    /**
+     * The rate at which frame callbacks are sent to windows that are completely covered by
+     * opaque windows, in Hz. If zero, covered windows are not throttled.
+     */
+    Q_PROPERTY(int occludedWindowFrameRate READ occludedWindowFrameRate WRITE setOccludedWindowFrameRate NOTIFY occludedWindowFrameRateChanged)
+    /**
+     * Whether outputs whose next frame is due earlier are rendered first when the compositing
+     * cycles of several outputs would otherwise overlap.
+     */
+    Q_PROPERTY(bool outputDeadlineScheduling READ isOutputDeadlineScheduling WRITE setOutputDeadlineScheduling NOTIFY outputDeadlineSchedulingChanged)
+    /**
+     * Whether damage and occlusion are tracked in fixed-size tiles rather than exact regions
+     * when painting the screen.
+     */
+    Q_PROPERTY(bool tiledDamageTracking READ isTiledDamageTracking WRITE setTiledDamageTracking NOTIFY tiledDamageTrackingChanged)
+    /**
+     * Whether the OpenGL compositor draws opaque windows front-to-back with depth testing,
+     * so that the GPU rejects the hidden parts of windows below them.
+     */
+    Q_PROPERTY(bool frontToBackRendering READ isFrontToBackRendering WRITE setFrontToBackRendering NOTIFY frontToBackRenderingChanged)
+    /**
+     * Whether the OpenGL compositor flattens windows that have not changed for a few frames
+     * into a single offscreen texture.
+     */
+    Q_PROPERTY(bool windowLayerCaching READ isWindowLayerCaching WRITE setWindowLayerCaching NOTIFY windowLayerCachingChanged)
+    /**
+     * The maximum amount of video memory, in MiB, used by the flattened windows.
+     */
+    Q_PROPERTY(int windowLayerCacheBudget READ windowLayerCacheBudget WRITE setWindowLayerCacheBudget NOTIFY windowLayerCacheBudgetChanged)
 public:
 
     explicit Options(QObject *parent = nullptr);
@@ -600,6 +646,15 @@ public:
     QStringList modifierOnlyDBusShortcut(Qt::KeyboardModifier mod) const;
     LatencyPolicy latencyPolicy() const;
     RenderTimeEstimator renderTimeEstimator() const;
+    int minimumSafetyMargin() const;
+    int maximumSafetyMargin() const;
+    qreal targetFrameMissRate() const;
+    int occludedWindowFrameRate() const;
+    bool isOutputDeadlineScheduling() const;
+    bool isTiledDamageTracking() const;
+    bool isFrontToBackRendering() const;
+    bool isWindowLayerCaching() const;
+    int windowLayerCacheBudget() const;
 
     // setters
     void setFocusPolicy(FocusPolicy focusPolicy);
@@ -658,6 +713,15 @@ public:
     void setMoveMinimizedWindowsToEndOfTabBoxFocusChain(bool set);
     void setLatencyPolicy(LatencyPolicy policy);
     void setRenderTimeEstimator(RenderTimeEstimator estimator);
+    void setMinimumSafetyMargin(int margin);
+    void setMaximumSafetyMargin(int margin);
+    void setTargetFrameMissRate(qreal rate);
+    void setOccludedWindowFrameRate(int rate);
+    void setOutputDeadlineScheduling(bool set);
+    void setTiledDamageTracking(bool set);
+    void setFrontToBackRendering(bool set);
+    void setWindowLayerCaching(bool set);
+    void setWindowLayerCacheBudget(int value);
 
     // default values
     static WindowOperation defaultOperationTitlebarDblClick() {
@@ -756,6 +820,33 @@ public:
     static RenderTimeEstimator defaultRenderTimeEstimator() {
         return RenderTimeEstimatorMaximum;
     }
+    static int defaultMinimumSafetyMargin() {
+        return 1000;
+    }
+    static int defaultMaximumSafetyMargin() {
+        return 8000;
+    }
+    static qreal defaultTargetFrameMissRate() {
+        return 0.01;
+    }
+    static int defaultOccludedWindowFrameRate() {
+        return 1;
+    }
+    static bool defaultOutputDeadlineScheduling() {
+        return false;
+    }
+    static bool defaultTiledDamageTracking() {
+        return false;
+    }
+    static bool defaultFrontToBackRendering() {
+        return false;
+    }
+    static bool defaultWindowLayerCaching() {
+        return false;
+    }
+    static int defaultWindowLayerCacheBudget() {
+        return 64;
+    }
     /**
      * Performs loading all settings except compositing related.
      */
@@ -827,6 +918,15 @@ Q_SIGNALS:
     void latencyPolicyChanged();
     void configChanged();
     void renderTimeEstimatorChanged();
+    void minimumSafetyMarginChanged();
+    void maximumSafetyMarginChanged();
+    void targetFrameMissRateChanged();
+    void occludedWindowFrameRateChanged();
+    void outputDeadlineSchedulingChanged();
+    void tiledDamageTrackingChanged();
+    void frontToBackRenderingChanged();
+    void windowLayerCachingChanged();
+    void windowLayerCacheBudgetChanged();
 
 private:
     void setElectricBorders(int borders);
@@ -857,6 +957,15 @@ private:
     int m_xwaylandMaxCrashCount;
     LatencyPolicy m_latencyPolicy;
     RenderTimeEstimator m_renderTimeEstimator;
+    int m_minimumSafetyMargin;
+    int m_maximumSafetyMargin;
+    qreal m_targetFrameMissRate;
+    int m_occludedWindowFrameRate;
+    bool m_outputDeadlineScheduling;
+    bool m_tiledDamageTracking;
+    bool m_frontToBackRendering;
+    bool m_windowLayerCaching;
+    int m_windowLayerCacheBudget;
 
     CompositingType m_compositingMode;
     bool m_useCompositing;
@@ -49,6 +49,58 @@ Platform::Platform(QObject *parent)
             setPrimaryOutput(output);
         }
     });
+
+    // Some backends enable outputs before announcing them.
+    connect(this, &Platform::outputAdded, this, &Platform::assignOutputIndex);
+    connect(this, &Platform::outputEnabled, this, &Platform::enableOutputSlot);
+    connect(this, &Platform::outputDisabled, this, &Platform::disableOutputSlot);
+    connect(this, &Platform::outputRemoved, this, &Platform::releaseOutputIndex);
+}
+
+void Platform::assignOutputIndex(AbstractOutput *output)
+{
+    if (output->m_index != -1) {
+        return;
+    }
+    int index = m_indexedOutputs.indexOf(nullptr);
+    if (index == -1) {
+        index = m_indexedOutputs.count();
+        m_indexedOutputs.append(nullptr);
+        m_outputSlots.append(OutputSlot());
+    }
+    m_indexedOutputs[index] = output;
+    output->m_index = index;
+}
+
+void Platform::releaseOutputIndex(AbstractOutput *output)
+{
+    if (output->m_index == -1) {
+        return;
+    }
+    disableOutputSlot(output);
+    m_indexedOutputs[output->m_index] = nullptr;
+    output->m_index = -1;
+}
+
+void Platform::enableOutputSlot(AbstractOutput *output)
+{
+    assignOutputIndex(output);
+
+    OutputSlot &slot = m_outputSlots[output->index()];
+    slot.output = output;
+    slot.geometry = output->geometry();
+    connect(output, &AbstractOutput::geometryChanged, this, [this, output]() {
+        m_outputSlots[output->index()].geometry = output->geometry();
+    });
+}
+
+void Platform::disableOutputSlot(AbstractOutput *output)
+{
+    if (output->index() == -1 || m_outputSlots[output->index()].output != output) {
+        return;
+    }
+    m_outputSlots[output->index()] = OutputSlot();
+    disconnect(output, &AbstractOutput::geometryChanged, this, nullptr);
 }
 
 Platform::~Platform()
@@ -306,6 +306,21 @@ public:
     virtual Outputs enabledOutputs() const {
         return Outputs();
     }
+    struct OutputSlot
+    {
+        AbstractOutput *output = nullptr;
+        QRect geometry;
+    };
+    /**
+     * Returns the enabled outputs indexed by AbstractOutput::index(), along with their
+     * geometries. The slots of outputs that are not enabled are empty.
+     *
+     * Unlike enabledOutputs(), this doesn't allocate, which matters on hot paths such
+     * as scheduling repaints.
+     */
+    const QVector<OutputSlot> &outputSlots() const {
+        return m_outputSlots;
+    }
     AbstractOutput *findOutput(int screenId) const;
     AbstractOutput *findOutput(const QUuid &uuid) const;
     AbstractOutput *findOutput(const QString &name) const;
@@ -456,6 +471,10 @@ protected:
 
 private:
     void triggerCursorRepaint();
+    void assignOutputIndex(AbstractOutput *output);
+    void releaseOutputIndex(AbstractOutput *output);
+    void enableOutputSlot(AbstractOutput *output);
+    void disableOutputSlot(AbstractOutput *output);
     struct {
         QRect lastRenderedGeometry;
     } m_cursor;
@@ -472,6 +491,8 @@ private:
     bool m_isPerScreenRenderingEnabled = false;
     CompositingType m_selectedCompositor = NoCompositing;
     AbstractOutput *m_primaryOutput = nullptr;
+    QVector<AbstractOutput *> m_indexedOutputs;
+    QVector<OutputSlot> m_outputSlots;
 };
 
 }
@@ -229,6 +229,8 @@ bool AbstractEglBackend::makeCurrent()
         context->doneCurrent();
     }
     const bool current = eglMakeCurrent(m_display, m_surface, m_surface, m_context);
+    // The shadowed GL state belongs to the context that was current before.
+    GLState::invalidate();
     return current;
 }
 
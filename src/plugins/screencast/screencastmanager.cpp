@@ -58,7 +58,7 @@ private:
         connect(Compositor::self()->scene(), &Scene::frameRendered, this, &WindowStream::bufferToStream);
 
         connect(m_toplevel, &Toplevel::damaged, this, &WindowStream::includeDamage);
-        m_damagedRegion = m_toplevel->visibleGeometry();
+        m_damagedRegion = QRect(QPoint(0, 0), m_toplevel->clientGeometry().size());
         m_toplevel->addRepaintFull();
     }
 
@@ -68,7 +68,9 @@ private:
 
     void includeDamage(Toplevel *toplevel, const QRegion &damage) {
         Q_ASSERT(m_toplevel == toplevel);
-        m_damagedRegion |= damage;
+        // The damage is relative to the frame geometry, the stream shows the client geometry
+        const QRect client = m_toplevel->clientGeometry();
+        m_damagedRegion |= damage.translated(m_toplevel->pos() - client.topLeft()) & QRect(QPoint(0, 0), client.size());
     }
 
     void bufferToStream () {
@@ -415,10 +415,10 @@ void ScreenCastStream::recordFrame(const QRegion &damagedRegion)
             mvp.translate(cursorRect.left(), r.height() - cursorRect.top() - cursor->image().height() * m_cursor.scale);
             shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
 
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            GLState::enable(GL_BLEND);
+            GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
             m_cursor.texture->render(cursorRect, cursorRect, true);
-            glDisable(GL_BLEND);
+            GLState::disable(GL_BLEND);
             m_cursor.texture->unbind();
             m_cursor.lastRect = cursorRect;
 
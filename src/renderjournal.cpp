@@ -6,9 +6,20 @@
 
 #include "renderjournal.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace KWin
 {
 
+// The histogram buckets span from 50us up to 200ms, every bucket is about 14% wider
+// than the previous one. Anything outside that range is clamped to the first or the
+// last bucket.
+static const qreal s_histogramLowerBound = 50'000;
+static const qreal s_histogramUpperBound = 200'000'000;
+static const qreal s_histogramGrowth = std::log(s_histogramUpperBound / s_histogramLowerBound)
+        / (RenderJournal::histogramBucketCount - 1);
+
 RenderJournal::RenderJournal()
 {
 }
@@ -20,11 +31,26 @@ void RenderJournal::beginFrame()
 
 void RenderJournal::endFrame()
 {
-    std::chrono::nanoseconds duration(m_timer.nsecsElapsed());
+    add(std::chrono::nanoseconds(m_timer.nsecsElapsed()));
+}
+
+void RenderJournal::add(std::chrono::nanoseconds duration)
+{
     if (m_log.count() >= m_size) {
         m_log.dequeue();
     }
     m_log.enqueue(duration);
+
+    if (m_histogramCount == histogramWindowSize) {
+        m_histogram[m_histogramWindow[m_histogramHead]]--;
+    } else {
+        m_histogramCount++;
+    }
+
+    const int bucket = histogramBucketIndex(duration);
+    m_histogram[bucket]++;
+    m_histogramWindow[m_histogramHead] = bucket;
+    m_histogramHead = (m_histogramHead + 1) % histogramWindowSize;
 }
 
 std::chrono::nanoseconds RenderJournal::minimum() const
@@ -53,4 +79,41 @@ std::chrono::nanoseconds RenderJournal::average() const
     return result / m_log.count();
 }
 
+std::chrono::nanoseconds RenderJournal::percentile(qreal percentile) const
+{
+    if (!m_histogramCount) {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    const int rank = std::max(1, int(std::ceil(m_histogramCount * std::clamp(percentile, 0.0, 100.0) / 100)));
+    int accumulated = 0;
+    for (int i = 0; i < histogramBucketCount; ++i) {
+        accumulated += m_histogram[i];
+        if (accumulated >= rank) {
+            return histogramBucketUpperBound(i);
+        }
+    }
+
+    return histogramBucketUpperBound(histogramBucketCount - 1);
+}
+
+int RenderJournal::histogramSampleCount() const
+{
+    return m_histogramCount;
+}
+
+std::chrono::nanoseconds RenderJournal::histogramBucketUpperBound(int index)
+{
+    return std::chrono::nanoseconds(std::llround(s_histogramLowerBound * std::exp(s_histogramGrowth * index)));
+}
+
+int RenderJournal::histogramBucketIndex(std::chrono::nanoseconds duration)
+{
+    if (duration.count() <= s_histogramLowerBound) {
+        return 0;
+    }
+    const int index = int(std::ceil(std::log(duration.count() / s_histogramLowerBound) / s_histogramGrowth));
+    return std::min(index, histogramBucketCount - 1);
+}
+
 } // namespace KWin
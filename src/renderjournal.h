@@ -11,12 +11,19 @@
 #include <QElapsedTimer>
 #include <QQueue>
 
+#include <array>
+
 namespace KWin
 {
 
 /**
  * The RenderJournal class measures how long it takes to render frames and estimates how
  * long it will take to render the next frame.
+ *
+ * Besides the short log used by minimum(), maximum() and average(), the journal keeps a
+ * fixed-size histogram with logarithmically spaced buckets over a longer window of frames.
+ * The histogram is used to answer percentile queries, which are less sensitive to a single
+ * outlier frame than the maximum.
  */
 class KWIN_EXPORT RenderJournal
 {
@@ -33,6 +40,11 @@ public:
      */
     void endFrame();
 
+    /**
+     * Records a frame that took @a duration to render.
+     */
+    void add(std::chrono::nanoseconds duration);
+
     /**
      * Returns the maximum estimated amount of time that it takes to render a single frame.
      */
@@ -48,10 +60,40 @@ public:
      */
     std::chrono::nanoseconds average() const;
 
+    /**
+     * Returns the estimated amount of time within which @a percentile percent of frames
+     * are rendered. The @a percentile must be in the range [0, 100]. The returned value is
+     * the upper bound of the histogram bucket that contains the requested percentile.
+     */
+    std::chrono::nanoseconds percentile(qreal percentile) const;
+
+    /**
+     * Returns the number of frames that are currently recorded in the histogram.
+     */
+    int histogramSampleCount() const;
+
+    static constexpr int histogramBucketCount = 64;
+    static constexpr int histogramWindowSize = 240;
+
+    /**
+     * Returns the upper bound of the histogram bucket with the specified @a index.
+     */
+    static std::chrono::nanoseconds histogramBucketUpperBound(int index);
+
+    /**
+     * Returns the index of the histogram bucket that @a duration falls into.
+     */
+    static int histogramBucketIndex(std::chrono::nanoseconds duration);
+
 private:
     QElapsedTimer m_timer;
     QQueue<std::chrono::nanoseconds> m_log;
     int m_size = 15;
+
+    std::array<int, histogramBucketCount> m_histogram = {};
+    std::array<quint8, histogramWindowSize> m_histogramWindow = {};
+    int m_histogramHead = 0;
+    int m_histogramCount = 0;
 };
 
 } // namespace KWin
@@ -10,6 +10,8 @@
 #include "surfaceitem.h"
 #include "utils/common.h"
 
+#include <algorithm>
+
 namespace KWin
 {
 
@@ -27,8 +29,7 @@ RenderLoopPrivate *RenderLoopPrivate::get(RenderLoop *loop)
 RenderLoopPrivate::RenderLoopPrivate(RenderLoop *q)
     : q(q)
 {
-    compositeTimer.setSingleShot(true);
-    QObject::connect(&compositeTimer, &QTimer::timeout, q, [this]() { dispatch(); });
+    QObject::connect(&compositeTimer, &PreciseTimer::timeout, q, [this]() { dispatch(); });
 }
 
 void RenderLoopPrivate::scheduleRepaint()
@@ -52,7 +53,7 @@ void RenderLoopPrivate::scheduleRepaint()
     }
 
     // Estimate when it's a good time to perform the next compositing cycle.
-    const std::chrono::nanoseconds safetyMargin = std::chrono::milliseconds(3);
+    std::chrono::nanoseconds safetyMargin = std::chrono::milliseconds(3);
 
     std::chrono::nanoseconds renderTime;
     switch (options->latencyPolicy()) {
@@ -71,6 +72,11 @@ void RenderLoopPrivate::scheduleRepaint()
     case LatencyExtremelyHigh:
         renderTime = std::chrono::nanoseconds(long(vblankInterval.count() * 0.9));
         break;
+    case LatencyAdaptive:
+        // Rely on the render time estimator and the learned safety margin alone.
+        renderTime = std::chrono::nanoseconds::zero();
+        safetyMargin = adaptiveSafetyMargin;
+        break;
     }
 
     switch (options->renderTimeEstimator()) {
@@ -83,8 +89,18 @@ void RenderLoopPrivate::scheduleRepaint()
     case RenderTimeEstimatorAverage:
         renderTime = std::max(renderTime, renderJournal.average());
         break;
+    case RenderTimeEstimatorPercentile50:
+        renderTime = std::max(renderTime, renderJournal.percentile(50));
+        break;
+    case RenderTimeEstimatorPercentile90:
+        renderTime = std::max(renderTime, renderJournal.percentile(90));
+        break;
+    case RenderTimeEstimatorPercentile99:
+        renderTime = std::max(renderTime, renderJournal.percentile(99));
+        break;
     }
 
+    expectedRenderTime = renderTime;
     std::chrono::nanoseconds nextRenderTimestamp = nextPresentationTimestamp - renderTime - safetyMargin;
 
     // If we can't render the frame before the deadline, start compositing immediately.
@@ -92,8 +108,7 @@ void RenderLoopPrivate::scheduleRepaint()
         nextRenderTimestamp = currentTime;
     }
 
-    const std::chrono::nanoseconds waitInterval = nextRenderTimestamp - currentTime;
-    compositeTimer.start(std::chrono::duration_cast<std::chrono::milliseconds>(waitInterval));
+    compositeTimer.start(nextRenderTimestamp);
 }
 
 void RenderLoopPrivate::delayScheduleRepaint()
@@ -119,11 +134,42 @@ void RenderLoopPrivate::notifyFrameFailed()
     }
 }
 
+void RenderLoopPrivate::updateSafetyMargin(std::chrono::nanoseconds timestamp)
+{
+    if (options->latencyPolicy() != LatencyAdaptive || presentMode != SyncMode::Fixed) {
+        return;
+    }
+    if (nextPresentationTimestamp == std::chrono::nanoseconds::zero()) {
+        return;
+    }
+
+    // A frame is considered missed if it has been presented at least half a refresh cycle
+    // later than predicted. The safety margin grows by a fixed step after every missed frame
+    // and shrinks by a fraction of that step after every frame presented on time, so it
+    // settles at the point where the configured fraction of frames misses the deadline.
+    const std::chrono::nanoseconds vblankInterval(1'000'000'000'000ull / refreshRate);
+    const bool missed = timestamp > nextPresentationTimestamp + vblankInterval / 2;
+
+    const std::chrono::nanoseconds step = std::chrono::microseconds(500);
+    if (missed) {
+        adaptiveSafetyMargin += step;
+    } else {
+        const qreal missRate = options->targetFrameMissRate();
+        adaptiveSafetyMargin -= std::chrono::nanoseconds(long(step.count() * missRate / (1 - missRate)));
+    }
+
+    const std::chrono::nanoseconds minimum = std::chrono::microseconds(options->minimumSafetyMargin());
+    const std::chrono::nanoseconds maximum = std::chrono::microseconds(options->maximumSafetyMargin());
+    adaptiveSafetyMargin = std::clamp(adaptiveSafetyMargin, minimum, std::max(minimum, maximum));
+}
+
 void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp)
 {
     Q_ASSERT(pendingFrameCount > 0);
     pendingFrameCount--;
 
+    updateSafetyMargin(timestamp);
+
     if (lastPresentationTimestamp <= timestamp) {
         lastPresentationTimestamp = timestamp;
     } else {
@@ -199,7 +245,21 @@ void RenderLoop::beginFrame()
 
 void RenderLoop::endFrame()
 {
-    d->renderJournal.endFrame();
+    if (!d->gpuRenderTime) {
+        d->renderJournal.endFrame();
+    }
+}
+
+void RenderLoop::setGpuRenderTimeEnabled(bool enabled)
+{
+    d->gpuRenderTime = enabled;
+}
+
+void RenderLoop::addGpuRenderTime(std::chrono::nanoseconds renderTime)
+{
+    if (d->gpuRenderTime) {
+        d->renderJournal.add(renderTime);
+    }
 }
 
 int RenderLoop::refreshRate() const
@@ -238,6 +298,24 @@ std::chrono::nanoseconds RenderLoop::nextPresentationTimestamp() const
     return d->nextPresentationTimestamp;
 }
 
+std::chrono::nanoseconds RenderLoop::nextRenderTimestamp() const
+{
+    return d->compositeTimer.deadline();
+}
+
+std::chrono::nanoseconds RenderLoop::expectedRenderTime() const
+{
+    return d->expectedRenderTime;
+}
+
+void RenderLoop::dispatchScheduledFrame()
+{
+    if (d->compositeTimer.isActive()) {
+        d->compositeTimer.stop();
+        d->dispatch();
+    }
+}
+
 void RenderLoop::setFullscreenSurface(Item *surfaceItem)
 {
     d->fullscreenItem = surfaceItem;
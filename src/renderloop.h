@@ -58,6 +58,19 @@ public:
      */
     void endFrame();
 
+    /**
+     * Sets whether the render times are measured by the GPU. If @a enabled is @c true, the
+     * time between beginFrame() and endFrame() is no longer used to estimate the render time;
+     * instead, the render times are reported via addGpuRenderTime().
+     */
+    void setGpuRenderTimeEnabled(bool enabled);
+
+    /**
+     * Reports that it took @a renderTime to render a previous frame, measured from
+     * beginFrame() until the GPU finished executing the rendering commands.
+     */
+    void addGpuRenderTime(std::chrono::nanoseconds renderTime);
+
     /**
      * Returns the refresh rate at which the output is being updated, in millihertz.
      */
@@ -86,6 +99,24 @@ public:
      */
     std::chrono::nanoseconds nextPresentationTimestamp() const;
 
+    /**
+     * If a repaint has been scheduled, this function returns the time when the next
+     * compositing cycle is going to start; otherwise it returns zero. The returned
+     * timestamp is sourced from the monotonic clock.
+     */
+    std::chrono::nanoseconds nextRenderTimestamp() const;
+
+    /**
+     * Returns how long it is expected to take to render the next frame.
+     */
+    std::chrono::nanoseconds expectedRenderTime() const;
+
+    /**
+     * Starts the scheduled compositing cycle right away rather than at nextRenderTimestamp().
+     * This function does nothing if no repaint has been scheduled.
+     */
+    void dispatchScheduledFrame();
+
     /**
      * Sets the surface that currently gets scanned out,
      * so that this RenderLoop can adjust its timing behavior to that surface
@@ -8,8 +8,7 @@
 
 #include "renderloop.h"
 #include "renderjournal.h"
-
-#include <QTimer>
+#include "utils/precisetimer.h"
 
 namespace KWin
 {
@@ -29,17 +28,21 @@ public:
 
     void notifyFrameFailed();
     void notifyFrameCompleted(std::chrono::nanoseconds timestamp);
+    void updateSafetyMargin(std::chrono::nanoseconds timestamp);
 
     RenderLoop *q;
     std::chrono::nanoseconds lastPresentationTimestamp = std::chrono::nanoseconds::zero();
     std::chrono::nanoseconds nextPresentationTimestamp = std::chrono::nanoseconds::zero();
-    QTimer compositeTimer;
+    std::chrono::nanoseconds adaptiveSafetyMargin = std::chrono::milliseconds(3);
+    std::chrono::nanoseconds expectedRenderTime = std::chrono::nanoseconds::zero();
+    PreciseTimer compositeTimer;
     RenderJournal renderJournal;
     int refreshRate = 60000;
     int pendingFrameCount = 0;
     int inhibitCount = 0;
     bool pendingReschedule = false;
     bool pendingRepaint = false;
+    bool gpuRenderTime = false;
     RenderLoop::VrrPolicy vrrPolicy = RenderLoop::VrrPolicy::Never;
     Item *fullscreenItem = nullptr;
 
@@ -55,10 +55,12 @@
 #include "scene.h"
 #include "abstract_output.h"
 #include "internal_client.h"
+#include "options.h"
 #include "platform.h"
 #include "shadowitem.h"
 #include "surfaceitem.h"
 #include "unmanaged.h"
+#include "utils/tileregion.h"
 #include "waylandclient.h"
 #include "windowitem.h"
 #include "workspace.h"
@@ -243,6 +245,8 @@ void Scene::paintScreen(const QRegion &damage, const QRegion &repaint,
         m_expectedPresentTimestamp = presentTime;
     }
 
+    m_occludedWindows.clear();
+
     // preparation step
     auto effectsImpl = static_cast<EffectsHandlerImpl *>(effects);
     effectsImpl->startPaint();
@@ -306,29 +310,41 @@ void Scene::finalPaintScreen(int mask, const QRegion &region, ScreenPaintData& d
         paintSimpleScreen(mask, region);
 }
 
-static void resetRepaintsHelper(Item *item, AbstractOutput *output)
+bool Scene::isOccluded(Toplevel *toplevel) const
 {
-    item->resetRepaints(output);
+    return m_occludedWindows.contains(toplevel);
+}
+
+static void accumulateRepaints(Item *item, AbstractOutput *output, QRegion *repaints)
+{
+    if (!item->hasSubtreeRepaints(output)) {
+        return;
+    }
 
     const auto childItems = item->childItems();
     for (Item *childItem : childItems) {
-        resetRepaintsHelper(childItem, output);
+        accumulateRepaints(childItem, output, repaints);
     }
+
+    *repaints += item->repaints(output);
+    item->resetRepaints(output);
 }
 
 // The generic painting code that can handle even transformations.
 // It simply paints bottom-to-top.
 void Scene::paintGenericScreen(int orig_mask, const ScreenPaintData &)
 {
+    // Windows can be moved around by effects, so occlusion is unknown.
+    m_occludedWindows.clear();
+
     QVector<Phase2Data> phase2;
     phase2.reserve(stacking_order.size());
     for (Window * w : qAsConst(stacking_order)) { // bottom to top
+        WindowPrePaintData data;
         // Reset the repaint_region.
         // This has to be done here because many effects schedule a repaint for
         // the next frame within Effects::prePaintWindow.
-        resetRepaintsHelper(w->windowItem(), painted_screen);
-
-        WindowPrePaintData data;
+        accumulateRepaints(w->windowItem(), painted_screen, &data.damage);
         data.mask = orig_mask | (w->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
         w->resetPaintingEnabled();
         data.paint = infiniteRegion(); // no clipping, so doesn't really matter
@@ -358,17 +374,6 @@ void Scene::paintGenericScreen(int orig_mask, const ScreenPaintData &)
     }
 }
 
-static void accumulateRepaints(Item *item, AbstractOutput *output, QRegion *repaints)
-{
-    *repaints += item->repaints(output);
-    item->resetRepaints(output);
-
-    const auto childItems = item->childItems();
-    for (Item *childItem : childItems) {
-        accumulateRepaints(childItem, output, repaints);
-    }
-}
-
 // The optimized case without any transformations at all.
 // It can paint only the requested region and can use clipping
 // to reduce painting and improve performance.
@@ -389,8 +394,8 @@ void Scene::paintSimpleScreen(int orig_mask, const QRegion &region)
         WindowPrePaintData data;
         data.mask = orig_mask | (window->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
         window->resetPaintingEnabled();
-        data.paint = region;
-        accumulateRepaints(window->windowItem(), painted_screen, &data.paint);
+        accumulateRepaints(window->windowItem(), painted_screen, &data.damage);
+        data.paint = region | data.damage;
 
         // Clip out the decoration for opaque windows; the decoration is drawn in the second pass
         opaqueFullscreen = false; // TODO: do we care about unmanged windows here (maybe input windows?)
@@ -446,37 +451,66 @@ void Scene::paintSimpleScreen(int orig_mask, const QRegion &region)
         fullRepaint = (dirtyArea == displayRegion);
     }
 
-    QRegion allclips, upperTranslucentDamage;
-    upperTranslucentDamage = repaint_region;
-
-    // This is the occlusion culling pass
-    for (int i = phase2data.count() - 1; i >= 0; --i) {
-        Phase2Data *data = &phase2data[i];
+    QRegion allclips;
+    const QRect screenGeometry = painted_screen ? painted_screen->geometry() : geometry();
+    QSet<Toplevel *> occludedWindows;
 
-        if (fullRepaint) {
-            data->region = displayRegion;
-        } else {
-            data->region |= upperTranslucentDamage;
+    if (options->isTiledDamageTracking()) {
+        if (!fullRepaint) {
+            // Windows are painted in whole tiles, so everything beneath them has to be
+            // repainted in whole tiles as well.
+            dirtyArea = TileRegion(screenGeometry, dirtyArea).toRegion();
         }
+        cullOccludedRegionsTiled(phase2data, screenGeometry, fullRepaint, &allclips, &occludedWindows);
+    } else {
+        QRegion upperTranslucentDamage = repaint_region;
+
+        // This is the occlusion culling pass
+        for (int i = phase2data.count() - 1; i >= 0; --i) {
+            Phase2Data *data = &phase2data[i];
+
+            // Remember the windows whose surface is completely hidden behind higher opaque
+            // windows, so the Compositor can throttle their frame callbacks.
+            if (const SurfaceItem *surfaceItem = data->window->surfaceItem()) {
+                const QRect surfaceRect = surfaceItem->mapToGlobal(surfaceItem->boundingRect()) & screenGeometry;
+                if (!surfaceRect.isEmpty() && (QRegion(surfaceRect) - allclips).isEmpty()) {
+                    occludedWindows.insert(data->window->window());
+                }
+            }
 
-        // subtract the parts which will possibly been drawn as part of
-        // a higher opaque window
-        data->region -= allclips;
+            if (fullRepaint) {
+                data->region = displayRegion;
+            } else {
+                data->region |= upperTranslucentDamage;
+            }
 
-        // Here we rely on WindowPrePaintData::setTranslucent() to remove
-        // the clip if needed.
-        if (!data->clip.isEmpty() && !(data->mask & PAINT_WINDOW_TRANSLUCENT)) {
-            // clip away the opaque regions for all windows below this one
-            allclips |= data->clip;
-            // extend the translucent damage for windows below this by remaining (translucent) regions
-            if (!fullRepaint) {
-                upperTranslucentDamage |= data->region - data->clip;
+            // subtract the parts which will possibly been drawn as part of
+            // a higher opaque window
+            data->region -= allclips;
+
+            // Here we rely on WindowPrePaintData::setTranslucent() to remove
+            // the clip if needed.
+            if (!data->clip.isEmpty() && !(data->mask & PAINT_WINDOW_TRANSLUCENT)) {
+                // clip away the opaque regions for all windows below this one
+                allclips |= data->clip;
+                // extend the translucent damage for windows below this by remaining (translucent) regions
+                if (!fullRepaint) {
+                    upperTranslucentDamage |= data->region - data->clip;
+                }
+            } else if (!fullRepaint) {
+                upperTranslucentDamage |= data->region;
             }
-        } else if (!fullRepaint) {
-            upperTranslucentDamage |= data->region;
         }
     }
 
+    // If the screen is painted several times, a window is occluded only if it's occluded
+    // in every pass.
+    if (m_paintScreenCount == 1) {
+        m_occludedWindows = occludedWindows;
+    } else {
+        m_occludedWindows.intersect(occludedWindows);
+    }
+
     QRegion paintedArea;
     // Fill any areas of the root window not covered by opaque windows
     if (m_paintScreenCount == 1) {
@@ -518,6 +552,54 @@ void Scene::paintSimpleScreen(int orig_mask, const QRegion &region)
     }
 }
 
+// Same as the occlusion culling pass in paintSimpleScreen(), but the damage and the opaque
+// regions are tracked in tiles. The damage is rounded outward and the opaque regions are rounded
+// inward, so windows may be painted in more places than strictly necessary, but never in fewer.
+void Scene::cullOccludedRegionsTiled(QVector<Phase2Data> &phase2data, const QRect &screenGeometry, bool fullRepaint,
+                                     QRegion *allclips, QSet<Toplevel *> *occludedWindows) const
+{
+    TileRegion clipTiles(screenGeometry);
+    TileRegion upperTranslucentDamage(screenGeometry, repaint_region);
+
+    for (int i = phase2data.count() - 1; i >= 0; --i) {
+        Phase2Data *data = &phase2data[i];
+
+        if (const SurfaceItem *surfaceItem = data->window->surfaceItem()) {
+            const QRect surfaceRect = surfaceItem->mapToGlobal(surfaceItem->boundingRect()) & screenGeometry;
+            if (!surfaceRect.isEmpty()) {
+                TileRegion surfaceTiles(screenGeometry, surfaceRect);
+                surfaceTiles -= clipTiles;
+                if (surfaceTiles.isEmpty()) {
+                    occludedWindows->insert(data->window->window());
+                }
+            }
+        }
+
+        TileRegion regionTiles(screenGeometry);
+        if (fullRepaint) {
+            regionTiles.fill();
+        } else {
+            regionTiles.add(data->region);
+            regionTiles |= upperTranslucentDamage;
+        }
+        regionTiles -= clipTiles;
+
+        if (!data->clip.isEmpty() && !(data->mask & PAINT_WINDOW_TRANSLUCENT)) {
+            const TileRegion windowClipTiles(screenGeometry, data->clip, TileRegion::Rounding::Inward);
+            clipTiles |= windowClipTiles;
+            if (!fullRepaint) {
+                upperTranslucentDamage |= regionTiles - windowClipTiles;
+            }
+        } else if (!fullRepaint) {
+            upperTranslucentDamage |= regionTiles;
+        }
+
+        data->region = regionTiles.toRegion();
+    }
+
+    *allclips = clipTiles.toRegion();
+}
+
 void Scene::addToplevel(Toplevel *c)
 {
     Q_ASSERT(!m_windows.contains(c));
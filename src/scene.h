@@ -84,6 +84,13 @@ public:
 
     void paintScreen(AbstractOutput *output, const QList<Toplevel *> &toplevels);
 
+    /**
+     * Returns @c true if the surface of the given @a toplevel has been completely covered by
+     * opaque windows in the last painted frame. If the frame has been painted with
+     * transformations, no window is considered occluded.
+     */
+    bool isOccluded(Toplevel *toplevel) const;
+
     /**
      * Adds the Toplevel to the Scene.
      *
@@ -259,11 +266,14 @@ protected:
     // windows in their stacking order
     QVector< Window* > stacking_order;
 private:
+    void cullOccludedRegionsTiled(QVector<Phase2Data> &phase2data, const QRect &screenGeometry, bool fullRepaint,
+                                  QRegion *allclips, QSet<Toplevel *> *occludedWindows) const;
     void removeRepaints(AbstractOutput *output);
     void addCursorRepaints();
 
     std::chrono::milliseconds m_expectedPresentTimestamp = std::chrono::milliseconds::zero();
     QHash< Toplevel*, Window* > m_windows;
+    QSet<Toplevel *> m_occludedWindows;
     QMap<AbstractOutput *, QRegion> m_repaints;
     QRect m_geometry;
     // how many times finalPaintScreen() has been called
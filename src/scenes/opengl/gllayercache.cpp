@@ -0,0 +1,231 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "gllayercache.h"
+
+#include <kwingltexture.h>
+
+#include <cmath>
+
+namespace KWin
+{
+
+GLLayerCache::GLLayerCache()
+{
+}
+
+GLLayerCache::~GLLayerCache()
+{
+    clear();
+}
+
+bool GLLayerCache::isEnabled() const
+{
+    return m_enabled;
+}
+
+void GLLayerCache::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    if (!enabled) {
+        clear();
+    }
+}
+
+qint64 GLLayerCache::budget() const
+{
+    return m_budget;
+}
+
+void GLLayerCache::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+    if (m_usage > m_budget) {
+        evict(0, nullptr);
+    }
+}
+
+qint64 GLLayerCache::usage() const
+{
+    return m_usage;
+}
+
+int GLLayerCache::idleFrameThreshold()
+{
+    return 5;
+}
+
+void GLLayerCache::beginFrame(const AbstractOutput *output)
+{
+    ++m_frame;
+    m_output = output;
+}
+
+GLLayerCache::Entry *GLLayerCache::findEntry(const OpenGLWindow *window) const
+{
+    const auto it = m_entries.constFind(window);
+    return it != m_entries.constEnd() ? it->value(m_output) : nullptr;
+}
+
+GLLayerCache::Entry *GLLayerCache::findOrCreateEntry(const OpenGLWindow *window)
+{
+    Entry *&entry = m_entries[window][m_output];
+    if (!entry) {
+        entry = new Entry;
+    }
+    return entry;
+}
+
+void GLLayerCache::markDirty(const OpenGLWindow *window)
+{
+    Entry *entry = findOrCreateEntry(window);
+    entry->idleFrames = 0;
+    entry->uncacheable = false;
+    releaseLayer(*entry);
+}
+
+void GLLayerCache::markClean(const OpenGLWindow *window)
+{
+    Entry *entry = findOrCreateEntry(window);
+    if (entry->idleFrames < idleFrameThreshold()) {
+        ++entry->idleFrames;
+    }
+}
+
+void GLLayerCache::markUncacheable(const OpenGLWindow *window)
+{
+    if (Entry *entry = findEntry(window)) {
+        entry->uncacheable = true;
+        releaseLayer(*entry);
+    }
+}
+
+bool GLLayerCache::isIdle(const OpenGLWindow *window) const
+{
+    const Entry *entry = findEntry(window);
+    return entry && !entry->uncacheable && entry->idleFrames >= idleFrameThreshold();
+}
+
+const GLLayerCache::Layer *GLLayerCache::layer(const OpenGLWindow *window, qreal scale)
+{
+    Entry *entry = findEntry(window);
+    if (!entry || !entry->layer || entry->layer->scale != scale) {
+        return nullptr;
+    }
+    entry->layer->lastUsed = m_frame;
+    return entry->layer.get();
+}
+
+qint64 GLLayerCache::sizeOf(const Layer &layer)
+{
+    const QSize size = layer.texture->size();
+    return qint64(size.width()) * size.height() * 4;
+}
+
+GLLayerCache::Layer *GLLayerCache::createLayer(const OpenGLWindow *window, const QRect &geometry, qreal scale)
+{
+    Entry *entry = findEntry(window);
+    if (!entry || geometry.isEmpty()) {
+        return nullptr;
+    }
+    releaseLayer(*entry);
+
+    const QSize size(std::ceil(geometry.width() * scale), std::ceil(geometry.height() * scale));
+    const qint64 bytes = qint64(size.width()) * size.height() * 4;
+    if (bytes > m_budget) {
+        return nullptr;
+    }
+    evict(bytes, entry);
+
+    auto layer = std::make_unique<Layer>();
+    layer->texture = std::make_unique<GLTexture>(GL_RGBA8, size);
+    layer->texture->setFilter(GL_LINEAR);
+    layer->texture->setWrapMode(GL_CLAMP_TO_EDGE);
+    layer->geometry = geometry;
+    layer->scale = scale;
+    layer->lastUsed = m_frame;
+
+    m_usage += bytes;
+    entry->layer = std::move(layer);
+    return entry->layer.get();
+}
+
+void GLLayerCache::remove(const OpenGLWindow *window)
+{
+    const OutputEntries entries = m_entries.take(window);
+    for (Entry *entry : entries) {
+        releaseLayer(*entry);
+        delete entry;
+    }
+}
+
+void GLLayerCache::removeOutput(const AbstractOutput *output)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (Entry *entry = it->take(output)) {
+            releaseLayer(*entry);
+            delete entry;
+        }
+        if (it->isEmpty()) {
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_output == output) {
+        m_output = nullptr;
+    }
+}
+
+void GLLayerCache::clear()
+{
+    for (const OutputEntries &entries : qAsConst(m_entries)) {
+        for (Entry *entry : entries) {
+            releaseLayer(*entry);
+            delete entry;
+        }
+    }
+    m_entries.clear();
+}
+
+void GLLayerCache::releaseLayer(Entry &entry)
+{
+    if (entry.layer) {
+        m_usage -= sizeOf(*entry.layer);
+        entry.layer.reset();
+    }
+}
+
+void GLLayerCache::evict(qint64 bytes, const Entry *keep)
+{
+    // There are only a few layers, so a linear search for the least recently used one
+    // is cheaper than keeping a separate list in order.
+    while (m_usage + bytes > m_budget) {
+        Entry *oldest = nullptr;
+        for (const OutputEntries &entries : qAsConst(m_entries)) {
+            for (Entry *entry : entries) {
+                if (entry == keep || !entry->layer) {
+                    continue;
+                }
+                if (!oldest || entry->layer->lastUsed < oldest->layer->lastUsed) {
+                    oldest = entry;
+                }
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        releaseLayer(*oldest);
+    }
+}
+
+} // namespace KWin
@@ -0,0 +1,121 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QRect>
+
+#include <memory>
+
+namespace KWin
+{
+
+class AbstractOutput;
+class GLTexture;
+class OpenGLWindow;
+
+/**
+ * The GLLayerCache class keeps windows that have not changed for a while flattened into
+ * offscreen textures, so they can be drawn with a single quad.
+ *
+ * The scene reports every frame whether the items of a window have been repainted. A window
+ * becomes idle once it has gone without repaints for idleFrameThreshold() frames, only idle
+ * windows get a layer, and a repaint drops the layer again.
+ *
+ * Outputs are painted independently of each other and may have different scales, so a window
+ * is tracked separately on every output it is painted on. The calls between two beginFrame()
+ * calls refer to the output passed to the last one.
+ *
+ * The layers are limited by a memory budget; when a new layer doesn't fit, the least recently
+ * drawn layers are evicted.
+ */
+class GLLayerCache
+{
+public:
+    struct Layer
+    {
+        std::unique_ptr<GLTexture> texture;
+        QRect geometry;
+        qreal scale = 1;
+        bool hasAlpha = true;
+        quint64 lastUsed = 0;
+    };
+
+    GLLayerCache();
+    ~GLLayerCache();
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns the maximum number of bytes that the layers may occupy.
+     */
+    qint64 budget() const;
+    void setBudget(qint64 bytes);
+    qint64 usage() const;
+
+    static int idleFrameThreshold();
+
+    void beginFrame(const AbstractOutput *output);
+    /**
+     * Notifies the cache that the items of the @a window have been repainted, which makes
+     * its layer stale.
+     */
+    void markDirty(const OpenGLWindow *window);
+    void markClean(const OpenGLWindow *window);
+    /**
+     * Prevents the @a window from getting a layer until it is marked dirty, e.g. because
+     * flattening it would not save any draw calls.
+     */
+    void markUncacheable(const OpenGLWindow *window);
+    bool isIdle(const OpenGLWindow *window) const;
+
+    /**
+     * Returns the layer of the @a window, or @c nullptr if it has none or the layer has been
+     * rendered for a different @a scale.
+     */
+    const Layer *layer(const OpenGLWindow *window, qreal scale);
+    /**
+     * Allocates a new layer for the @a window, evicting other layers if needed. Returns
+     * @c nullptr if the layer doesn't fit into the budget.
+     */
+    Layer *createLayer(const OpenGLWindow *window, const QRect &geometry, qreal scale);
+    void remove(const OpenGLWindow *window);
+    /**
+     * Drops the layers of all windows on the @a output.
+     */
+    void removeOutput(const AbstractOutput *output);
+    void clear();
+
+private:
+    struct Entry
+    {
+        int idleFrames = 0;
+        bool uncacheable = false;
+        std::unique_ptr<Layer> layer;
+    };
+
+    using OutputEntries = QHash<const AbstractOutput *, Entry *>;
+
+    static qint64 sizeOf(const Layer &layer);
+    Entry *findEntry(const OpenGLWindow *window) const;
+    Entry *findOrCreateEntry(const OpenGLWindow *window);
+    void releaseLayer(Entry &entry);
+    void evict(qint64 bytes, const Entry *keep);
+
+    QHash<const OpenGLWindow *, OutputEntries> m_entries;
+    const AbstractOutput *m_output = nullptr;
+    qint64 m_budget = 0;
+    qint64 m_usage = 0;
+    quint64 m_frame = 0;
+    bool m_enabled = false;
+};
+
+} // namespace KWin
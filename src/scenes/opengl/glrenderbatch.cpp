@@ -0,0 +1,233 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "glrenderbatch.h"
+
+#include <kwingltexture.h>
+
+namespace KWin
+{
+
+bool GLRenderBatch::isActive() const
+{
+    return m_active;
+}
+
+void GLRenderBatch::begin()
+{
+    m_active = true;
+}
+
+int GLRenderBatch::allocate(int count)
+{
+    const int first = m_vertices.count();
+    m_vertices.resize(first + count);
+    return first;
+}
+
+GLVertex2D *GLRenderBatch::vertices(int first)
+{
+    return m_vertices.data() + first;
+}
+
+void GLRenderBatch::addDraw(const Draw &draw)
+{
+    m_draws.append(draw);
+}
+
+static bool canMerge(const GLRenderBatch::Draw &previous, const GLRenderBatch::Draw &next)
+{
+    return previous.texture == next.texture
+        && previous.traits == next.traits
+        && previous.blend == next.blend
+        && previous.saturation == next.saturation
+        && previous.modulation == next.modulation
+        && previous.modelViewProjectionMatrix == next.modelViewProjectionMatrix
+        && previous.firstVertex + previous.vertexCount == next.firstVertex;
+}
+
+void GLRenderBatch::setFrontToBack(bool frontToBack)
+{
+    m_frontToBack = frontToBack;
+}
+
+/**
+ * Keeps track of the shader, the uniforms, the texture and the blend state, so that only
+ * the state that differs between consecutive draw commands is changed.
+ */
+class GLRenderBatch::State
+{
+public:
+    ~State()
+    {
+        if (m_blend) {
+            GLState::disable(GL_BLEND);
+        }
+        if (m_shader) {
+            ShaderManager::instance()->popShader();
+        }
+    }
+
+    void apply(const Draw &draw, const QMatrix4x4 &modelViewProjectionMatrix)
+    {
+        const bool traitsChanged = !m_shader || m_current->traits != draw.traits;
+        if (traitsChanged) {
+            if (m_shader) {
+                ShaderManager::instance()->popShader();
+            }
+            m_shader = ShaderManager::instance()->pushShader(draw.traits);
+        }
+
+        if (traitsChanged || m_modelViewProjectionMatrix != modelViewProjectionMatrix) {
+            m_shader->setUniform(GLShader::ModelViewProjectionMatrix, modelViewProjectionMatrix);
+            m_modelViewProjectionMatrix = modelViewProjectionMatrix;
+        }
+        if (traitsChanged || m_current->modulation != draw.modulation) {
+            m_shader->setUniform(GLShader::ModulationConstant, draw.modulation);
+        }
+        if (traitsChanged || m_current->saturation != draw.saturation) {
+            m_shader->setUniform(GLShader::Saturation, draw.saturation);
+        }
+        if (!m_current || m_current->texture != draw.texture) {
+            draw.texture->setFilter(GL_LINEAR);
+            draw.texture->setWrapMode(GL_CLAMP_TO_EDGE);
+            draw.texture->bind();
+        }
+        if (draw.blend != m_blend) {
+            if (draw.blend) {
+                GLState::enable(GL_BLEND);
+            } else {
+                GLState::disable(GL_BLEND);
+            }
+            m_blend = draw.blend;
+        }
+
+        m_current = &draw;
+    }
+
+private:
+    GLShader *m_shader = nullptr;
+    const Draw *m_current = nullptr;
+    QMatrix4x4 m_modelViewProjectionMatrix;
+    bool m_blend = false;
+};
+
+void GLRenderBatch::flush()
+{
+    m_active = false;
+    if (m_draws.isEmpty()) {
+        m_vertices.clear();
+        return;
+    }
+
+    const GLVertexAttrib attribs[] = {
+        { VA_Position, 2, GL_FLOAT, offsetof(GLVertex2D, position) },
+        { VA_TexCoord, 2, GL_FLOAT, offsetof(GLVertex2D, texcoord) },
+    };
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setAttribLayout(attribs, 2, sizeof(GLVertex2D));
+
+    const size_t size = m_vertices.count() * sizeof(GLVertex2D);
+    GLvoid *map = vbo->map(size);
+    memcpy(map, m_vertices.constData(), size);
+    vbo->unmap();
+    vbo->bindArrays();
+
+    const GLenum primitiveType = GLVertexBuffer::supportsIndexedQuads() ? GL_QUADS : GL_TRIANGLES;
+
+    GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    if (m_frontToBack && GLRenderTarget::isDepthBufferBound()) {
+        drawFrontToBack(vbo, primitiveType);
+    } else {
+        drawInOrder(vbo, primitiveType);
+    }
+
+    vbo->unbindArrays();
+
+    m_draws.clear();
+    m_vertices.clear();
+}
+
+void GLRenderBatch::drawInOrder(GLVertexBuffer *vbo, GLenum primitiveType)
+{
+    State state;
+    for (int i = 0; i < m_draws.count();) {
+        const Draw &draw = m_draws[i];
+
+        int vertexCount = draw.vertexCount;
+        int next = i + 1;
+        while (next < m_draws.count() && canMerge(m_draws[next - 1], m_draws[next])) {
+            vertexCount += m_draws[next].vertexCount;
+            ++next;
+        }
+
+        state.apply(draw, draw.modelViewProjectionMatrix);
+        vbo->draw(primitiveType, draw.firstVertex, vertexCount);
+
+        i = next;
+    }
+}
+
+// Moves the draw command to the given depth in normalized device coordinates, regardless
+// of the z coordinate of its vertices.
+static QMatrix4x4 withDepth(const QMatrix4x4 &matrix, float depth)
+{
+    QMatrix4x4 result = matrix;
+    result.setRow(2, matrix.row(3) * depth);
+    return result;
+}
+
+void GLRenderBatch::drawFrontToBack(GLVertexBuffer *vbo, GLenum primitiveType)
+{
+    // Draw commands higher in the stacking order are closer to the viewer. The depth values
+    // are spread over the open interval (-1, 1), so none of them is clipped.
+    const int count = m_draws.count();
+    auto depthOf = [count](int index) {
+        return 1.0f - 2.0f * (index + 1) / (count + 1);
+    };
+
+    GLState::enable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    {
+        State state;
+        for (int i = count - 1; i >= 0; --i) {
+            const Draw &draw = m_draws[i];
+            if (draw.blend) {
+                continue;
+            }
+            state.apply(draw, withDepth(draw.modelViewProjectionMatrix, depthOf(i)));
+            vbo->draw(primitiveType, draw.firstVertex, draw.vertexCount);
+        }
+    }
+
+    glDepthMask(GL_FALSE);
+
+    {
+        State state;
+        for (int i = 0; i < count; ++i) {
+            const Draw &draw = m_draws[i];
+            if (!draw.blend) {
+                continue;
+            }
+            state.apply(draw, withDepth(draw.modelViewProjectionMatrix, depthOf(i)));
+            vbo->draw(primitiveType, draw.firstVertex, draw.vertexCount);
+        }
+    }
+
+    glDepthMask(GL_TRUE);
+    GLState::disable(GL_DEPTH_TEST);
+}
+
+} // namespace KWin
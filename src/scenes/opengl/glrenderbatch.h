@@ -0,0 +1,84 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglutils.h>
+
+#include <QMatrix4x4>
+#include <QVector4D>
+#include <QVector>
+
+namespace KWin
+{
+
+class GLTexture;
+
+/**
+ * The GLRenderBatch class collects the geometry of several windows and draws it at once.
+ *
+ * While the batch is active, windows append their vertices and draw commands to it instead
+ * of drawing right away. When the batch is flushed, the vertices of all windows are uploaded
+ * into the streaming vertex buffer with a single map, and consecutive draw commands that use
+ * the same texture, shader and state are merged into a single draw call.
+ *
+ * Nothing else may draw while the batch is active, otherwise the stacking order is violated.
+ *
+ * If front-to-back rendering is enabled and the current framebuffer has a depth buffer, every
+ * draw command gets a depth value according to its position in the stacking order. Opaque
+ * commands are drawn first, front-to-back with depth writes and without blending, so the GPU
+ * rejects the fragments that are hidden behind other opaque windows. Translucent commands are
+ * then drawn back-to-front, depth tested against the opaque ones.
+ */
+class GLRenderBatch
+{
+public:
+    struct Draw
+    {
+        GLTexture *texture = nullptr;
+        QMatrix4x4 modelViewProjectionMatrix;
+        QVector4D modulation;
+        float saturation = 1;
+        ShaderTraits traits;
+        bool blend = false;
+        int firstVertex = 0;
+        int vertexCount = 0;
+    };
+
+    bool isActive() const;
+    void begin();
+
+    void setFrontToBack(bool frontToBack);
+
+    /**
+     * Uploads the collected vertices, issues the collected draw commands and deactivates
+     * the batch.
+     */
+    void flush();
+
+    /**
+     * Reserves room for @a count vertices and returns the index of the first one.
+     */
+    int allocate(int count);
+    GLVertex2D *vertices(int first);
+    void addDraw(const Draw &draw);
+
+private:
+    void drawInOrder(GLVertexBuffer *vbo, GLenum primitiveType);
+    void drawFrontToBack(GLVertexBuffer *vbo, GLenum primitiveType);
+
+    class State;
+
+    QVector<GLVertex2D> m_vertices;
+    QVector<Draw> m_draws;
+    bool m_active = false;
+    bool m_frontToBack = false;
+};
+
+} // namespace KWin
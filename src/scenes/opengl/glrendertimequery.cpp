@@ -0,0 +1,134 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "glrendertimequery.h"
+
+#include <kwinglplatform.h>
+
+namespace KWin
+{
+
+// Note that libepoxy resolves the core entry points to their ARB and EXT aliases, so the
+// same code works both with GL_ARB_timer_query and GL_EXT_disjoint_timer_query.
+
+static bool hasTimerQuery()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        return hasGLExtension(QByteArrayLiteral("GL_EXT_disjoint_timer_query"));
+    }
+    return hasGLVersion(3, 3) || hasGLExtension(QByteArrayLiteral("GL_ARB_timer_query"));
+}
+
+static bool hasTimestampQuery()
+{
+    // Some GLES implementations only support GL_TIME_ELAPSED queries, in which case the
+    // number of timestamp counter bits is zero.
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    return bits > 0;
+}
+
+static bool isDisjoint()
+{
+    if (!GLPlatform::instance()->isGLES()) {
+        return false;
+    }
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    return disjoint;
+}
+
+GLRenderTimeQuery::GLRenderTimeQuery()
+{
+    if (supported()) {
+        glGenQueries(1, &m_query);
+        m_useTimestamp = hasTimestampQuery();
+    }
+}
+
+GLRenderTimeQuery::~GLRenderTimeQuery()
+{
+    if (m_query) {
+        glDeleteQueries(1, &m_query);
+    }
+}
+
+bool GLRenderTimeQuery::supported()
+{
+    return hasTimerQuery() && !GLPlatform::instance()->isSoftwareEmulation();
+}
+
+void GLRenderTimeQuery::begin()
+{
+    if (!m_query) {
+        return;
+    }
+    // Reset the disjoint flag so it only reflects the current frame.
+    isDisjoint();
+
+    m_cpuTimer.start();
+    if (m_useTimestamp) {
+        glGetInteger64v(GL_TIMESTAMP, &m_gpuBeginTimestamp);
+    } else {
+        glBeginQuery(GL_TIME_ELAPSED, m_query);
+    }
+}
+
+void GLRenderTimeQuery::end()
+{
+    if (!m_query) {
+        return;
+    }
+    if (m_useTimestamp) {
+        glQueryCounter(m_query, GL_TIMESTAMP);
+    } else {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    m_cpuTime = std::chrono::nanoseconds(m_cpuTimer.nsecsElapsed());
+    m_pending = true;
+}
+
+bool GLRenderTimeQuery::isPending() const
+{
+    return m_pending;
+}
+
+bool GLRenderTimeQuery::isResultAvailable() const
+{
+    if (!m_pending) {
+        return false;
+    }
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(m_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available == GL_TRUE;
+}
+
+std::chrono::nanoseconds GLRenderTimeQuery::result()
+{
+    if (!m_pending) {
+        return std::chrono::nanoseconds::zero();
+    }
+    m_pending = false;
+
+    GLuint64 value = 0;
+    glGetQueryObjectui64v(m_query, GL_QUERY_RESULT, &value);
+    if (isDisjoint()) {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    if (m_useTimestamp) {
+        if (value < GLuint64(m_gpuBeginTimestamp)) {
+            return std::chrono::nanoseconds::zero();
+        }
+        return std::chrono::nanoseconds(value - m_gpuBeginTimestamp);
+    }
+    return std::max(m_cpuTime, std::chrono::nanoseconds(value));
+}
+
+} // namespace KWin
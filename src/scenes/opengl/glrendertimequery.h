@@ -0,0 +1,70 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglutils.h>
+
+#include <QElapsedTimer>
+
+#include <chrono>
+
+namespace KWin
+{
+
+/**
+ * The GLRenderTimeQuery class measures how long it takes the GPU to finish rendering a frame.
+ *
+ * If GL_TIMESTAMP queries are usable, the query measures the time between begin() and the
+ * moment the GPU has executed all commands issued before end(). Otherwise, a GL_TIME_ELAPSED
+ * query is used and the result is the greater of the CPU time spent between begin() and end()
+ * and the time the GPU has been busy executing the frame.
+ *
+ * The result becomes available asynchronously, usually one frame later.
+ */
+class GLRenderTimeQuery
+{
+public:
+    GLRenderTimeQuery();
+    ~GLRenderTimeQuery();
+
+    /**
+     * Returns @c true if GPU timer queries are supported by the current OpenGL context.
+     */
+    static bool supported();
+
+    void begin();
+    void end();
+
+    /**
+     * Returns @c true if the query has been submitted and its result has not been fetched yet.
+     */
+    bool isPending() const;
+
+    /**
+     * Returns @c true if the result of the query can be fetched without stalling.
+     */
+    bool isResultAvailable() const;
+
+    /**
+     * Fetches the result of the query. If the GPU timer has been disjoint while the frame
+     * was rendered, e.g. because the GPU has been clocked down, zero is returned.
+     */
+    std::chrono::nanoseconds result();
+
+private:
+    GLuint m_query = 0;
+    GLint64 m_gpuBeginTimestamp = 0;
+    QElapsedTimer m_cpuTimer;
+    std::chrono::nanoseconds m_cpuTime = std::chrono::nanoseconds::zero();
+    bool m_pending = false;
+    bool m_useTimestamp = false;
+};
+
+} // namespace KWin
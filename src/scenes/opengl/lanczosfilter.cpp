@@ -28,7 +28,6 @@ namespace KWin
 
 LanczosFilter::LanczosFilter(Scene *parent)
     : QObject(parent)
-    , m_offscreenTex(nullptr)
     , m_offscreenTarget(nullptr)
     , m_inited(false)
     , m_shader(nullptr)
@@ -40,8 +39,7 @@ LanczosFilter::LanczosFilter(Scene *parent)
 
 LanczosFilter::~LanczosFilter()
 {
-    delete m_offscreenTarget;
-    delete m_offscreenTex;
+    GLRenderTargetPool::instance()->release(m_offscreenTarget);
 }
 
 void LanczosFilter::init()
@@ -85,22 +83,15 @@ void LanczosFilter::init()
 }
 
 
-void LanczosFilter::updateOffscreenSurfaces()
+bool LanczosFilter::updateOffscreenSurfaces()
 {
     const QSize &s = m_scene->geometry().size();
-    int w = s.width();
-    int h = s.height();
 
-    if (!m_offscreenTex || m_offscreenTex->width() != w || m_offscreenTex->height() != h) {
-        if (m_offscreenTex) {
-            delete m_offscreenTex;
-            delete m_offscreenTarget;
-        }
-        m_offscreenTex = new GLTexture(GL_RGBA8, w, h);
-        m_offscreenTex->setFilter(GL_LINEAR);
-        m_offscreenTex->setWrapMode(GL_CLAMP_TO_EDGE);
-        m_offscreenTarget = new GLRenderTarget(*m_offscreenTex);
+    if (!m_offscreenTarget || m_offscreenTarget->texture()->size() != s) {
+        GLRenderTargetPool::instance()->release(m_offscreenTarget);
+        m_offscreenTarget = GLRenderTargetPool::instance()->acquire(s);
     }
+    return m_offscreenTarget;
 }
 
 static float sinc(float x)
@@ -189,11 +180,11 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
                 if (cachedTexture->width() == tw && cachedTexture->height() == th) {
                     cachedTexture->bind();
                     if (hardwareClipping) {
-                        glEnable(GL_SCISSOR_TEST);
+                        GLState::enable(GL_SCISSOR_TEST);
                     }
 
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                    GLState::enable(GL_BLEND);
+                    GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
                     const qreal rgb = data.brightness() * data.opacity();
                     const qreal a = data.opacity();
@@ -208,9 +199,9 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
 
                     cachedTexture->render(region, textureRect, hardwareClipping);
 
-                    glDisable(GL_BLEND);
+                    GLState::disable(GL_BLEND);
                     if (hardwareClipping) {
-                        glDisable(GL_SCISSOR_TEST);
+                        GLState::disable(GL_SCISSOR_TEST);
                     }
                     cachedTexture->unbind();
                     m_timer.start(5000, this);
@@ -223,6 +214,19 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
                 }
             }
 
+            if (!updateOffscreenSurfaces()) {
+                w->sceneWindow()->performPaint(mask, region, data);
+                return;
+            }
+            // The scratch texture for the first rendering pass has the size of the window,
+            // so it can be reused while the window is being scaled
+            GLRenderTargetPool::Target *scratch = GLRenderTargetPool::instance()->acquire(QSize(sw, sh));
+            if (!scratch) {
+                w->sceneWindow()->performPaint(mask, region, data);
+                return;
+            }
+            GLTexture *offscreenTex = m_offscreenTarget->texture();
+
             WindowPaintData thumbData = data;
             thumbData.setXScale(1.0);
             thumbData.setYScale(1.0);
@@ -233,24 +237,21 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
             thumbData.setSaturation(1.0);
 
             // Bind the offscreen FBO and draw the window on it unscaled
-            updateOffscreenSurfaces();
-            GLRenderTarget::pushRenderTarget(m_offscreenTarget);
+            GLRenderTarget::pushRenderTarget(m_offscreenTarget->renderTarget());
 
             QMatrix4x4 modelViewProjectionMatrix;
-            modelViewProjectionMatrix.ortho(0, m_offscreenTex->width(), m_offscreenTex->height(), 0 , 0, 65535);
+            modelViewProjectionMatrix.ortho(0, offscreenTex->width(), offscreenTex->height(), 0 , 0, 65535);
             thumbData.setProjectionMatrix(modelViewProjectionMatrix);
 
             glClearColor(0.0, 0.0, 0.0, 0.0);
             glClear(GL_COLOR_BUFFER_BIT);
             w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
 
-            // Create a scratch texture and copy the rendered window into it
-            GLTexture tex(GL_RGBA8, sw, sh);
-            tex.setFilter(GL_LINEAR);
-            tex.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex.bind();
+            // Copy the rendered window into the scratch texture
+            GLTexture *tex = scratch->texture();
+            tex->bind();
 
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, sw, sh);
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, offscreenTex->height() - sh, sw, sh);
 
             // Set up the shader for horizontal scaling
             float dx = sw / float(tw);
@@ -281,8 +282,8 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
             vbo->render(GL_TRIANGLES);
 
             // At this point we don't need the scratch texture anymore
-            tex.unbind();
-            tex.discard();
+            tex->unbind();
+            GLRenderTargetPool::instance()->release(scratch);
 
             // create scratch texture for second rendering pass
             GLTexture tex2(GL_RGBA8, tw, sh);
@@ -290,12 +291,12 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
             tex2.setWrapMode(GL_CLAMP_TO_EDGE);
             tex2.bind();
 
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, tw, sh);
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, offscreenTex->height() - sh, tw, sh);
 
             // Set up the shader for vertical scaling
             float dy = sh / float(th);
             createKernel(dy, &kernelSize);
-            createOffsets(kernelSize, m_offscreenTex->height(), Qt::Vertical);
+            createOffsets(kernelSize, offscreenTex->height(), Qt::Vertical);
             setUniforms();
 
             // Now draw the horizontally scaled window in the FBO at the right
@@ -323,15 +324,15 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
             cache->setFilter(GL_LINEAR);
             cache->setWrapMode(GL_CLAMP_TO_EDGE);
             cache->bind();
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - th, tw, th);
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, offscreenTex->height() - th, tw, th);
             GLRenderTarget::popRenderTarget();
 
             if (hardwareClipping) {
-                glEnable(GL_SCISSOR_TEST);
+                GLState::enable(GL_SCISSOR_TEST);
             }
 
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            GLState::enable(GL_BLEND);
+            GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
             const qreal rgb = data.brightness() * data.opacity();
             const qreal a = data.opacity();
@@ -346,10 +347,10 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
 
             cache->render(region, textureRect, hardwareClipping);
 
-            glDisable(GL_BLEND);
+            GLState::disable(GL_BLEND);
 
             if (hardwareClipping) {
-                glDisable(GL_SCISSOR_TEST);
+                GLState::disable(GL_SCISSOR_TEST);
             }
 
             cache->unbind();
@@ -377,10 +378,8 @@ void LanczosFilter::timerEvent(QTimerEvent *event)
 
         m_scene->makeOpenGLContextCurrent();
 
-        delete m_offscreenTarget;
-        delete m_offscreenTex;
+        GLRenderTargetPool::instance()->release(m_offscreenTarget);
         m_offscreenTarget = nullptr;
-        m_offscreenTex = nullptr;
 
         workspace()->forEachToplevel([this](Toplevel *toplevel) {
             discardCacheTexture(toplevel->effectWindow());
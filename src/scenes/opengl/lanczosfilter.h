@@ -18,6 +18,8 @@
 #include <QVector4D>
 #include <array>
 
+#include <kwinglutils.h>
+
 namespace KWin
 {
 
@@ -25,7 +27,6 @@ class EffectWindow;
 class EffectWindowImpl;
 class WindowPaintData;
 class GLTexture;
-class GLRenderTarget;
 class GLShader;
 class Scene;
 
@@ -42,15 +43,14 @@ protected:
     void timerEvent(QTimerEvent*) override;
 private:
     void init();
-    void updateOffscreenSurfaces();
+    bool updateOffscreenSurfaces();
     void setUniforms();
     void discardCacheTexture(EffectWindow *w);
     void safeDiscardCacheTexture(EffectWindow *w);
 
     void createKernel(float delta, int *kernelSize);
     void createOffsets(int count, float width, Qt::Orientation direction);
-    GLTexture *m_offscreenTex;
-    GLRenderTarget *m_offscreenTarget;
+    GLRenderTargetPool::Target *m_offscreenTarget;
     QBasicTimer m_timer;
     bool m_inited;
     QScopedPointer<GLShader> m_shader;
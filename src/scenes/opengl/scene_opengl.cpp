@@ -12,6 +12,7 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "scene_opengl.h"
+#include "glrendertimequery.h"
 #include "openglsurfacetexture.h"
 
 #include "platform.h"
@@ -69,6 +70,24 @@ SceneOpenGL::SceneOpenGL(OpenGLBackend *backend, QObject *parent)
         glGenVertexArrays(1, &vao);
         glBindVertexArray(vao);
     }
+
+    // The layers of windows on a disabled output would never be drawn again.
+    connect(kwinApp()->platform(), &Platform::outputDisabled, this, [this](AbstractOutput *output) {
+        if (makeOpenGLContextCurrent()) {
+            m_layerCache.removeOutput(output);
+        }
+    });
+
+    // Measure render times with GPU timer queries if possible, otherwise fall back to the
+    // CPU timings recorded by the render loop.
+    m_gpuRenderTimeSupported = GLRenderTimeQuery::supported();
+
+    m_renderBatchingEnabled = qgetenv("KWIN_GL_BATCHING") != QByteArrayLiteral("0");
+
+    // Build the shaders that every frame needs up front, so the first frames don't stall.
+    if (qgetenv("KWIN_GL_SHADER_WARMUP") != QByteArrayLiteral("0")) {
+        ShaderManager::instance()->preloadShaders();
+    }
 }
 
 SceneOpenGL::~SceneOpenGL()
@@ -76,6 +95,12 @@ SceneOpenGL::~SceneOpenGL()
     if (init_ok) {
         makeOpenGLContextCurrent();
     }
+    m_layerCache.clear();
+    for (auto it = m_renderTimeQueries.constBegin(); it != m_renderTimeQueries.constEnd(); ++it) {
+        it.key()->setGpuRenderTimeEnabled(false);
+    }
+    m_renderTimeQueries.clear();
+    m_retiredRenderTimeQueries.clear();
     if (m_lanczosFilter) {
         delete m_lanczosFilter;
         m_lanczosFilter = nullptr;
@@ -157,8 +182,8 @@ void SceneOpenGL::paintCursor(AbstractOutput *output, const QRegion &rendered)
     mvp.translate(cursorPos.x(), cursorPos.y());
 
     // handle transparence
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // paint texture in cursor offset
     m_cursorTexture->bind();
@@ -166,7 +191,7 @@ void SceneOpenGL::paintCursor(AbstractOutput *output, const QRegion &rendered)
     binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
     m_cursorTexture->render(region, cursorRect);
     m_cursorTexture->unbind();
-    glDisable(GL_BLEND);
+    GLState::disable(GL_BLEND);
 }
 
 void SceneOpenGL::aboutToStartPainting(AbstractOutput *output, const QRegion &damage)
@@ -248,6 +273,17 @@ void SceneOpenGL::paint(AbstractOutput *output, const QRegion &damage, const QLi
         // prepare rendering makescontext current on the output
         repaint = m_backend->beginFrame(output);
         GLVertexBuffer::streamingBuffer()->beginFrame();
+        GLStatistics::beginFrame();
+        // With several outputs, the frame only ends once an output is painted again.
+        if (m_paintedRenderLoops.contains(renderLoop)) {
+            GLRenderTargetPool::instance()->beginFrame();
+            GLBackdrop::instance()->releaseUnused();
+            m_paintedRenderLoops.clear();
+        }
+        m_paintedRenderLoops.insert(renderLoop);
+        GLBackdrop::instance()->beginFrame();
+
+        GLRenderTimeQuery *renderTimeQuery = beginRenderTimeQuery(renderLoop);
 
         GLVertexBuffer::setVirtualScreenGeometry(geo);
         GLRenderTarget::setVirtualScreenGeometry(geo);
@@ -260,6 +296,9 @@ void SceneOpenGL::paint(AbstractOutput *output, const QRegion &damage, const QLi
                     renderLoop, projectionMatrix());   // call generic implementation
         paintCursor(output, valid);
 
+        if (renderTimeQuery) {
+            renderTimeQuery->end();
+        }
         renderLoop->endFrame();
 
         GLVertexBuffer::streamingBuffer()->endOfFrame();
@@ -270,6 +309,55 @@ void SceneOpenGL::paint(AbstractOutput *output, const QRegion &damage, const QLi
     clearStackingOrder();
 }
 
+GLRenderTimeQuery *SceneOpenGL::beginRenderTimeQuery(RenderLoop *renderLoop)
+{
+    if (!m_gpuRenderTimeSupported) {
+        return nullptr;
+    }
+
+    auto it = m_renderTimeQueries.find(renderLoop);
+    if (it == m_renderTimeQueries.end()) {
+        it = m_renderTimeQueries.insert(renderLoop, {});
+        connect(renderLoop, &QObject::destroyed, this, [this, renderLoop]() {
+            // The queries can only be deleted while the context is current, if it can't be
+            // made current they are kept until the scene is torn down.
+            if (makeOpenGLContextCurrent()) {
+                m_renderTimeQueries.remove(renderLoop);
+            } else {
+                m_retiredRenderTimeQueries += m_renderTimeQueries.take(renderLoop);
+            }
+        });
+        renderLoop->setGpuRenderTimeEnabled(true);
+    }
+
+    // The results of previous frames are collected without stalling the pipeline, if a
+    // result is not available yet, it will be picked up during one of the next frames.
+    GLRenderTimeQuery *idleQuery = nullptr;
+    for (const QSharedPointer<GLRenderTimeQuery> &query : qAsConst(*it)) {
+        if (query->isResultAvailable()) {
+            const std::chrono::nanoseconds renderTime = query->result();
+            if (renderTime != std::chrono::nanoseconds::zero()) {
+                renderLoop->addGpuRenderTime(renderTime);
+            }
+        }
+        if (!idleQuery && !query->isPending()) {
+            idleQuery = query.data();
+        }
+    }
+
+    if (!idleQuery) {
+        // If the GPU is more than a few frames behind, skip measuring this frame.
+        if (it->count() >= 3) {
+            return nullptr;
+        }
+        it->append(QSharedPointer<GLRenderTimeQuery>::create());
+        idleQuery = it->last().data();
+    }
+
+    idleQuery->begin();
+    return idleQuery;
+}
+
 QMatrix4x4 SceneOpenGL::transformation(int mask, const ScreenPaintData &data) const
 {
     QMatrix4x4 matrix;
@@ -296,6 +384,7 @@ QMatrix4x4 SceneOpenGL::transformation(int mask, const ScreenPaintData &data) co
 
 void SceneOpenGL::paintBackground(const QRegion &region)
 {
+    GLBackdrop::instance()->invalidate(region);
     if (region == infiniteRegion()) {
         glClearColor(0, 0, 0, 1);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -346,10 +435,10 @@ void SceneOpenGL::extendPaintRegion(QRegion &region, bool opaqueFullscreen)
 void SceneOpenGL::paintDesktop(int desktop, int mask, const QRegion &region, ScreenPaintData &data)
 {
     const QRect r = region.boundingRect();
-    glEnable(GL_SCISSOR_TEST);
-    glScissor(r.x(), geometry().size().height() - r.y() - r.height(), r.width(), r.height());
+    GLState::enable(GL_SCISSOR_TEST);
+    GLState::scissor(r.x(), geometry().size().height() - r.y() - r.height(), r.width(), r.height());
     KWin::Scene::paintDesktop(desktop, mask, region, data);
-    glDisable(GL_SCISSOR_TEST);
+    GLState::disable(GL_SCISSOR_TEST);
 }
 
 void SceneOpenGL::paintOffscreenQuickView(OffscreenQuickView *w)
@@ -361,17 +450,18 @@ void SceneOpenGL::paintOffscreenQuickView(OffscreenQuickView *w)
     if (!t) {
         return;
     }
+    GLBackdrop::instance()->invalidate(rect);
 
     QMatrix4x4 mvp(projectionMatrix());
     mvp.translate(rect.x(), rect.y());
     shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     t->bind();
     t->render(QRegion(infiniteRegion()), w->geometry());
     t->unbind();
-    glDisable(GL_BLEND);
+    GLState::disable(GL_BLEND);
 
     ShaderManager::instance()->popShader();
 }
@@ -463,11 +553,49 @@ void SceneOpenGL::updateProjectionMatrix(const QRect &rect)
     m_projectionMatrix = Scene::createProjectionMatrix(rect);
 }
 
+qreal SceneOpenGL::renderTargetScale() const
+{
+    return painted_screen ? painted_screen->scale() : 1;
+}
+
+void SceneOpenGL::updateLayerCache()
+{
+    m_layerCache.setEnabled(options->isWindowLayerCaching());
+    if (!m_layerCache.isEnabled()) {
+        return;
+    }
+    m_layerCache.setBudget(qint64(options->windowLayerCacheBudget()) << 20);
+    m_layerCache.beginFrame(painted_screen);
+
+    // This must run before the repaints of the items are reset for the current frame.
+    for (Window *window : qAsConst(stacking_order)) {
+        const OpenGLWindow *glWindow = static_cast<OpenGLWindow *>(window);
+        if (window->windowItem()->hasSubtreeRepaints(painted_screen)) {
+            m_layerCache.markDirty(glWindow);
+        } else {
+            m_layerCache.markClean(glWindow);
+        }
+    }
+}
+
 void SceneOpenGL::paintSimpleScreen(int mask, const QRegion &region)
 {
     m_screenProjectionMatrix = m_projectionMatrix;
+    updateLayerCache();
+
+    // Effects may draw between windows, so the windows can be drawn in a batch only if no
+    // effect takes part in painting this frame.
+    const bool batch = m_renderBatchingEnabled && !static_cast<EffectsHandlerImpl *>(effects)->hasActiveEffects();
+    if (batch) {
+        m_renderBatch.setFrontToBack(options->isFrontToBackRendering());
+        m_renderBatch.begin();
+    }
 
     Scene::paintSimpleScreen(mask, region);
+
+    if (batch) {
+        m_renderBatch.flush();
+    }
 }
 
 void SceneOpenGL::paintGenericScreen(int mask, const ScreenPaintData &data)
@@ -475,6 +603,7 @@ void SceneOpenGL::paintGenericScreen(int mask, const ScreenPaintData &data)
     const QMatrix4x4 screenMatrix = transformation(mask, data);
 
     m_screenProjectionMatrix = m_projectionMatrix * screenMatrix;
+    updateLayerCache();
 
     Scene::paintGenericScreen(mask, data);
 }
@@ -507,6 +636,13 @@ void SceneOpenGL::finalDrawWindow(EffectWindowImpl* w, int mask, const QRegion &
 
 void SceneOpenGL::performPaintWindow(EffectWindowImpl* w, int mask, const QRegion &region, WindowPaintData& data)
 {
+    // A transformed window can end up anywhere on the screen
+    if (mask & (PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_TRANSFORMED)) {
+        GLBackdrop::instance()->invalidate(infiniteRegion());
+    } else {
+        GLBackdrop::instance()->invalidate(w->expandedGeometry());
+    }
+
     if (mask & PAINT_WINDOW_LANCZOS) {
         if (!m_lanczosFilter) {
             m_lanczosFilter = new LanczosFilter(this);
@@ -528,6 +664,10 @@ OpenGLWindow::OpenGLWindow(Toplevel *toplevel, SceneOpenGL *scene)
 
 OpenGLWindow::~OpenGLWindow()
 {
+    if (m_scene->layerCache()->isEnabled()) {
+        m_scene->makeOpenGLContextCurrent();
+        m_scene->layerCache()->remove(this);
+    }
 }
 
 QVector4D OpenGLWindow::modulate(float opacity, float brightness) const
@@ -538,16 +678,6 @@ QVector4D OpenGLWindow::modulate(float opacity, float brightness) const
     return QVector4D(rgb, rgb, rgb, a);
 }
 
-void OpenGLWindow::setBlendEnabled(bool enabled)
-{
-    if (enabled && !m_blendingEnabled)
-        glEnable(GL_BLEND);
-    else if (!enabled && m_blendingEnabled)
-        glDisable(GL_BLEND);
-
-    m_blendingEnabled = enabled;
-}
-
 static GLTexture *bindSurfaceTexture(SurfaceItem *surfaceItem)
 {
     SurfacePixmap *surfacePixmap = surfaceItem->pixmap();
@@ -577,29 +707,29 @@ static GLTexture *bindSurfaceTexture(SurfaceItem *surfaceItem)
     return platformSurfaceTexture->texture();
 }
 
-static WindowQuadList clipQuads(const Item *item, const OpenGLWindow::RenderContext *context)
+static WindowQuadArray clipQuads(const Item *item, const OpenGLWindow::RenderContext *context)
 {
-    const WindowQuadList quads = item->quads();
+    const WindowQuadArray quads = item->quads();
     if (context->clip != infiniteRegion() && !context->hardwareClipping) {
         const QPoint offset = context->transforms.top().map(QPoint(0, 0));
 
-        WindowQuadList ret;
+        WindowQuadArray ret;
         ret.reserve(quads.count());
 
         // split all quads in bounding rect with the actual rects in the region
-        for (const WindowQuad &quad : qAsConst(quads)) {
+        for (int i = 0; i < quads.count(); ++i) {
+            const QRectF quadRect = quads.boundingRect(i);
             for (const QRect &r : qAsConst(context->clip)) {
                 const QRectF rf(r.translated(-offset));
-                const QRectF quadRect(QPointF(quad.left(), quad.top()), QPointF(quad.right(), quad.bottom()));
                 const QRectF &intersected = rf.intersected(quadRect);
                 if (intersected.isValid()) {
                     if (quadRect == intersected) {
                         // case 1: completely contains, include and do not check other rects
-                        ret << quad;
+                        ret.append(quads, i);
                         break;
                     }
                     // case 2: intersection
-                    ret << quad.makeSubQuad(intersected.left(), intersected.top(), intersected.right(), intersected.bottom());
+                    ret.appendSubQuad(quads, i, intersected.left(), intersected.top(), intersected.right(), intersected.bottom());
                 }
             }
         }
@@ -612,10 +742,8 @@ void OpenGLWindow::createRenderNode(Item *item, RenderContext *context)
 {
     const QList<Item *> sortedChildItems = item->sortedChildItems();
 
-    QMatrix4x4 matrix;
-    matrix.translate(item->position().x(), item->position().y());
-    matrix *= item->transform();
-    context->transforms.push(context->transforms.top() * matrix);
+    // The window item is the root item, so the world transform is relative to the window.
+    context->transforms.push(item->worldTransform());
 
     for (Item *childItem : sortedChildItems) {
         if (childItem->z() >= 0) {
@@ -628,7 +756,7 @@ void OpenGLWindow::createRenderNode(Item *item, RenderContext *context)
 
     item->preprocess();
     if (auto shadowItem = qobject_cast<ShadowItem *>(item)) {
-        WindowQuadList quads = clipQuads(item, context);
+        WindowQuadArray quads = clipQuads(item, context);
         if (!quads.isEmpty()) {
             SceneOpenGLShadow *shadow = static_cast<SceneOpenGLShadow *>(shadowItem->shadow());
             context->renderNodes.append(RenderNode{
@@ -641,7 +769,7 @@ void OpenGLWindow::createRenderNode(Item *item, RenderContext *context)
             });
         }
     } else if (auto decorationItem = qobject_cast<DecorationItem *>(item)) {
-        WindowQuadList quads = clipQuads(item, context);
+        WindowQuadArray quads = clipQuads(item, context);
         if (!quads.isEmpty()) {
             auto renderer = static_cast<const SceneOpenGLDecorationRenderer *>(decorationItem->renderer());
             context->renderNodes.append(RenderNode{
@@ -654,7 +782,7 @@ void OpenGLWindow::createRenderNode(Item *item, RenderContext *context)
             });
         }
     } else if (auto surfaceItem = qobject_cast<SurfaceItem *>(item)) {
-        WindowQuadList quads = clipQuads(item, context);
+        WindowQuadArray quads = clipQuads(item, context);
         if (!quads.isEmpty()) {
             SurfacePixmap *pixmap = surfaceItem->pixmap();
             if (pixmap) {
@@ -733,6 +861,112 @@ static QMatrix4x4 transformForPaintData(int mask, const WindowPaintData &data)
     return matrix;
 }
 
+static bool isTranslation(const QMatrix4x4 &matrix)
+{
+    QMatrix4x4 translation;
+    translation.translate(matrix(0, 3), matrix(1, 3));
+    return matrix == translation;
+}
+
+// Returns whether the window is painted as is, so a flattened copy of it looks the same.
+static bool isUntouched(int mask, const WindowPaintData &data)
+{
+    return !(mask & (Scene::PAINT_WINDOW_TRANSFORMED | Scene::PAINT_SCREEN_TRANSFORMED))
+        && !data.shader
+        && data.opacity() == 1.0
+        && data.brightness() == 1.0
+        && data.saturation() == 1.0
+        && data.crossFadeProgress() == 1.0;
+}
+
+const GLLayerCache::Layer *OpenGLWindow::cachedLayer(int mask, const WindowPaintData &data)
+{
+    GLLayerCache *layerCache = m_scene->layerCache();
+    if (!layerCache->isEnabled()) {
+        return nullptr;
+    }
+    if (!isUntouched(mask, data)) {
+        // The window is animated, flattening it would only waste memory.
+        layerCache->markDirty(this);
+        return nullptr;
+    }
+    if (const GLLayerCache::Layer *layer = layerCache->layer(this, m_scene->renderTargetScale())) {
+        return layer;
+    }
+    if (!layerCache->isIdle(this)) {
+        return nullptr;
+    }
+    return flattenLayer(data);
+}
+
+const GLLayerCache::Layer *OpenGLWindow::flattenLayer(const WindowPaintData &data)
+{
+    GLLayerCache *layerCache = m_scene->layerCache();
+
+    RenderContext renderContext {
+        .clip = infiniteRegion(),
+        .paintData = data,
+        .hardwareClipping = false,
+    };
+    renderContext.transforms.push(QMatrix4x4());
+    createRenderNode(windowItem(), &renderContext);
+
+    // A window that is drawn with a single draw call already has nothing to gain.
+    if (renderContext.renderNodes.count() < 2) {
+        layerCache->markUncacheable(this);
+        return nullptr;
+    }
+
+    QRectF boundingRect;
+    QRegion coverage;
+    bool hasAlpha = false;
+    for (const RenderNode &renderNode : qAsConst(renderContext.renderNodes)) {
+        for (int i = 0; i < renderNode.quads.count(); ++i) {
+            const QRectF rect = renderNode.transformMatrix.mapRect(renderNode.quads.boundingRect(i));
+            boundingRect |= rect;
+            coverage += rect.toAlignedRect();
+        }
+        hasAlpha |= renderNode.hasAlpha;
+    }
+
+    const QRect geometry = boundingRect.toAlignedRect();
+    GLLayerCache::Layer *layer = layerCache->createLayer(this, geometry, m_scene->renderTargetScale());
+    if (!layer) {
+        layerCache->markUncacheable(this);
+        return nullptr;
+    }
+    // The parts of the layer that no item covers stay transparent.
+    layer->hasAlpha = hasAlpha || coverage != QRegion(geometry);
+
+    GLRenderTarget renderTarget(*layer->texture);
+    if (!renderTarget.valid()) {
+        layerCache->markUncacheable(this);
+        return nullptr;
+    }
+
+    const bool scissorTest = GLState::isEnabled(GL_SCISSOR_TEST);
+    if (scissorTest) {
+        GLState::disable(GL_SCISSOR_TEST);
+    }
+
+    GLRenderTarget::pushRenderTarget(&renderTarget);
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+
+    QMatrix4x4 projection;
+    projection.ortho(geometry);
+    renderNodes(&renderContext, infiniteRegion(), projection, ShaderTrait::MapTexture);
+
+    GLRenderTarget::popRenderTarget();
+
+    if (scissorTest) {
+        GLState::enable(GL_SCISSOR_TEST);
+    }
+
+    return layer;
+}
+
 void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPaintData &data)
 {
     if (region.isEmpty()) {
@@ -749,7 +983,34 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
 
     windowItem()->setTransform(transformForPaintData(mask, data));
 
-    createRenderNode(windowItem(), &renderContext);
+    if (const GLLayerCache::Layer *layer = cachedLayer(mask, data)) {
+        // The layer is in global coordinates, so only the painted region of it is drawn.
+        const QRectF geometry = layer->geometry;
+        auto vertex = [&geometry](qreal x, qreal y) {
+            return WindowVertex(x, y, (x - geometry.x()) / geometry.width(), (y - geometry.y()) / geometry.height());
+        };
+
+        WindowQuadArray quads;
+        for (const QRect &rect : region & layer->geometry) {
+            const QRectF r(rect);
+            WindowQuad quad;
+            quad[0] = vertex(r.left(), r.top());
+            quad[1] = vertex(r.right(), r.top());
+            quad[2] = vertex(r.right(), r.bottom());
+            quad[3] = vertex(r.left(), r.bottom());
+            quads << quad;
+        }
+        renderContext.renderNodes.append(RenderNode{
+            .texture = layer->texture.get(),
+            .quads = quads,
+            .transformMatrix = QMatrix4x4(),
+            .opacity = 1.0,
+            .hasAlpha = layer->hasAlpha,
+            .coordinateType = NormalizedCoordinates,
+        });
+    } else {
+        createRenderNode(windowItem(), &renderContext);
+    }
 
     int quadCount = 0;
     for (const RenderNode &node : qAsConst(renderContext.renderNodes)) {
@@ -759,27 +1020,85 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
         return;
     }
 
-    GLShader *shader = data.shader;
-    if (!shader) {
-        ShaderTraits traits = ShaderTrait::MapTexture;
+    ShaderTraits traits = ShaderTrait::MapTexture;
 
-        if (data.opacity() != 1.0 || data.brightness() != 1.0 || data.crossFadeProgress() != 1.0)
-            traits |= ShaderTrait::Modulate;
+    if (data.opacity() != 1.0 || data.brightness() != 1.0 || data.crossFadeProgress() != 1.0)
+        traits |= ShaderTrait::Modulate;
 
-        if (data.saturation() != 1.0)
-            traits |= ShaderTrait::AdjustSaturation;
+    if (data.saturation() != 1.0)
+        traits |= ShaderTrait::AdjustSaturation;
 
-        shader = ShaderManager::instance()->pushShader(traits);
+    const QMatrix4x4 modelViewProjection = modelViewProjectionMatrix(mask, data);
+
+    GLRenderBatch *batch = m_scene->renderBatch();
+    if (batch->isActive() && !data.shader && !renderContext.hardwareClipping) {
+        const bool indexedQuads = GLVertexBuffer::supportsIndexedQuads();
+        const GLenum primitiveType = indexedQuads ? GL_QUADS : GL_TRIANGLES;
+        const int verticesPerQuad = indexedQuads ? 4 : 6;
+
+        for (const RenderNode &renderNode : qAsConst(renderContext.renderNodes)) {
+            if (renderNode.quads.isEmpty() || !renderNode.texture)
+                continue;
+
+            const int vertexCount = renderNode.quads.count() * verticesPerQuad;
+            const int firstVertex = batch->allocate(vertexCount);
+            GLVertex2D *vertices = batch->vertices(firstVertex);
+            renderNode.quads.makeInterleavedArrays(primitiveType, vertices, renderNode.texture->matrix(renderNode.coordinateType));
+
+            // Move translations into the vertices, so the nodes of different items and windows
+            // share the same matrix and can be drawn together.
+            QMatrix4x4 matrix = modelViewProjection * renderNode.transformMatrix;
+            if (isTranslation(renderNode.transformMatrix)) {
+                const QVector2D offset(renderNode.transformMatrix(0, 3), renderNode.transformMatrix(1, 3));
+                for (int i = 0; i < vertexCount; ++i) {
+                    vertices[i].position += offset;
+                }
+                matrix = modelViewProjection;
+            }
+
+            batch->addDraw(GLRenderBatch::Draw{
+                .texture = renderNode.texture,
+                .modelViewProjectionMatrix = matrix,
+                .modulation = modulate(renderNode.opacity, data.brightness()),
+                .saturation = float(data.saturation()),
+                .traits = traits,
+                .blend = renderNode.hasAlpha || renderNode.opacity < 1.0,
+                .firstVertex = firstVertex,
+                .vertexCount = vertexCount,
+            });
+        }
+        return;
+    }
+
+    renderNodes(&renderContext, region, modelViewProjection, traits);
+}
+
+void OpenGLWindow::renderNodes(RenderContext *context, const QRegion &region, const QMatrix4x4 &modelViewProjection, ShaderTraits traits)
+{
+    const WindowPaintData &data = context->paintData;
+
+    int quadCount = 0;
+    for (const RenderNode &node : qAsConst(context->renderNodes)) {
+        quadCount += node.quads.count();
+    }
+    if (!quadCount) {
+        return;
     }
-    shader->setUniform(GLShader::Saturation, data.saturation());
 
     const bool indexedQuads = GLVertexBuffer::supportsIndexedQuads();
     const GLenum primitiveType = indexedQuads ? GL_QUADS : GL_TRIANGLES;
     const int verticesPerQuad = indexedQuads ? 4 : 6;
+
+    GLShader *shader = data.shader;
+    if (!shader) {
+        shader = ShaderManager::instance()->pushShader(traits);
+    }
+    shader->setUniform(GLShader::Saturation, data.saturation());
+
     const size_t size = verticesPerQuad * quadCount * sizeof(GLVertex2D);
 
-    if (renderContext.hardwareClipping) {
-        glEnable(GL_SCISSOR_TEST);
+    if (context->hardwareClipping) {
+        GLState::enable(GL_SCISSOR_TEST);
     }
 
     const GLVertexAttrib attribs[] = {
@@ -793,8 +1112,8 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
 
     GLVertex2D *map = (GLVertex2D *) vbo->map(size);
 
-    for (int i = 0, v = 0; i < renderContext.renderNodes.count(); i++) {
-        RenderNode &renderNode = renderContext.renderNodes[i];
+    for (int i = 0, v = 0; i < context->renderNodes.count(); i++) {
+        RenderNode &renderNode = context->renderNodes[i];
         if (renderNode.quads.isEmpty() || !renderNode.texture)
             continue;
 
@@ -811,17 +1130,16 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
     vbo->bindArrays();
 
     // Make sure the blend function is set up correctly in case we will be doing blending
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     float opacity = -1.0;
 
-    const QMatrix4x4 modelViewProjection = modelViewProjectionMatrix(mask, data);
-    for (int i = 0; i < renderContext.renderNodes.count(); i++) {
-        const RenderNode &renderNode = renderContext.renderNodes[i];
+    for (int i = 0; i < context->renderNodes.count(); i++) {
+        const RenderNode &renderNode = context->renderNodes[i];
         if (renderNode.vertexCount == 0)
             continue;
 
-        setBlendEnabled(renderNode.hasAlpha || renderNode.opacity < 1.0);
+        GLState::setEnabled(GL_BLEND, renderNode.hasAlpha || renderNode.opacity < 1.0);
 
         shader->setUniform(GLShader::ModelViewProjectionMatrix,
                            modelViewProjection * renderNode.transformMatrix);
@@ -836,18 +1154,18 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
         renderNode.texture->bind();
 
         vbo->draw(region, primitiveType, renderNode.firstVertex,
-                  renderNode.vertexCount, renderContext.hardwareClipping);
+                  renderNode.vertexCount, context->hardwareClipping);
     }
 
     vbo->unbindArrays();
 
-    setBlendEnabled(false);
+    GLState::disable(GL_BLEND);
 
     if (!data.shader)
         ShaderManager::instance()->popShader();
 
-    if (renderContext.hardwareClipping) {
-        glDisable(GL_SCISSOR_TEST);
+    if (context->hardwareClipping) {
+        GLState::disable(GL_SCISSOR_TEST);
     }
 }
 
@@ -946,6 +1264,7 @@ void SceneOpenGL::EffectFrame::render(const QRegion &_region, double opacity, do
 
     Q_UNUSED(_region);
     const QRegion region = infiniteRegion(); // TODO: Old region doesn't seem to work with OpenGL
+    GLBackdrop::instance()->invalidate(region);
 
     GLShader* shader = m_effectFrame->shader();
     if (!shader) {
@@ -960,8 +1279,8 @@ void SceneOpenGL::EffectFrame::render(const QRegion &_region, double opacity, do
     }
     const QMatrix4x4 projection = m_scene->projectionMatrix();
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Render the actual frame
     if (m_effectFrame->style() == EffectFrameUnstyled) {
@@ -1124,11 +1443,11 @@ void SceneOpenGL::EffectFrame::render(const QRegion &_region, double opacity, do
             QMatrix4x4 mvp(projection);
             mvp.translate(m_effectFrame->selection().x(), m_effectFrame->selection().y());
             shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            GLState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
             m_selectionTexture->bind();
             m_selectionTexture->render(region, m_effectFrame->selection());
             m_selectionTexture->unbind();
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         }
     }
 
@@ -1206,7 +1525,7 @@ void SceneOpenGL::EffectFrame::render(const QRegion &_region, double opacity, do
     if (shader) {
         ShaderManager::instance()->popShader();
     }
-    glDisable(GL_BLEND);
+    GLState::disable(GL_BLEND);
 }
 
 void SceneOpenGL::EffectFrame::updateTexture()
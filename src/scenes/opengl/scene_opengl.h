@@ -14,13 +14,18 @@
 #include "openglbackend.h"
 
 #include "decorationitem.h"
+#include "gllayercache.h"
+#include "glrenderbatch.h"
 #include "scene.h"
 #include "shadow.h"
 
 #include "kwinglutils.h"
 
+#include <QSet>
+
 namespace KWin
 {
+class GLRenderTimeQuery;
 class LanczosFilter;
 class OpenGLBackend;
 
@@ -55,6 +60,9 @@ public:
 
     QMatrix4x4 projectionMatrix() const { return m_projectionMatrix; }
     QMatrix4x4 screenProjectionMatrix() const override { return m_screenProjectionMatrix; }
+    GLRenderBatch *renderBatch() { return &m_renderBatch; }
+    GLLayerCache *layerCache() { return &m_layerCache; }
+    qreal renderTargetScale() const;
 
     static SceneOpenGL *createScene(OpenGLBackend *backend, QObject *parent);
     static bool supported(OpenGLBackend *backend);
@@ -76,7 +84,9 @@ protected:
 private:
     void doPaintBackground(const QVector< float >& vertices);
     void updateProjectionMatrix(const QRect &geometry);
+    void updateLayerCache();
     void performPaintWindow(EffectWindowImpl* w, int mask, const QRegion &region, WindowPaintData& data);
+    GLRenderTimeQuery *beginRenderTimeQuery(RenderLoop *renderLoop);
 
     bool init_ok = true;
     OpenGLBackend *m_backend;
@@ -86,6 +96,13 @@ private:
     QMatrix4x4 m_projectionMatrix;
     QMatrix4x4 m_screenProjectionMatrix;
     GLuint vao = 0;
+    bool m_gpuRenderTimeSupported = false;
+    bool m_renderBatchingEnabled = true;
+    GLRenderBatch m_renderBatch;
+    GLLayerCache m_layerCache;
+    QHash<RenderLoop *, QVector<QSharedPointer<GLRenderTimeQuery>>> m_renderTimeQueries;
+    QVector<QSharedPointer<GLRenderTimeQuery>> m_retiredRenderTimeQueries;
+    QSet<RenderLoop *> m_paintedRenderLoops;
 };
 
 class OpenGLWindow final : public Scene::Window
@@ -96,7 +113,7 @@ public:
     struct RenderNode
     {
         GLTexture *texture = nullptr;
-        WindowQuadList quads;
+        WindowQuadArray quads;
         QMatrix4x4 transformMatrix;
         int firstVertex = 0;
         int vertexCount = 0;
@@ -122,11 +139,12 @@ public:
 private:
     QMatrix4x4 modelViewProjectionMatrix(int mask, const WindowPaintData &data) const;
     QVector4D modulate(float opacity, float brightness) const;
-    void setBlendEnabled(bool enabled);
     void createRenderNode(Item *item, RenderContext *context);
+    void renderNodes(RenderContext *context, const QRegion &region, const QMatrix4x4 &modelViewProjection, ShaderTraits traits);
+    const GLLayerCache::Layer *cachedLayer(int mask, const WindowPaintData &data);
+    const GLLayerCache::Layer *flattenLayer(const WindowPaintData &data);
 
     SceneOpenGL *m_scene;
-    bool m_blendingEnabled = false;
 };
 
 class SceneOpenGL::EffectFrame
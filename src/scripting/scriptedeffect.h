@@ -63,6 +63,10 @@ public:
     int requestedEffectChainPosition() const override {
         return m_chainPosition;
     }
+    bool declaresWindowInterest() const override {
+        // Scripts can only touch windows by animating them
+        return true;
+    }
     QString activeConfig() const;
     void setActiveConfig(const QString &name);
     static ScriptedEffect *create(const QString &effectName, const QString &pathToScript, int chainPosition);
@@ -29,7 +29,7 @@ public:
     Shadow *shadow() const;
 
 protected:
-    WindowQuadList buildQuads() const override;
+    WindowQuadArray buildQuads() const override;
 
 private Q_SLOTS:
     void handleTextureChanged();
@@ -53,7 +53,8 @@ void SurfaceItem::addDamage(const QRegion &region)
     m_damage += region;
     scheduleRepaint(region);
 
-    Q_EMIT m_window->damaged(m_window, region);
+    // The damage is reported relative to the frame geometry of the window
+    Q_EMIT m_window->damaged(m_window, mapToGlobal(region).translated(-m_window->pos()));
 }
 
 void SurfaceItem::resetDamage()
@@ -135,11 +136,11 @@ void SurfaceItem::preprocess()
     updatePixmap();
 }
 
-WindowQuadList SurfaceItem::buildQuads() const
+WindowQuadArray SurfaceItem::buildQuads() const
 {
     const QRegion region = shape();
 
-    WindowQuadList quads;
+    WindowQuadArray quads;
     quads.reserve(region.rectCount());
 
     for (const QRectF rect : region) {
@@ -49,7 +49,7 @@ protected:
 
     virtual SurfacePixmap *createPixmap() = 0;
     void preprocess() override;
-    WindowQuadList buildQuads() const override;
+    WindowQuadArray buildQuads() const override;
 
     void handleWindowClosed(Toplevel *original, Deleted *deleted);
 
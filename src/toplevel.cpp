@@ -278,6 +278,9 @@ bool Toplevel::setupCompositing()
     updateShadow();
     Compositor::self()->scene()->addToplevel(this);
 
+    connect(this, &Toplevel::readyForPaintingChanged,
+            Compositor::self(), &Compositor::invalidateWindowsToRender, Qt::UniqueConnection);
+
     connect(windowItem(), &WindowItem::positionChanged, this, &Toplevel::visibleGeometryChanged);
     connect(windowItem(), &WindowItem::boundingRectChanged, this, &Toplevel::visibleGeometryChanged);
 
@@ -360,6 +363,7 @@ void Toplevel::setReadyForPainting()
 {
     if (!ready_for_painting) {
         ready_for_painting = true;
+        Q_EMIT readyForPaintingChanged();
         if (Compositor::compositing()) {
             addRepaintFull();
             Q_EMIT windowShown(this);
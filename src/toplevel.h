@@ -578,6 +578,10 @@ Q_SIGNALS:
     void windowClosed(KWin::Toplevel* toplevel, KWin::Deleted* deleted);
     void windowShown(KWin::Toplevel* toplevel);
     void windowHidden(KWin::Toplevel* toplevel);
+    /**
+     * This signal is emitted when the window becomes ready for painting.
+     */
+    void readyForPaintingChanged();
     /**
      * Signal emitted when the window's shape state changed. That is if it did not have a shape
      * and received one or if the shape was withdrawn. Think of Chromium enabling/disabling KWin's
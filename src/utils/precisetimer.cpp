@@ -0,0 +1,121 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "precisetimer.h"
+#include "common.h"
+
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace KWin
+{
+
+PreciseTimer::PreciseTimer(QObject *parent)
+    : QObject(parent)
+{
+    m_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (m_fd != -1) {
+        m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, &PreciseTimer::handleTimerExpired);
+    } else {
+        qCWarning(KWIN_CORE, "Failed to create a timerfd, falling back to QTimer: %s", strerror(errno));
+        m_fallbackTimer.setSingleShot(true);
+        m_fallbackTimer.setTimerType(Qt::PreciseTimer);
+        connect(&m_fallbackTimer, &QTimer::timeout, this, &PreciseTimer::handleTimerExpired);
+    }
+}
+
+PreciseTimer::~PreciseTimer()
+{
+    if (m_fd != -1) {
+        close(m_fd);
+    }
+}
+
+void PreciseTimer::start(std::chrono::nanoseconds deadline)
+{
+    m_deadline = deadline;
+    m_active = true;
+
+    if (m_fd == -1) {
+        const std::chrono::nanoseconds currentTime(std::chrono::steady_clock::now().time_since_epoch());
+        const std::chrono::nanoseconds interval = std::max(deadline - currentTime, std::chrono::nanoseconds::zero());
+        m_fallbackTimer.start(std::chrono::ceil<std::chrono::milliseconds>(interval));
+        return;
+    }
+
+    // An all-zero it_value disarms the timer, so a deadline at the epoch is bumped by 1ns.
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(deadline);
+    itimerspec spec = {};
+    spec.it_value.tv_sec = seconds.count();
+    spec.it_value.tv_nsec = (deadline - seconds).count();
+    if (spec.it_value.tv_sec <= 0 && spec.it_value.tv_nsec <= 0) {
+        spec.it_value.tv_sec = 0;
+        spec.it_value.tv_nsec = 1;
+    }
+
+    if (timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+        qCWarning(KWIN_CORE, "Failed to arm a timerfd: %s", strerror(errno));
+        m_active = false;
+    }
+}
+
+void PreciseTimer::stop()
+{
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    m_deadline = std::chrono::nanoseconds::zero();
+
+    if (m_fd == -1) {
+        m_fallbackTimer.stop();
+        return;
+    }
+
+    const itimerspec spec = {};
+    timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+    // Drain the expiration counter in case the timer has expired, but the socket notifier
+    // hasn't been activated yet.
+    uint64_t expirationCount;
+    read(m_fd, &expirationCount, sizeof(expirationCount));
+}
+
+bool PreciseTimer::isActive() const
+{
+    return m_active;
+}
+
+std::chrono::nanoseconds PreciseTimer::deadline() const
+{
+    return m_active ? m_deadline : std::chrono::nanoseconds::zero();
+}
+
+void PreciseTimer::handleTimerExpired()
+{
+    if (m_fd != -1) {
+        uint64_t expirationCount;
+        if (read(m_fd, &expirationCount, sizeof(expirationCount)) != sizeof(expirationCount)) {
+            return;
+        }
+    }
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    m_deadline = std::chrono::nanoseconds::zero();
+    Q_EMIT timeout();
+}
+
+} // namespace KWin
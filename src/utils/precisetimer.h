@@ -0,0 +1,76 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+
+class QSocketNotifier;
+
+namespace KWin
+{
+
+/**
+ * The PreciseTimer class provides a single-shot timer that fires at an absolute point in
+ * time on the monotonic clock.
+ *
+ * Unlike QTimer, the deadline is not rounded to milliseconds and no timer slack is applied,
+ * which makes the PreciseTimer suitable for scheduling compositing cycles. The timer is
+ * backed by a timerfd; if one cannot be created, the timer falls back to a QTimer with
+ * Qt::PreciseTimer accuracy.
+ */
+class KWIN_EXPORT PreciseTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PreciseTimer(QObject *parent = nullptr);
+    ~PreciseTimer() override;
+
+    /**
+     * Starts or restarts the timer so it fires at @a deadline. The @a deadline is specified
+     * in the CLOCK_MONOTONIC time base, i.e. the same as std::chrono::steady_clock. If the
+     * @a deadline is in the past, the timer fires as soon as the event loop gets control.
+     */
+    void start(std::chrono::nanoseconds deadline);
+
+    /**
+     * Stops the timer.
+     */
+    void stop();
+
+    /**
+     * Returns @c true if the timer is running; otherwise returns @c false.
+     */
+    bool isActive() const;
+
+    /**
+     * Returns the deadline of the timer, or zero if the timer is not running.
+     */
+    std::chrono::nanoseconds deadline() const;
+
+Q_SIGNALS:
+    void timeout();
+
+private:
+    void handleTimerExpired();
+
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer m_fallbackTimer;
+    std::chrono::nanoseconds m_deadline = std::chrono::nanoseconds::zero();
+    bool m_active = false;
+};
+
+} // namespace KWin
@@ -0,0 +1,338 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "tileregion.h"
+
+#include <QtAlgorithms>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#  include <arm_neon.h>
+#endif
+
+namespace KWin
+{
+
+// The bitset is padded to a multiple of two words, so it can be processed 128 bits at a time.
+static int wordCount(int tileCount)
+{
+    const int words = (tileCount + 63) / 64;
+    return (words + 1) & ~1;
+}
+
+static int floorDiv(int value, int divisor)
+{
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static int ceilDiv(int value, int divisor)
+{
+    return -floorDiv(-value, divisor);
+}
+
+TileRegion::TileRegion(const QRect &bounds)
+    : m_bounds(bounds)
+    , m_columns(bounds.isEmpty() ? 0 : ceilDiv(bounds.width(), TileSize))
+    , m_rows(bounds.isEmpty() ? 0 : ceilDiv(bounds.height(), TileSize))
+    , m_words(wordCount(m_columns * m_rows), 0)
+{
+}
+
+TileRegion::TileRegion(const QRect &bounds, const QRegion &region, Rounding rounding)
+    : TileRegion(bounds)
+{
+    add(region, rounding);
+}
+
+QRect TileRegion::bounds() const
+{
+    return m_bounds;
+}
+
+int TileRegion::columnCount() const
+{
+    return m_columns;
+}
+
+int TileRegion::rowCount() const
+{
+    return m_rows;
+}
+
+bool TileRegion::isEmpty() const
+{
+    const quint64 *words = m_words.constData();
+    const int count = m_words.count();
+#if defined(__SSE2__)
+    __m128i accumulator = _mm_setzero_si128();
+    for (int i = 0; i < count; i += 2) {
+        accumulator = _mm_or_si128(accumulator, _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i)));
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(accumulator, _mm_setzero_si128())) == 0xffff;
+#elif defined(__ARM_NEON)
+    const uint64_t *a = reinterpret_cast<const uint64_t *>(words);
+    uint64x2_t accumulator = vdupq_n_u64(0);
+    for (int i = 0; i < count; i += 2) {
+        accumulator = vorrq_u64(accumulator, vld1q_u64(a + i));
+    }
+    return (vgetq_lane_u64(accumulator, 0) | vgetq_lane_u64(accumulator, 1)) == 0;
+#else
+    for (int i = 0; i < count; ++i) {
+        if (words[i]) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+int TileRegion::tileCount() const
+{
+    int count = 0;
+    for (const quint64 word : m_words) {
+        count += qPopulationCount(word);
+    }
+    return count;
+}
+
+bool TileRegion::containsTile(int column, int row) const
+{
+    if (column < 0 || column >= m_columns || row < 0 || row >= m_rows) {
+        return false;
+    }
+    const int index = row * m_columns + column;
+    return m_words[index / 64] & (quint64(1) << (index % 64));
+}
+
+void TileRegion::clear()
+{
+    m_words.fill(0);
+}
+
+void TileRegion::fill()
+{
+    setTiles(0, m_columns - 1, 0, m_rows - 1);
+}
+
+void TileRegion::setTiles(int firstColumn, int lastColumn, int firstRow, int lastRow)
+{
+    if (firstColumn > lastColumn || firstRow > lastRow) {
+        return;
+    }
+    quint64 *words = m_words.data();
+    for (int row = firstRow; row <= lastRow; ++row) {
+        const int first = row * m_columns + firstColumn;
+        const int last = row * m_columns + lastColumn;
+        const int firstWord = first / 64;
+        const int lastWord = last / 64;
+        const quint64 firstMask = ~quint64(0) << (first % 64);
+        const quint64 lastMask = ~quint64(0) >> (63 - last % 64);
+        if (firstWord == lastWord) {
+            words[firstWord] |= firstMask & lastMask;
+        } else {
+            words[firstWord] |= firstMask;
+            for (int i = firstWord + 1; i < lastWord; ++i) {
+                words[i] = ~quint64(0);
+            }
+            words[lastWord] |= lastMask;
+        }
+    }
+}
+
+void TileRegion::add(const QRect &rect, Rounding rounding)
+{
+    const QRect clipped = rect & m_bounds;
+    if (clipped.isEmpty()) {
+        return;
+    }
+
+    const int left = clipped.x() - m_bounds.x();
+    const int top = clipped.y() - m_bounds.y();
+    const int right = left + clipped.width();
+    const int bottom = top + clipped.height();
+
+    if (rounding == Rounding::Outward) {
+        setTiles(left / TileSize, (right - 1) / TileSize, top / TileSize, (bottom - 1) / TileSize);
+    } else {
+        // The tiles along the right and the bottom edge may extend past the bounds, they are
+        // fully covered if the rect reaches the edge of the bounds.
+        const int lastColumn = right == m_bounds.width() ? m_columns - 1 : right / TileSize - 1;
+        const int lastRow = bottom == m_bounds.height() ? m_rows - 1 : bottom / TileSize - 1;
+        setTiles(ceilDiv(left, TileSize), lastColumn, ceilDiv(top, TileSize), lastRow);
+    }
+}
+
+void TileRegion::add(const QRegion &region, Rounding rounding)
+{
+    for (const QRect &rect : region) {
+        add(rect, rounding);
+    }
+}
+
+QRegion TileRegion::toRegion() const
+{
+    // Rows with the same runs of tiles are merged, which keeps the resulting region small
+    // for the typical case of rectangular damage.
+    QVector<QRect> rects;
+    QVector<QRect> band;
+    QVector<QRect> previousBand;
+
+    auto flushBand = [&]() {
+        rects.append(previousBand);
+        previousBand.clear();
+    };
+
+    for (int row = 0; row < m_rows; ++row) {
+        band.clear();
+        int column = 0;
+        while (column < m_columns) {
+            if (!containsTile(column, row)) {
+                ++column;
+                continue;
+            }
+            const int start = column;
+            while (column < m_columns && containsTile(column, row)) {
+                ++column;
+            }
+            band.append(QRect(m_bounds.x() + start * TileSize, m_bounds.y() + row * TileSize,
+                              (column - start) * TileSize, TileSize) & m_bounds);
+        }
+
+        bool sameRuns = band.count() == previousBand.count();
+        for (int i = 0; sameRuns && i < band.count(); ++i) {
+            sameRuns = band[i].left() == previousBand[i].left() && band[i].right() == previousBand[i].right()
+                && previousBand[i].bottom() + 1 == band[i].top();
+        }
+        if (sameRuns) {
+            for (int i = 0; i < band.count(); ++i) {
+                previousBand[i].setBottom(band[i].bottom());
+            }
+        } else {
+            flushBand();
+            previousBand = band;
+        }
+    }
+    flushBand();
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.count());
+    return region;
+}
+
+TileRegion &TileRegion::operator|=(const TileRegion &other)
+{
+    Q_ASSERT(m_bounds == other.m_bounds);
+    quint64 *words = m_words.data();
+    const quint64 *otherWords = other.m_words.constData();
+    const int count = m_words.count();
+#if defined(__SSE2__)
+    for (int i = 0; i < count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(otherWords + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(words + i), _mm_or_si128(a, b));
+    }
+#elif defined(__ARM_NEON)
+    uint64_t *a = reinterpret_cast<uint64_t *>(words);
+    const uint64_t *b = reinterpret_cast<const uint64_t *>(otherWords);
+    for (int i = 0; i < count; i += 2) {
+        vst1q_u64(a + i, vorrq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+    }
+#else
+    for (int i = 0; i < count; ++i) {
+        words[i] |= otherWords[i];
+    }
+#endif
+    return *this;
+}
+
+TileRegion &TileRegion::operator-=(const TileRegion &other)
+{
+    Q_ASSERT(m_bounds == other.m_bounds);
+    quint64 *words = m_words.data();
+    const quint64 *otherWords = other.m_words.constData();
+    const int count = m_words.count();
+#if defined(__SSE2__)
+    for (int i = 0; i < count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(otherWords + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(words + i), _mm_andnot_si128(b, a));
+    }
+#elif defined(__ARM_NEON)
+    uint64_t *a = reinterpret_cast<uint64_t *>(words);
+    const uint64_t *b = reinterpret_cast<const uint64_t *>(otherWords);
+    for (int i = 0; i < count; i += 2) {
+        vst1q_u64(a + i, vbicq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+    }
+#else
+    for (int i = 0; i < count; ++i) {
+        words[i] &= ~otherWords[i];
+    }
+#endif
+    return *this;
+}
+
+TileRegion &TileRegion::operator&=(const TileRegion &other)
+{
+    Q_ASSERT(m_bounds == other.m_bounds);
+    quint64 *words = m_words.data();
+    const quint64 *otherWords = other.m_words.constData();
+    const int count = m_words.count();
+#if defined(__SSE2__)
+    for (int i = 0; i < count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(otherWords + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(words + i), _mm_and_si128(a, b));
+    }
+#elif defined(__ARM_NEON)
+    uint64_t *a = reinterpret_cast<uint64_t *>(words);
+    const uint64_t *b = reinterpret_cast<const uint64_t *>(otherWords);
+    for (int i = 0; i < count; i += 2) {
+        vst1q_u64(a + i, vandq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+    }
+#else
+    for (int i = 0; i < count; ++i) {
+        words[i] &= otherWords[i];
+    }
+#endif
+    return *this;
+}
+
+TileRegion TileRegion::operator|(const TileRegion &other) const
+{
+    TileRegion result = *this;
+    result |= other;
+    return result;
+}
+
+TileRegion TileRegion::operator-(const TileRegion &other) const
+{
+    TileRegion result = *this;
+    result -= other;
+    return result;
+}
+
+TileRegion TileRegion::operator&(const TileRegion &other) const
+{
+    TileRegion result = *this;
+    result &= other;
+    return result;
+}
+
+bool TileRegion::operator==(const TileRegion &other) const
+{
+    return m_bounds == other.m_bounds && m_words == other.m_words;
+}
+
+bool TileRegion::operator!=(const TileRegion &other) const
+{
+    return !(*this == other);
+}
+
+} // namespace KWin
@@ -0,0 +1,97 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * The TileRegion class represents a region as a bitset of fixed-size tiles.
+ *
+ * Unlike QRegion, whose cost of boolean operations grows with the number of rectangles,
+ * a TileRegion has a fixed size that only depends on its bounds. Union, subtraction and
+ * intersection are plain bitwise operations, which makes the TileRegion suitable for
+ * tracking damage and occlusion when there are many windows with fragmented damage.
+ *
+ * The price for that is precision. When a region is converted to tiles, it has to be
+ * rounded either outward, i.e. every tile touched by the region is included, which is
+ * what damage needs, or inward, i.e. only tiles that are fully covered by the region are
+ * included, which is what opaque regions need.
+ *
+ * Boolean operations can only be performed on tile regions with the same bounds.
+ */
+class KWIN_EXPORT TileRegion
+{
+public:
+    static constexpr int TileSize = 32;
+
+    enum class Rounding {
+        Outward,
+        Inward,
+    };
+
+    TileRegion() = default;
+    /**
+     * Constructs an empty tile region covering @a bounds.
+     */
+    explicit TileRegion(const QRect &bounds);
+    /**
+     * Constructs a tile region covering @a bounds with the tiles of @a region rounded
+     * according to @a rounding. Parts of the @a region outside @a bounds are dropped.
+     */
+    TileRegion(const QRect &bounds, const QRegion &region, Rounding rounding = Rounding::Outward);
+
+    QRect bounds() const;
+    int columnCount() const;
+    int rowCount() const;
+
+    bool isEmpty() const;
+    /**
+     * Returns the number of tiles in this region.
+     */
+    int tileCount() const;
+    bool containsTile(int column, int row) const;
+
+    void clear();
+    void fill();
+    void add(const QRect &rect, Rounding rounding = Rounding::Outward);
+    void add(const QRegion &region, Rounding rounding = Rounding::Outward);
+
+    /**
+     * Converts the tile region back to a QRegion. Tiles along the edges of the bounds are
+     * clipped to the bounds.
+     */
+    QRegion toRegion() const;
+
+    TileRegion &operator|=(const TileRegion &other);
+    TileRegion &operator-=(const TileRegion &other);
+    TileRegion &operator&=(const TileRegion &other);
+    TileRegion operator|(const TileRegion &other) const;
+    TileRegion operator-(const TileRegion &other) const;
+    TileRegion operator&(const TileRegion &other) const;
+    bool operator==(const TileRegion &other) const;
+    bool operator!=(const TileRegion &other) const;
+
+private:
+    void setTiles(int firstColumn, int lastColumn, int firstRow, int lastRow);
+
+    QRect m_bounds;
+    int m_columns = 0;
+    int m_rows = 0;
+    QVector<quint64> m_words;
+};
+
+} // namespace KWin
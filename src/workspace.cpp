@@ -1881,6 +1881,7 @@ void Workspace::markXStackingOrderAsDirty()
     if (kwinApp()->x11Connection() && !kwinApp()->isClosingX11Connection()) {
         m_xStackingQueryTree.reset(new Xcb::Tree(kwinApp()->x11RootWindow()));
     }
+    Q_EMIT xStackingOrderChanged();
 }
 
 void Workspace::setWasUserInteraction()
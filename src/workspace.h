@@ -524,6 +524,11 @@ Q_SIGNALS:
      * or lowered
      */
     void stackingOrderChanged();
+    /**
+     * This signal is emitted when the stacking order as seen by the compositor,
+     * see xStackingOrder(), has to be recomputed.
+     */
+    void xStackingOrderChanged();
 
     /**
      * This signal is emitted whenever an internal client is created.